@@ -332,6 +332,26 @@ SignondAsyncDBusProxy::~SignondAsyncDBusProxy()
 {
 }
 
+SignondAsyncDBusProxy *SignondAsyncDBusProxy::daemonProxy()
+{
+    static SignondAsyncDBusProxy *proxy = 0;
+
+    if (proxy == 0) {
+        proxy = new SignondAsyncDBusProxy(SIGNOND_DAEMON_INTERFACE_C, 0);
+        proxy->setParent(ConnectionManager::instance());
+        /* The object path is reset when the daemon goes away */
+        QObject::connect(proxy, SIGNAL(objectPathNeeded()),
+                         proxy, SLOT(setDaemonObjectPath()));
+        proxy->setDaemonObjectPath();
+    }
+    return proxy;
+}
+
+void SignondAsyncDBusProxy::setDaemonObjectPath()
+{
+    setObjectPath(QDBusObjectPath(SIGNOND_DAEMON_OBJECTPATH));
+}
+
 void SignondAsyncDBusProxy::setupConnection()
 {
     ConnectionManager *connManager = ConnectionManager::instance();
@@ -145,6 +145,13 @@ public:
                           QObject *clientObject);
     ~SignondAsyncDBusProxy();
 
+    /* The proxy for the daemon object, shared by the whole process. It has
+     * no client object: the receiver must be passed to queueCall(). */
+    static SignondAsyncDBusProxy *daemonProxy();
+
+private Q_SLOTS:
+    void setDaemonObjectPath();
+
 private:
     void setupConnection();
 };
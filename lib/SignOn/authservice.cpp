@@ -60,4 +60,10 @@ void AuthService::clear()
     impl->clear();
 }
 
+QList<Identity *> AuthService::existingIdentities(const QList<quint32> &ids,
+                                                  QObject *parent)
+{
+    return impl->existingIdentities(ids, parent);
+}
+
 } //namespace SignOn
@@ -38,6 +38,8 @@
 
 namespace SignOn {
 
+class Identity;
+
 /*!
  * @class AuthService
  * @headerfile authservice.h SignOn/AuthService
@@ -195,6 +197,22 @@ public:
      */
     void clear();
 
+    /*!
+     * Constructs the identity objects associated with several existing
+     * identity records, registering all of them with a single request to the
+     * service. This is equivalent to calling Identity::existingIdentity() for
+     * each ID, but much cheaper when many identities need to be opened.
+     * Identities which cannot be registered in the batch (for instance,
+     * because the application needs to be granted access to them) are
+     * registered one by one, as Identity::existingIdentity() does.
+     *
+     * @param ids Identity IDs on the service; IDs which are 0 are skipped
+     * @param parent Parent object of the identities
+     * @return The list of identity objects, in the same order as the IDs.
+     */
+    QList<Identity *> existingIdentities(const QList<quint32> &ids,
+                                         QObject *parent = 0);
+
 Q_SIGNALS:
 
     /*!
@@ -31,6 +31,8 @@
 #include "signond/signoncommon.h"
 
 #include "libsignoncommon.h"
+#include "identity.h"
+#include "identityimpl.h"
 #include "identityinfo.h"
 #include "identityinfoimpl.h"
 #include "authserviceimpl.h"
@@ -65,11 +67,9 @@ QString AuthService::IdentityRegExp::pattern() const
 AuthServiceImpl::AuthServiceImpl(AuthService *parent):
     QObject(parent),
     m_parent(parent),
-    m_dbusProxy(SIGNOND_DAEMON_INTERFACE_C,
-                this)
+    m_dbusProxy(SignondAsyncDBusProxy::daemonProxy())
 {
     TRACE();
-    m_dbusProxy.setObjectPath(QDBusObjectPath(SIGNOND_DAEMON_OBJECTPATH));
 
     qDBusRegisterMetaType<MapList>();
 }
@@ -87,10 +87,11 @@ void AuthServiceImpl::queryMethods()
 
 void AuthServiceImpl::queryMechanisms(const QString &method)
 {
-    m_dbusProxy.queueCall(QLatin1String("queryMechanisms"),
-                          QVariantList() << method,
-                          SLOT(queryMechanismsReply(QDBusPendingCallWatcher*)),
-                          SLOT(queryMechanismsError(const QDBusError&)));
+    m_dbusProxy->queueCall(QLatin1String("queryMechanisms"),
+                           QVariantList() << method,
+                           this,
+                           SLOT(queryMechanismsReply(QDBusPendingCallWatcher*)),
+                           SLOT(queryMechanismsError(const QDBusError&)));
     m_methodsForWhichMechsWereQueried.enqueue(method);
 }
 
@@ -139,15 +140,50 @@ void AuthServiceImpl::clear()
                 QList<QVariant>());
 }
 
+QList<Identity *>
+AuthServiceImpl::existingIdentities(const QList<quint32> &ids, QObject *parent)
+{
+    QList<Identity *> identities;
+    QList<QPointer<IdentityImpl> > pending;
+    QList<uint> idList;
+
+    foreach (quint32 id, ids) {
+        if (id == 0) continue;
+
+        Identity *identity = new Identity(id, parent, false);
+        identities.append(identity);
+        pending.append(identity->impl);
+        idList.append(id);
+    }
+
+    /* The service rejects longer lists */
+    const int sliceSize = SIGNOND_MAX_IDENTITIES_PER_CALL;
+    for (int i = 0; i < idList.count(); i += sliceSize) {
+        QDBusArgument idsArg;
+        idsArg << idList.mid(i, sliceSize);
+
+        PendingCall *call = m_dbusProxy->queueCall(
+                        QLatin1String("getIdentities"),
+                        QVariantList() << QVariant::fromValue(idsArg),
+                        this,
+                        SLOT(getIdentitiesReply(QDBusPendingCallWatcher*)),
+                        SLOT(getIdentitiesError(const QDBusError&)));
+        m_pendingIdentities.insert(call, pending.mid(i, sliceSize));
+    }
+
+    return identities;
+}
+
 
 
 void AuthServiceImpl::sendRequest(const QString &operation,
                                   const char *replySlot,
                                   const QList<QVariant> &args)
 {
-    m_dbusProxy.queueCall(operation, args,
-                          replySlot,
-                          SLOT(errorReply(const QDBusError&)));
+    m_dbusProxy->queueCall(operation, args,
+                           this,
+                           replySlot,
+                           SLOT(errorReply(const QDBusError&)));
 }
 
 void AuthServiceImpl::queryMethodsReply(QDBusPendingCallWatcher *call)
@@ -205,6 +241,48 @@ void AuthServiceImpl::clearReply()
     emit m_parent->cleared();
 }
 
+void AuthServiceImpl::getIdentitiesReply(QDBusPendingCallWatcher *call)
+{
+    QList<QPointer<IdentityImpl> > pending =
+        m_pendingIdentities.take(sender());
+
+    QList<QDBusObjectPath> objectPaths;
+    MapList identitiesData;
+    QList<QVariant> args = call->reply().arguments();
+    if (args.count() > 1) {
+        args[0].value<QDBusArgument>() >> objectPaths;
+        args[1].value<QDBusArgument>() >> identitiesData;
+    } else {
+        BLAME() << "Invalid reply: missing arguments";
+    }
+
+    for (int i = 0; i < pending.count(); i++) {
+        if (pending[i].isNull()) continue;
+
+        if (i < objectPaths.count() && i < identitiesData.count()) {
+            pending[i]->registrationFinished(objectPaths[i],
+                                             identitiesData[i]);
+        } else {
+            pending[i]->registrationFinished(QDBusObjectPath(),
+                                             QVariantMap());
+        }
+    }
+}
+
+void AuthServiceImpl::getIdentitiesError(const QDBusError &err)
+{
+    TRACE() << "getIdentities failed:" << err.name();
+
+    /* The service might not support the batch call: fall back to
+     * registering the identities one by one */
+    QList<QPointer<IdentityImpl> > pending =
+        m_pendingIdentities.take(sender());
+    foreach (const QPointer<IdentityImpl> &identity, pending) {
+        if (identity.isNull()) continue;
+        identity->registrationFinished(QDBusObjectPath(), QVariantMap());
+    }
+}
+
 void AuthServiceImpl::errorReply(const QDBusError &err)
 {
     TRACE();
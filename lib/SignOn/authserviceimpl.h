@@ -25,8 +25,10 @@
 #define AUTHSERVICEIMPL_H
 
 #include <QObject>
+#include <QHash>
 #include <QList>
 #include <QMap>
+#include <QPointer>
 #include <QString>
 #include <QStringList>
 #include <QVariant>
@@ -37,6 +39,7 @@
 
 namespace SignOn {
 
+class IdentityImpl;
 class IdentityInfo;
 
 typedef QList<QVariantMap> MapList;
@@ -62,6 +65,8 @@ public:
     void queryMechanisms(const QString &method);
     void queryIdentities(const AuthService::IdentityFilter &filter);
     void clear();
+    QList<Identity *> existingIdentities(const QList<quint32> &ids,
+                                         QObject *parent);
 
 public Q_SLOTS:
     void errorReply(const QDBusError &err);
@@ -70,6 +75,8 @@ public Q_SLOTS:
     void queryIdentitiesReply(QDBusPendingCallWatcher *call);
     void queryMethodsReply(QDBusPendingCallWatcher *call);
     void clearReply();
+    void getIdentitiesReply(QDBusPendingCallWatcher *call);
+    void getIdentitiesError(const QDBusError &err);
 
 private:
     void sendRequest(const QString &operation,
@@ -78,8 +85,11 @@ private:
 
 private:
     AuthService *m_parent;
-    SignondAsyncDBusProxy m_dbusProxy;
+    /* shared with the whole process */
+    SignondAsyncDBusProxy *m_dbusProxy;
     QQueue<QString> m_methodsForWhichMechsWereQueried;
+    /* identities waiting for the reply of a getIdentities call */
+    QHash<QObject *, QList<QPointer<IdentityImpl> > > m_pendingIdentities;
 };
 
 } // namespace SignOn
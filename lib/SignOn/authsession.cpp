@@ -64,10 +64,10 @@ void AuthSession::queryAvailableMechanisms(const QStringList &wantedMechanisms)
     impl->queryAvailableMechanisms(wantedMechanisms);
 }
 
-void AuthSession::process(const SessionData& sessionData,
-                          const QString &mechanism)
+int AuthSession::process(const SessionData& sessionData,
+                         const QString &mechanism)
 {
-    impl->process(sessionData, mechanism);
+    return impl->process(sessionData, mechanism);
 }
 
 void AuthSession::cancel()
@@ -75,4 +75,14 @@ void AuthSession::cancel()
     impl->cancel();
 }
 
+void AuthSession::setMaxPendingRequests(int count)
+{
+    impl->setMaxPendingRequests(count);
+}
+
+int AuthSession::maxPendingRequests() const
+{
+    return impl->maxPendingRequests();
+}
+
 } //namespace SignOn
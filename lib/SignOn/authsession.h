@@ -161,11 +161,20 @@ public:
      * @param sessionData Information for authentication session
      * @param mechanism Mechanism to use for authentication
      *
+     * Up to maxPendingRequests() requests can be outstanding at the same
+     * time; they are executed by the service in the order they were made.
+     * When the limit is reached, the error() signal is emitted with
+     * Error::type() Error::WrongState.
+     *
      * @see IdentityInfo
      * @see AuthPluginInterface
+     * @see AuthSession::processResponse()
+     * @return An identifier of the request, which is passed to the
+     * processResponse() and processError() signals, or 0 if the request
+     * could not be made.
      */
-    void process(const SessionData &sessionData,
-                 const QString &mechanism = QString());
+    int process(const SessionData &sessionData,
+                const QString &mechanism = QString());
 
     /*!
      * Sends a challenge to the authentication service.
@@ -209,10 +218,25 @@ public:
      * process is canceled.
      * If there is no challenge to cancel, Error::type() is Error::WrongState.
      * If the operation fails, the error() signal is emitted.
+     * All the outstanding requests are canceled.
      * @see AuthSession::error()
      */
     void cancel();
 
+    /*!
+     * Sets the maximum number of process() requests which can be
+     * outstanding at the same time on this session. The default is 1.
+     *
+     * @param count Maximum number of outstanding requests
+     */
+    void setMaxPendingRequests(int count);
+
+    /*!
+     * @return The maximum number of outstanding process() requests.
+     * @see setMaxPendingRequests()
+     */
+    int maxPendingRequests() const;
+
     /*!
      * Signs message by using secret stored into identity.
      * This convenience interface is to do special challenge to signature service.
@@ -261,6 +285,25 @@ Q_SIGNALS:
      */
     void response(const SignOn::SessionData &sessionData);
 
+    /*!
+     * Emitted together with response(), to tell which request the response
+     * belongs to.
+     *
+     * @param requestId The identifier returned by process()
+     * @param sessionData Parameters with the authentication token
+     */
+    void processResponse(int requestId,
+                         const SignOn::SessionData &sessionData);
+
+    /*!
+     * Emitted together with error() when a process() request fails, to tell
+     * which request the error belongs to.
+     *
+     * @param requestId The identifier returned by process()
+     * @param err The error object
+     */
+    void processError(int requestId, const SignOn::Error &err);
+
     /*!
      * Provides the information about the state of the authentication
      * request.
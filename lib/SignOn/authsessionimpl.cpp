@@ -51,7 +51,8 @@ AuthSessionImpl::AuthSessionImpl(AuthSession *parent,
     m_dbusProxy(SIGNOND_AUTH_SESSION_INTERFACE_C,
                 this),
     m_methodName(methodName),
-    m_processCall(0)
+    m_maxPendingRequests(1),
+    m_lastRequestId(0)
 {
     m_dbusProxy.connect("stateChanged", this,
                         SLOT(stateSlot(int, const QString&)));
@@ -101,17 +102,12 @@ bool AuthSessionImpl::initInterface()
     arguments += m_id;
     arguments += m_methodName;
 
-    SignondAsyncDBusProxy *authService =
-        new SignondAsyncDBusProxy(SIGNOND_DAEMON_INTERFACE_C, this);
-    authService->setObjectPath(QDBusObjectPath(SIGNOND_DAEMON_OBJECTPATH));
-
-    PendingCall *call =
-        authService->queueCall(operation,
-                               arguments,
-                               SLOT(authenticationSlot(QDBusPendingCallWatcher*)),
-                               SLOT(errorSlot(const QDBusError&)));
-    QObject::connect(call, SIGNAL(finished(QDBusPendingCallWatcher*)),
-                     this, SLOT(deleteServiceProxy()));
+    SignondAsyncDBusProxy::daemonProxy()->queueCall(
+                           operation,
+                           arguments,
+                           this,
+                           SLOT(authenticationSlot(QDBusPendingCallWatcher*)),
+                           SLOT(errorSlot(const QDBusError&)));
     return true;
 }
 
@@ -133,17 +129,30 @@ AuthSessionImpl::queryAvailableMechanisms(const QStringList &wantedMechanisms)
                    arguments);
 }
 
-void AuthSessionImpl::process(const SessionData &sessionData,
-                              const QString &mechanism)
+int AuthSessionImpl::takeProcessCall(QObject *call)
 {
-    if (m_processCall) {
+    QMap<int, QPointer<PendingCall> >::iterator i;
+    for (i = m_processCalls.begin(); i != m_processCalls.end(); ++i) {
+        if (i.value().data() == call) {
+            int requestId = i.key();
+            m_processCalls.erase(i);
+            return requestId;
+        }
+    }
+    return 0;
+}
+
+int AuthSessionImpl::process(const SessionData &sessionData,
+                             const QString &mechanism)
+{
+    if (m_processCalls.count() >= m_maxPendingRequests) {
         TRACE() << "AuthSession: client is busy";
 
         emit m_parent->error(
                 Error(Error::WrongState,
                       QString(QLatin1String("AuthSession(%1) is busy"))
                          .arg(m_methodName)));
-        return;
+        return 0;
     }
 
     QVariantMap sessionDataVa = sessionData2VariantMap(sessionData);
@@ -155,23 +164,54 @@ void AuthSessionImpl::process(const SessionData &sessionData,
 
     remoteFunctionName = QLatin1String("process");
 
-    m_processCall = send2interface(remoteFunctionName,
-                   SLOT(responseSlot(QDBusPendingCallWatcher*)), arguments);
+    /* Skip 0, which tells the caller that the request was not made */
+    if (++m_lastRequestId <= 0)
+        m_lastRequestId = 1;
+    int requestId = m_lastRequestId;
+
+    m_processCalls.insert(requestId, send2interface(remoteFunctionName,
+                   SLOT(responseSlot(QDBusPendingCallWatcher*)), arguments));
     Q_EMIT m_parent->stateChanged(AuthSession::ProcessPending,
                                   QLatin1String("The request is added "
                                                 "to queue."));
+    return requestId;
 }
 
 void AuthSessionImpl::cancel()
 {
-    if (m_processCall && m_processCall->cancel()) {
-        emit m_parent->error(Error(Error::SessionCanceled,
-                                   QLatin1String("Process is canceled.")));
-    } else {
+    if (m_processCalls.isEmpty()) {
         send2interface(QLatin1String("cancel"), 0, QVariantList());
+        return;
     }
 
-    m_processCall = 0;
+    /* Calls which have not been sent yet are dropped here; each of the
+     * others needs its own cancel request, and stays in m_processCalls
+     * until signond replies to it */
+    QMap<int, QPointer<PendingCall> > calls = m_processCalls;
+    QMap<int, QPointer<PendingCall> >::const_iterator i;
+    for (i = calls.constBegin(); i != calls.constEnd(); ++i) {
+        if (i.value().isNull()) {
+            m_processCalls.remove(i.key());
+        } else if (i.value()->cancel()) {
+            m_processCalls.remove(i.key());
+            Error err(Error::SessionCanceled,
+                      QLatin1String("Process is canceled."));
+            emit m_parent->error(err);
+            emit m_parent->processError(i.key(), err);
+        } else {
+            send2interface(QLatin1String("cancel"), 0, QVariantList());
+        }
+    }
+}
+
+void AuthSessionImpl::setMaxPendingRequests(int count)
+{
+    m_maxPendingRequests = qMax(count, 1);
+}
+
+int AuthSessionImpl::maxPendingRequests() const
+{
+    return m_maxPendingRequests;
 }
 
 void AuthSessionImpl::ignoreError(const QDBusError &err)
@@ -183,7 +223,7 @@ void AuthSessionImpl::errorSlot(const QDBusError &err)
 {
     TRACE() << err;
 
-    m_processCall = 0;
+    int requestId = takeProcessCall(sender());
     int errCode = Error::Unknown;
     QString errMessage;
 
@@ -255,7 +295,10 @@ void AuthSessionImpl::errorSlot(const QDBusError &err)
     if (errMessage.isEmpty())
         errMessage = err.message();
 
-    emit m_parent->error(Error(errCode, errMessage));
+    Error error(errCode, errMessage);
+    emit m_parent->error(error);
+    if (requestId != 0)
+        emit m_parent->processError(requestId, error);
 
 }
 
@@ -267,14 +310,6 @@ void AuthSessionImpl::authenticationSlot(QDBusPendingCallWatcher *call)
     m_isAuthInProcessing = false;
 }
 
-void AuthSessionImpl::deleteServiceProxy()
-{
-    PendingCall *call = qobject_cast<PendingCall*>(sender());
-    /* This destroys the AsyncDBusProxy which we created just for registering
-     * the authsession. */
-    call->parent()->deleteLater();
-}
-
 void AuthSessionImpl::mechanismsAvailableSlot(QDBusPendingCallWatcher *call)
 {
     QDBusPendingReply<QStringList> reply = *call;
@@ -284,11 +319,14 @@ void AuthSessionImpl::mechanismsAvailableSlot(QDBusPendingCallWatcher *call)
 
 void AuthSessionImpl::responseSlot(QDBusPendingCallWatcher *call)
 {
-    m_processCall = 0;
+    int requestId = takeProcessCall(sender());
 
     QDBusPendingReply<QVariantMap> reply = *call;
     QVariantMap sessionDataVa = reply.argumentAt<0>();
-    emit m_parent->response(SessionData(sessionDataVa));
+    SessionData sessionData(sessionDataVa);
+    emit m_parent->response(sessionData);
+    if (requestId != 0)
+        emit m_parent->processResponse(requestId, sessionData);
 }
 
 void AuthSessionImpl::stateSlot(int state, const QString &message)
@@ -62,15 +62,16 @@ public:
 public Q_SLOTS:
     QString name();
     void queryAvailableMechanisms(const QStringList &wantedMechanisms);
-    void process(const SessionData &sessionData, const QString &mechanism);
+    int process(const SessionData &sessionData, const QString &mechanism);
     void cancel();
+    void setMaxPendingRequests(int count);
+    int maxPendingRequests() const;
 
 private Q_SLOTS:
     bool initInterface();
     void ignoreError(const QDBusError &err);
     void errorSlot(const QDBusError &err);
     void authenticationSlot(QDBusPendingCallWatcher *call);
-    void deleteServiceProxy();
     void mechanismsAvailableSlot(QDBusPendingCallWatcher *call);
     void responseSlot(QDBusPendingCallWatcher *call);
     void stateSlot(int state, const QString &message);
@@ -81,6 +82,7 @@ private:
                                 const char *slot,
                                 const QVariantList &arguments);
     void setId(quint32 id);
+    int takeProcessCall(QObject *call);
 
 private:
     AuthSession *m_parent;
@@ -94,9 +96,11 @@ private:
     bool m_isAuthInProcessing;
 
     /*
-     * Handle to process operation
+     * Handles to the outstanding process operations, by request ID
      */
-    QPointer<PendingCall> m_processCall;
+    QMap<int, QPointer<PendingCall> > m_processCalls;
+    int m_maxPendingRequests;
+    int m_lastRequestId;
 };
 
 } //namespace SignOn
@@ -26,8 +26,7 @@
 
 namespace SignOn {
 
-Identity::Identity(const quint32 id, QObject *parent):
-    QObject(parent)
+static void registerErrorMetaType()
 {
     qRegisterMetaType<Error>("SignOn::Error");
     qRegisterMetaType<Error>("Error");
@@ -35,10 +34,22 @@ Identity::Identity(const quint32 id, QObject *parent):
     if (qMetaTypeId<Error>() < QMetaType::User)
         BLAME() << "Identity::Identity() - "
             "SignOn::Error meta type not registered.";
+}
 
+Identity::Identity(const quint32 id, QObject *parent):
+    QObject(parent)
+{
+    registerErrorMetaType();
     impl = new IdentityImpl(this, id);
 }
 
+Identity::Identity(const quint32 id, QObject *parent, bool registerNow):
+    QObject(parent)
+{
+    registerErrorMetaType();
+    impl = new IdentityImpl(this, id, registerNow);
+}
+
 Identity *Identity::newIdentity(const IdentityInfo &info, QObject *parent)
 {
     Identity *identity = new Identity(SSO_NEW_IDENTITY, parent);
@@ -60,6 +60,7 @@ class SIGNON_EXPORT Identity: public QObject
     Q_DISABLE_COPY(Identity)
 
     friend class IdentityImpl;
+    friend class AuthServiceImpl;
 
 public:
     /*!
@@ -388,6 +389,13 @@ Q_SIGNALS:
     void removed();
 
 private:
+    /*!
+     * @internal
+     * Creates an identity whose registration with the service is done by
+     * the caller.
+     */
+    Identity(const quint32 id, QObject *parent, bool registerNow);
+
     class IdentityImpl *impl;
 };
 
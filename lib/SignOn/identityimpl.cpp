@@ -26,6 +26,8 @@
 #include <QByteArray>
 #include <QDBusArgument>
 #include <QDBusPendingReply>
+#include <QHash>
+#include <QPointer>
 #include <QTimer>
 
 #include "signond/signoncommon.h"
@@ -57,7 +59,34 @@ static QString stateName(IdentityImpl::State state)
                          stateNames[state] : "Unknown");
 }
 
-IdentityImpl::IdentityImpl(Identity *parent, const quint32 id):
+namespace {
+
+/* The identity data last received from signond, shared by all the Identity
+ * objects of this process which refer to the same identity. Only one getInfo
+ * call per identity is in flight at any time: the other objects wait for its
+ * reply. */
+struct SharedInfo {
+    SharedInfo(): isValid(false), generation(0), fetcher(0), users(0) {}
+
+    QVariantMap data;
+    bool isValid;
+    /* incremented whenever the info is invalidated, so that a reply which
+     * was already in flight at that time is not taken as valid */
+    quint32 generation;
+    IdentityImpl *fetcher;
+    /* the number of objects using this entry; when it drops to 0, the
+     * entry is removed */
+    int users;
+    QList<QPointer<IdentityImpl> > waiters;
+};
+
+} // namespace
+
+typedef QHash<quint32, SharedInfo> SharedInfoHash;
+Q_GLOBAL_STATIC(SharedInfoHash, sharedInfos)
+
+IdentityImpl::IdentityImpl(Identity *parent, const quint32 id,
+                           bool registerNow):
     QObject(parent),
     m_parent(parent),
     m_identityInfo(new IdentityInfo),
@@ -67,7 +96,9 @@ IdentityImpl::IdentityImpl(Identity *parent, const quint32 id):
     m_state(NeedsRegistration),
     m_infoQueried(true),
     m_methodsQueried(false),
-    m_signOutRequestedByThisIdentity(false)
+    m_signOutRequestedByThisIdentity(false),
+    m_sharedInfoId(SIGNOND_NEW_IDENTITY),
+    m_fetchGeneration(0)
 {
     m_dbusProxy.connect("infoUpdated", this, SLOT(infoUpdated(int)));
     m_dbusProxy.connect("unregistered", this, SLOT(remoteObjectDestroyed()));
@@ -75,11 +106,27 @@ IdentityImpl::IdentityImpl(Identity *parent, const quint32 id):
                      this, SLOT(sendRegisterRequest()));
 
     m_identityInfo->setId(id);
-    sendRegisterRequest();
+    if (registerNow)
+        sendRegisterRequest();
+    else
+        updateState(PendingRegistration);
 }
 
 IdentityImpl::~IdentityImpl()
 {
+    /* Let another object fetch the data for the ones waiting on us */
+    SharedInfoHash::iterator i = sharedInfos()->find(id());
+    if (i != sharedInfos()->end() && i.value().fetcher == this) {
+        QList<QPointer<IdentityImpl> > waiters = i.value().waiters;
+        i.value().fetcher = 0;
+        i.value().waiters.clear();
+        foreach (const QPointer<IdentityImpl> &waiter, waiters) {
+            if (!waiter.isNull() && waiter != this)
+                waiter->updateState(NeedsUpdate);
+        }
+    }
+    releaseSharedInfo();
+
     if (m_identityInfo)
         delete m_identityInfo;
 
@@ -359,6 +406,7 @@ void IdentityImpl::storeCredentialsReply(QDBusPendingCallWatcher *call)
 
 void IdentityImpl::removeReply()
 {
+    invalidateSharedInfo();
     m_identityInfo->impl->clear();
     updateState(Removed);
     emit m_parent->removed();
@@ -379,8 +427,53 @@ void IdentityImpl::getInfoReply(QDBusPendingCallWatcher *call)
     QDBusPendingReply<QVariantMap> reply = *call;
     QVariantMap infoData = reply.argumentAt<0>();
     TRACE() << infoData;
+
+    /* signond can send the reply after notifying a change which happened
+     * while reading the info: the data might be outdated then */
+    SharedInfoHash::iterator i = sharedInfos()->find(id());
+    if (i != sharedInfos()->end() &&
+        i.value().generation != m_fetchGeneration) {
+        TRACE() << "Info of" << id() << "changed meanwhile, fetching again";
+        SharedInfo &shared = i.value();
+        if (shared.fetcher == 0 || shared.fetcher == this) {
+            shared.fetcher = this;
+            fetchInfo();
+        } else {
+            QPointer<IdentityImpl> self(this);
+            if (!shared.waiters.contains(self))
+                shared.waiters.append(self);
+        }
+        return;
+    }
+
+    storeSharedInfo(infoData);
+
+    QList<QPointer<IdentityImpl> > waiters = takeWaiters();
+    applyInfo(infoData);
+    foreach (const QPointer<IdentityImpl> &waiter, waiters) {
+        if (!waiter.isNull())
+            waiter->applyInfo(infoData);
+    }
+}
+
+void IdentityImpl::getInfoError(const QDBusError &err)
+{
+    /* The objects waiting for this reply will each retry on their own */
+    QList<QPointer<IdentityImpl> > waiters = takeWaiters();
+    errorReply(err);
+    foreach (const QPointer<IdentityImpl> &waiter, waiters) {
+        if (!waiter.isNull())
+            waiter->updateState(NeedsUpdate);
+    }
+}
+
+void IdentityImpl::applyInfo(const QVariantMap &infoData)
+{
     updateCachedData(infoData);
-    updateState(Ready);
+    /* If the registration is still pending the state must not change,
+     * otherwise the object path would never be set */
+    if (m_state == PendingUpdate || m_state == NeedsUpdate)
+        updateState(Ready);
 
     if (m_infoQueried) {
         Q_EMIT m_parent->info(IdentityInfo(*m_identityInfo));
@@ -418,11 +511,13 @@ void IdentityImpl::infoUpdated(int state)
     switch ((IdentityState)state) {
     /* Data updated on the server side. */
     case IdentityDataUpdated:
+        invalidateSharedInfo();
         updateState(NeedsUpdate);
         stateStr = "NeedsUpdate";
         break;
     /* Data removed on the server side. */
     case IdentityRemoved:
+        invalidateSharedInfo();
         updateState(Removed);
         stateStr = "Removed";
         break;
@@ -512,11 +607,97 @@ void IdentityImpl::errorReply(const QDBusError& err)
 
 void IdentityImpl::updateContents()
 {
+    if (id() != SIGNOND_NEW_IDENTITY) {
+        acquireSharedInfo();
+        SharedInfo &shared = (*sharedInfos())[id()];
+        if (shared.isValid) {
+            TRACE() << "Using shared info for" << id();
+            applyInfo(shared.data);
+            return;
+        }
+
+        /* If our own call is in flight, its reply will be checked */
+        if (shared.fetcher == this) {
+            updateState(PendingUpdate);
+            return;
+        }
+
+        if (shared.fetcher != 0) {
+            QPointer<IdentityImpl> self(this);
+            if (!shared.waiters.contains(self))
+                shared.waiters.append(self);
+            updateState(PendingUpdate);
+            return;
+        }
+        shared.fetcher = this;
+    }
+
+    fetchInfo();
+    updateState(PendingUpdate);
+}
+
+void IdentityImpl::fetchInfo()
+{
+    SharedInfoHash::const_iterator i = sharedInfos()->constFind(id());
+    m_fetchGeneration = (i != sharedInfos()->constEnd()) ?
+        i.value().generation : 0;
+
     m_dbusProxy.queueCall(QLatin1String("getInfo"),
                           QVariantList(),
                           SLOT(getInfoReply(QDBusPendingCallWatcher*)),
-                          SLOT(errorReply(const QDBusError&)));
-    updateState(PendingUpdate);
+                          SLOT(getInfoError(const QDBusError&)));
+}
+
+void IdentityImpl::acquireSharedInfo()
+{
+    if (m_sharedInfoId == id()) return;
+
+    releaseSharedInfo();
+    if (id() == SIGNOND_NEW_IDENTITY) return;
+
+    (*sharedInfos())[id()].users++;
+    m_sharedInfoId = id();
+}
+
+void IdentityImpl::releaseSharedInfo()
+{
+    if (m_sharedInfoId == SIGNOND_NEW_IDENTITY) return;
+
+    SharedInfoHash::iterator i = sharedInfos()->find(m_sharedInfoId);
+    if (i != sharedInfos()->end() && --i.value().users <= 0)
+        sharedInfos()->erase(i);
+    m_sharedInfoId = SIGNOND_NEW_IDENTITY;
+}
+
+void IdentityImpl::storeSharedInfo(const QVariantMap &infoData)
+{
+    if (id() == SIGNOND_NEW_IDENTITY) return;
+
+    acquireSharedInfo();
+    SharedInfo &shared = (*sharedInfos())[id()];
+    shared.data = infoData;
+    shared.isValid = true;
+}
+
+void IdentityImpl::invalidateSharedInfo()
+{
+    SharedInfoHash::iterator i = sharedInfos()->find(id());
+    if (i != sharedInfos()->end()) {
+        i.value().isValid = false;
+        i.value().generation++;
+    }
+}
+
+QList<QPointer<IdentityImpl> > IdentityImpl::takeWaiters()
+{
+    QList<QPointer<IdentityImpl> > waiters;
+    SharedInfoHash::iterator i = sharedInfos()->find(id());
+    if (i != sharedInfos()->end() && i.value().fetcher == this) {
+        waiters = i.value().waiters;
+        i.value().fetcher = 0;
+        i.value().waiters.clear();
+    }
+    return waiters;
 }
 
 bool IdentityImpl::sendRegisterRequest()
@@ -531,17 +712,12 @@ bool IdentityImpl::sendRegisterRequest()
         args << m_identityInfo->id();
     }
 
-    SignondAsyncDBusProxy *authService =
-        new SignondAsyncDBusProxy(SIGNOND_DAEMON_INTERFACE_C, this);
-    authService->setObjectPath(QDBusObjectPath(SIGNOND_DAEMON_OBJECTPATH));
-
-    PendingCall *call =
-        authService->queueCall(registerMethodName,
-                               args,
-                               SLOT(registerReply(QDBusPendingCallWatcher*)),
-                               SLOT(errorReply(const QDBusError&)));
-    QObject::connect(call, SIGNAL(finished(QDBusPendingCallWatcher*)),
-                     this, SLOT(deleteServiceProxy()));
+    SignondAsyncDBusProxy::daemonProxy()->queueCall(
+                           registerMethodName,
+                           args,
+                           this,
+                           SLOT(registerReply(QDBusPendingCallWatcher*)),
+                           SLOT(errorReply(const QDBusError&)));
     updateState(PendingRegistration);
     return true;
 }
@@ -556,24 +732,39 @@ void IdentityImpl::registerReply(QDBusPendingCallWatcher *call)
     QVariantList arguments = call->reply().arguments();
     if (arguments.count() > 1) {
         QDBusArgument info = arguments.at(1).value<QDBusArgument>();
-        updateCachedData(qdbus_cast<QVariantMap>(info));
+        QVariantMap infoData = qdbus_cast<QVariantMap>(info);
+        updateCachedData(infoData);
+        storeSharedInfo(infoData);
     }
 
     m_dbusProxy.setObjectPath(arguments.at(0).value<QDBusObjectPath>());
     updateState(Ready);
 }
 
-void IdentityImpl::deleteServiceProxy()
+void IdentityImpl::registrationFinished(const QDBusObjectPath &objectPath,
+                                        const QVariantMap &infoData)
 {
-    PendingCall *call = qobject_cast<PendingCall*>(sender());
-    /* This destroys the AsyncDBusProxy which we created just for registering
-     * the identity. */
-    call->parent()->deleteLater();
+    /* An empty path means that the identity could not be registered as part
+     * of a batch: register it on its own */
+    if (objectPath.path().isEmpty() ||
+        objectPath.path() == QLatin1String("/")) {
+        updateState(NeedsRegistration);
+        sendRegisterRequest();
+        return;
+    }
+
+    updateCachedData(infoData);
+    storeSharedInfo(infoData);
+    m_dbusProxy.setObjectPath(objectPath);
+    updateState(Ready);
 }
 
 void IdentityImpl::remoteObjectDestroyed()
 {
     TRACE();
+    /* No change notifications arrive until the identity is registered
+     * again */
+    invalidateSharedInfo();
     m_dbusProxy.setObjectPath(QDBusObjectPath());
     updateState(NeedsRegistration);
 }
@@ -31,6 +31,7 @@
 #include <QStringList>
 #include <QVariant>
 #include <QMetaMethod>
+#include <QPointer>
 #include <QQueue>
 #include <QDBusObjectPath>
 
@@ -54,6 +55,7 @@ class IdentityImpl: public QObject
     Q_DISABLE_COPY(IdentityImpl)
 
     friend class Identity;
+    friend class AuthServiceImpl;
 
 public:
     enum State {
@@ -68,7 +70,8 @@ public:
     };
 
     IdentityImpl(Identity *parent,
-                 const quint32 id = 0);
+                 const quint32 id = 0,
+                 bool registerNow = true);
     ~IdentityImpl();
 
     quint32 id() const;
@@ -82,6 +85,7 @@ public Q_SLOTS:
     void addReferenceReply();
     void removeReferenceReply();
     void getInfoReply(QDBusPendingCallWatcher *call);
+    void getInfoError(const QDBusError &err);
     void verifyUserReply(QDBusPendingCallWatcher *call);
     void verifySecretReply(QDBusPendingCallWatcher *call);
     void signOutReply();
@@ -103,7 +107,8 @@ private Q_SLOTS:
     void signOut();
     void authSessionCancelReply(const SignOn::Error &err);
     void registerReply(QDBusPendingCallWatcher *call);
-    void deleteServiceProxy();
+    void registrationFinished(const QDBusObjectPath &objectPath,
+                              const QVariantMap &infoData);
 
 private:
     void copyInfo(const IdentityInfo &info);
@@ -111,7 +116,14 @@ private:
     bool checkRemoved();
 
     void updateContents();
+    void fetchInfo();
     void updateCachedData(const QVariantMap &infoData);
+    void applyInfo(const QVariantMap &infoData);
+    void acquireSharedInfo();
+    void releaseSharedInfo();
+    void storeSharedInfo(const QVariantMap &infoData);
+    void invalidateSharedInfo();
+    QList<QPointer<IdentityImpl> > takeWaiters();
     void clearAuthSessionsCache();
 
 private:
@@ -135,6 +147,12 @@ private:
 
     /* Marks this Identity as the one which requested the sign out */
     bool m_signOutRequestedByThisIdentity;
+
+    /* The id whose shared info is being used by this object */
+    quint32 m_sharedInfoId;
+
+    /* The generation of the shared info when getInfo was last called */
+    quint32 m_fetchGeneration;
 };
 
 }  // namespace SignOn
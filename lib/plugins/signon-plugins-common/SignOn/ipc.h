@@ -45,6 +45,7 @@ enum PluginResponse {
     PLUGIN_RESPONSE_SIGNAL,
     PLUGIN_RESPONSE_UI,
     PLUGIN_RESPONSE_REFRESHED,
+    PLUGIN_RESPONSE_TIMING,
     PLUGIN_RESPONSE_LAST
 };
 
@@ -42,6 +42,7 @@ private:
     Key m_encryptionKey;
     bool m_fileSystemIsSetup;
     bool m_fileSystemIsMounted;
+    bool m_fileSystemIsMounting;
 };
 };
 
@@ -49,7 +50,8 @@ AbstractCryptoManagerPrivate::AbstractCryptoManagerPrivate(
     AbstractCryptoManager *cryptoManager):
     q_ptr(cryptoManager),
     m_fileSystemIsSetup(false),
-    m_fileSystemIsMounted(false)
+    m_fileSystemIsMounted(false),
+    m_fileSystemIsMounting(false)
 {
 }
 
@@ -119,6 +121,11 @@ bool AbstractCryptoManager::fileSystemIsMounted() const
     return d_ptr->m_fileSystemIsMounted;
 }
 
+bool AbstractCryptoManager::fileSystemIsMounting() const
+{
+    return d_ptr->m_fileSystemIsMounting;
+}
+
 QString AbstractCryptoManager::fileSystemMountPath() const
 {
     return QString();
@@ -165,6 +172,17 @@ void AbstractCryptoManager::setFileSystemMounted(bool isMounted)
     }
 }
 
+void AbstractCryptoManager::setFileSystemMounting(bool isMounting)
+{
+    Q_D(AbstractCryptoManager);
+    if (isMounting != d->m_fileSystemIsMounting) {
+        d->m_fileSystemIsMounting = isMounting;
+        if (!isMounting) {
+            Q_EMIT fileSystemMountFinished();
+        }
+    }
+}
+
 void AbstractCryptoManager::setFileSystemSetup(bool isSetup)
 {
     Q_D(AbstractCryptoManager);
@@ -122,6 +122,12 @@ public:
      */
     bool fileSystemIsMounted() const;
 
+    /*!
+     * @returns true if the file system is being mounted asynchronously; the
+     * fileSystemMountFinished() signal is emitted when done.
+     */
+    bool fileSystemIsMounting() const;
+
     /*!
      * @returns the path of the mounted file system.
      */
@@ -134,7 +140,10 @@ public:
 
     /*!
      * @attention if the file system is not mounted and the encryption key can
-     * access it, this method will cause the file system to be mounted.
+     * access it, this method will cause the file system to be mounted. If
+     * the mount is asynchronous, false is returned while
+     * fileSystemIsMounting(): the key must be checked again once the mount
+     * has finished.
      * @returns whether the key @key is occupying a keyslot in the encrypted
      * file system.
      */
@@ -143,6 +152,8 @@ public:
     /*!
      * Adds an encryption key to one of the available keyslots of the LUKS
      * partition's header.
+     * If the file system is being mounted, this method must wait for the
+     * mount to finish.
      * @sa encryptionKeyInUse()
      * @param key The key to be added/set.
      * @param existingKey An already existing key.
@@ -156,6 +167,8 @@ public:
      * @param key The key to be removed.
      * @param remainingKey Another valid key
      * @attention The system cannot remain keyless.
+     * If the file system is being mounted, this method must wait for the
+     * mount to finish.
      * @returns true if succeeded, false otherwise.
     */
     virtual bool removeEncryptionKey(const SignOn::Key &key,
@@ -164,9 +177,11 @@ public:
 Q_SIGNALS:
     void fileSystemMounted();
     void fileSystemUnmounting();
+    void fileSystemMountFinished();
 
 protected:
     void setFileSystemMounted(bool isMounted);
+    void setFileSystemMounting(bool isMounting);
     void setFileSystemSetup(bool isSetup);
 
 private:
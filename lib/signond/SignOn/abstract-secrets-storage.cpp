@@ -28,6 +28,25 @@ using namespace SignOn;
 
 namespace SignOn {
 
+class SecretsReplyPrivate
+{
+    Q_DECLARE_PUBLIC(SecretsReply)
+
+public:
+    SecretsReplyPrivate(SecretsReply *reply, quint32 id, quint32 method);
+    ~SecretsReplyPrivate() {};
+
+private:
+    mutable SecretsReply *q_ptr;
+    quint32 m_id;
+    quint32 m_method;
+    bool m_isFinished;
+    QString m_username;
+    QString m_password;
+    QVariantMap m_data;
+    CredentialsDBError m_error;
+};
+
 class AbstractSecretsStoragePrivate
 {
     Q_DECLARE_PUBLIC(AbstractSecretsStorage)
@@ -43,6 +62,96 @@ private:
 };
 };
 
+SecretsReplyPrivate::SecretsReplyPrivate(SecretsReply *reply,
+                                         quint32 id, quint32 method):
+    q_ptr(reply),
+    m_id(id),
+    m_method(method),
+    m_isFinished(false)
+{
+}
+
+SecretsReply::SecretsReply(quint32 id, quint32 method, QObject *parent):
+    QObject(parent),
+    d_ptr(new SecretsReplyPrivate(this, id, method))
+{
+}
+
+SecretsReply::~SecretsReply()
+{
+    delete d_ptr;
+}
+
+quint32 SecretsReply::id() const
+{
+    Q_D(const SecretsReply);
+    return d->m_id;
+}
+
+quint32 SecretsReply::method() const
+{
+    Q_D(const SecretsReply);
+    return d->m_method;
+}
+
+bool SecretsReply::isFinished() const
+{
+    Q_D(const SecretsReply);
+    return d->m_isFinished;
+}
+
+QString SecretsReply::username() const
+{
+    Q_D(const SecretsReply);
+    return d->m_username;
+}
+
+QString SecretsReply::password() const
+{
+    Q_D(const SecretsReply);
+    return d->m_password;
+}
+
+QVariantMap SecretsReply::data() const
+{
+    Q_D(const SecretsReply);
+    return d->m_data;
+}
+
+CredentialsDBError SecretsReply::error() const
+{
+    Q_D(const SecretsReply);
+    return d->m_error;
+}
+
+void SecretsReply::setCredentials(const QString &username,
+                                  const QString &password)
+{
+    Q_D(SecretsReply);
+    d->m_username = username;
+    d->m_password = password;
+}
+
+void SecretsReply::setData(const QVariantMap &data)
+{
+    Q_D(SecretsReply);
+    d->m_data = data;
+}
+
+void SecretsReply::setError(const CredentialsDBError &error)
+{
+    Q_D(SecretsReply);
+    d->m_error = error;
+}
+
+void SecretsReply::finish()
+{
+    Q_D(SecretsReply);
+    if (d->m_isFinished) return;
+    d->m_isFinished = true;
+    Q_EMIT finished();
+}
+
 AbstractSecretsStoragePrivate::AbstractSecretsStoragePrivate(
     AbstractSecretsStorage *secretsStorage):
     q_ptr(secretsStorage),
@@ -84,6 +193,61 @@ bool AbstractSecretsStorage::checkPassword(const quint32 id,
     return storedUsername == username && storedPassword == password;
 }
 
+bool AbstractSecretsStorage::updateCredentialsBatch(
+    const QList<SecretsCredentials> &items)
+{
+    foreach (const SecretsCredentials &item, items) {
+        if (!updateCredentials(item.id, item.username, item.password))
+            return false;
+    }
+    return true;
+}
+
+bool AbstractSecretsStorage::loadDataBatch(QList<SecretsData> &items)
+{
+    QList<SecretsData>::iterator i;
+    for (i = items.begin(); i != items.end(); ++i) {
+        i->data = loadData(i->id, i->method);
+        if (lastError().isValid())
+            return false;
+    }
+    return true;
+}
+
+bool AbstractSecretsStorage::storeDataBatch(const QList<SecretsData> &items)
+{
+    foreach (const SecretsData &item, items) {
+        if (!storeData(item.id, item.method, item.data))
+            return false;
+    }
+    return true;
+}
+
+SecretsReply *AbstractSecretsStorage::loadCredentialsAsync(quint32 id)
+{
+    /* The default implementation loads the credentials right away */
+    SecretsReply *reply = new SecretsReply(id, 0, this);
+    QString username, password;
+    clearError();
+    if (loadCredentials(id, username, password))
+        reply->setCredentials(username, password);
+    reply->setError(lastError());
+    QMetaObject::invokeMethod(reply, "finish", Qt::QueuedConnection);
+    return reply;
+}
+
+SecretsReply *AbstractSecretsStorage::loadDataAsync(quint32 id,
+                                                    quint32 method)
+{
+    /* The default implementation loads the data right away */
+    SecretsReply *reply = new SecretsReply(id, method, this);
+    clearError();
+    reply->setData(loadData(id, method));
+    reply->setError(lastError());
+    QMetaObject::invokeMethod(reply, "finish", Qt::QueuedConnection);
+    return reply;
+}
+
 CredentialsDBError AbstractSecretsStorage::lastError() const
 {
     return d_ptr->m_lastError;
@@ -26,6 +26,7 @@
 
 #include <SignOn/export.h>
 
+#include <QList>
 #include <QObject>
 #include <QVariantMap>
 
@@ -60,6 +61,104 @@ private:
     ErrorType m_type;
 };
 
+/*!
+ * @class SecretsCredentials
+ * The username and password of an identity, as passed to
+ * AbstractSecretsStorage::updateCredentialsBatch().
+ */
+class SecretsCredentials
+{
+public:
+    SecretsCredentials(quint32 id = 0,
+                       const QString &username = QString(),
+                       const QString &password = QString()):
+        id(id), username(username), password(password) {}
+
+    quint32 id;
+    QString username;
+    QString password;
+};
+
+/*!
+ * @class SecretsData
+ * The extra secret data of an identity for one authentication method, as
+ * passed to AbstractSecretsStorage::storeDataBatch() and
+ * AbstractSecretsStorage::loadDataBatch().
+ */
+class SecretsData
+{
+public:
+    SecretsData(quint32 id = 0, quint32 method = 0,
+                const QVariantMap &data = QVariantMap()):
+        id(id), method(method), data(data) {}
+
+    quint32 id;
+    quint32 method;
+    QVariantMap data;
+};
+
+class SecretsReplyPrivate;
+
+/*!
+ * @class SecretsReply
+ * @headerfile SignOn/abstract-secrets-storage.h SignOn/AbstractSecretsStorage
+ * @brief Asynchronous reply to a secrets loading request.
+ *
+ * Storage implementations which can load the secrets without blocking
+ * subclass this, and call finish() once the secrets are available. The
+ * finished() signal must not be emitted before the method which created the
+ * reply has returned.
+ * The reply is owned by the caller, who is responsible for deleting it.
+ */
+class SIGNON_EXPORT SecretsReply: public QObject
+{
+    Q_OBJECT
+
+public:
+    ~SecretsReply();
+
+    /*!
+     * @returns the identity whose secrets are being loaded.
+     */
+    quint32 id() const;
+
+    /*!
+     * @returns the authentication method whose data is being loaded, or 0 if
+     * the reply is about the username and password.
+     */
+    quint32 method() const;
+
+    bool isFinished() const;
+
+    QString username() const;
+    QString password() const;
+    QVariantMap data() const;
+
+    /*!
+     * @returns the error occurred while loading the secrets; the error is
+     * not valid if the secrets were loaded, or if there were none.
+     */
+    CredentialsDBError error() const;
+
+Q_SIGNALS:
+    void finished();
+
+protected:
+    explicit SecretsReply(quint32 id, quint32 method, QObject *parent = 0);
+
+    void setCredentials(const QString &username, const QString &password);
+    void setData(const QVariantMap &data);
+    void setError(const CredentialsDBError &error);
+
+protected Q_SLOTS:
+    void finish();
+
+private:
+    friend class AbstractSecretsStorage;
+    SecretsReplyPrivate *d_ptr;
+    Q_DECLARE_PRIVATE(SecretsReply)
+};
+
 class AbstractSecretsStoragePrivate;
 
 /*!
@@ -168,6 +267,57 @@ public:
      */
     virtual bool removeData(quint32 id, quint32 method) = 0;
 
+    /*!
+     * Stores/updates the credentials of several identities.
+     * The default implementation calls updateCredentials() for each item,
+     * and stops at the first failure; implementations should reimplement it
+     * to store all the items in one go (for instance, in a single database
+     * transaction).
+     * @param items the credentials to be stored.
+     * @returns true if all the items were stored, false otherwise.
+     */
+    virtual bool updateCredentialsBatch(const QList<SecretsCredentials> &items);
+
+    /*!
+     * Loads the extra secret data of several identity/method pairs.
+     * The default implementation calls loadData() for each item.
+     * @param items the identity/method pairs; on return, the data field of
+     * each item holds the loaded data.
+     * @returns true if successful, false otherwise.
+     */
+    virtual bool loadDataBatch(QList<SecretsData> &items);
+
+    /*!
+     * Stores extra secret data for several identity/method pairs, replacing
+     * any data previously stored for them.
+     * The default implementation calls storeData() for each item, and stops
+     * at the first failure; implementations should reimplement it to store
+     * all the items in one go.
+     * @param items the data to be stored.
+     * @returns true if all the items were stored, false otherwise.
+     */
+    virtual bool storeDataBatch(const QList<SecretsData> &items);
+
+    /*!
+     * Asynchronous variant of loadCredentials(), for implementations whose
+     * backend can block for a long time.
+     * The default implementation calls loadCredentials() and returns a
+     * reply which emits finished() at the next iteration of the main loop.
+     * @param id the identity whose credentials are being loaded.
+     * @returns a SecretsReply, owned by the caller.
+     */
+    virtual SecretsReply *loadCredentialsAsync(quint32 id);
+
+    /*!
+     * Asynchronous variant of loadData().
+     * The default implementation calls loadData() and returns a reply which
+     * emits finished() at the next iteration of the main loop.
+     * @param id the identity whose data are being loaded.
+     * @param method the authentication method the data is used for.
+     * @returns a SecretsReply, owned by the caller.
+     */
+    virtual SecretsReply *loadDataAsync(quint32 id, quint32 method);
+
     /*!
      * Get the last error.
      */
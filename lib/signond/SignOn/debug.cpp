@@ -25,13 +25,74 @@
 using namespace SignOn;
 
 SIGNON_EXPORT int signonLoggingLevel = 1; // criticals
+SIGNON_EXPORT int signonTraceCategories = 0;
+
+static int enabledCategories = AllCategories;
+
+static const struct {
+    LoggingCategory category;
+    const char *name;
+} categoryNames[] = {
+    { GeneralCategory, "general" },
+    { DatabaseCategory, "db" },
+    { PluginCategory, "plugin" },
+    { AccessControlCategory, "acl" },
+    { SessionCategory, "session" },
+};
+static const int categoryCount =
+    sizeof(categoryNames) / sizeof(categoryNames[0]);
+
+static void updateTraceCategories()
+{
+    signonTraceCategories =
+        (signonLoggingLevel >= 2) ? enabledCategories : 0;
+}
 
 namespace SignOn {
 
 SIGNON_EXPORT void setLoggingLevel(int level)
 {
     signonLoggingLevel = level;
+    updateTraceCategories();
 }
 
-}; // namespace
+SIGNON_EXPORT int loggingLevel()
+{
+    return signonLoggingLevel;
+}
+
+SIGNON_EXPORT void setLoggingCategories(int categories)
+{
+    enabledCategories = categories & AllCategories;
+    updateTraceCategories();
+}
 
+SIGNON_EXPORT int loggingCategories()
+{
+    return enabledCategories;
+}
+
+SIGNON_EXPORT int loggingCategoriesFromNames(const QStringList &names)
+{
+    int categories = 0;
+    foreach (const QString &name, names) {
+        QString trimmed = name.trimmed();
+        for (int i = 0; i < categoryCount; i++) {
+            if (trimmed == QLatin1String(categoryNames[i].name))
+                categories |= categoryNames[i].category;
+        }
+    }
+    return categories;
+}
+
+SIGNON_EXPORT QStringList loggingCategoryNames(int categories)
+{
+    QStringList names;
+    for (int i = 0; i < categoryCount; i++) {
+        if (categories & categoryNames[i].category)
+            names.append(QLatin1String(categoryNames[i].name));
+    }
+    return names;
+}
+
+}; // namespace
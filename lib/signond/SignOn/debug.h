@@ -25,6 +25,30 @@
 
 #include <SignOn/export.h>
 
+#include <QStringList>
+
+namespace SignOn {
+
+/*!
+ * Subsystems whose debug messages can be enabled separately; a source file
+ * selects its category by redefining SIGNON_TRACE_CATEGORY after its
+ * includes.
+ */
+enum LoggingCategory {
+    GeneralCategory = 1 << 0,
+    DatabaseCategory = 1 << 1,
+    PluginCategory = 1 << 2,
+    AccessControlCategory = 1 << 3,
+    SessionCategory = 1 << 4,
+    AllCategories = (1 << 5) - 1
+};
+
+} // namespace SignOn
+
+#ifndef SIGNON_TRACE_CATEGORY
+    #define SIGNON_TRACE_CATEGORY SignOn::GeneralCategory
+#endif
+
 #ifdef SIGNON_TRACE
     #ifdef TRACE
         #undef TRACE
@@ -39,6 +63,9 @@
     #ifdef DEBUG_ENABLED
         /* 0 - fatal, 1 - critical(default), 2 - info/debug */
         extern int signonLoggingLevel;
+        /* the categories whose debug messages are enabled; 0 if the
+         * logging level hides them */
+        extern int signonTraceCategories;
 
         static inline bool debugEnabled()
         {
@@ -50,13 +77,23 @@
             return signonLoggingLevel >= 1;
         }
 
+        static inline bool traceEnabled(int category)
+        {
+            return (signonTraceCategories & category) != 0;
+        }
+
+        /* The arguments are not evaluated when the message is disabled;
+         * the empty branch makes the macros safe to use in an if/else. */
         #define TRACE() \
-            if (debugEnabled()) qDebug() << __FILE__ << __LINE__ << __func__
+            if (!traceEnabled(SIGNON_TRACE_CATEGORY)) {} else \
+                qDebug() << __FILE__ << __LINE__ << __func__
         #define BLAME() \
-            if (criticalsEnabled()) qCritical() << __FILE__ << __LINE__ << __func__
+            if (!criticalsEnabled()) {} else \
+                qCritical() << __FILE__ << __LINE__ << __func__
     #else
         static inline bool debugEnabled() { return false; }
         static inline bool criticalsEnabled() { return false; }
+        static inline bool traceEnabled(int) { return false; }
         #define TRACE() while (0) qDebug()
         #define BLAME() while (0) qDebug()
     #endif
@@ -65,6 +102,22 @@
 namespace SignOn {
 
 void setLoggingLevel(int level);
+int loggingLevel();
+
+/*!
+ * Enables the debug messages of the given categories only; they are shown
+ * if the logging level is at least 2.
+ * @param categories a combination of LoggingCategory values.
+ */
+void setLoggingCategories(int categories);
+int loggingCategories();
+
+/*!
+ * Converts between the categories and their names: "general", "db",
+ * "plugin", "acl" and "session". Unknown names are ignored.
+ */
+int loggingCategoriesFromNames(const QStringList &names);
+QStringList loggingCategoryNames(int categories);
 
 };
 
@@ -64,7 +64,11 @@ public:
     bool authorizeKey(const SignOn::Key &key, KeyHandler::AuthorizeFlags flags);
     bool revokeKeyAuthorization(const SignOn::Key &key);
 
+private:
+    void checkInsertedKey(const SignOn::Key &key);
+
 private Q_SLOTS:
+    void onFileSystemMountFinished();
     void onKeyInserted(const SignOn::Key key);
     void onKeyDisabled(const SignOn::Key key);
     void onKeyRemoved(const SignOn::Key key);
@@ -76,6 +80,8 @@ private:
     KeyManagersList m_readyKeyManagers;
     QSet<SignOn::Key> m_insertedKeys;
     QSet<SignOn::Key> m_authorizedKeys;
+    /* inserted keys waiting for the file system to be mounted */
+    QSet<SignOn::Key> m_pendingKeys;
 };
 };
 
@@ -85,6 +91,9 @@ void KeyHandlerPrivate::initialize(AbstractCryptoManager *cryptoManager,
     m_cryptoManager = cryptoManager;
     m_keyManagers = keyManagers;
 
+    connect(m_cryptoManager, SIGNAL(fileSystemMountFinished()),
+            SLOT(onFileSystemMountFinished()));
+
     if (keyManagers.isEmpty()) {
         TRACE() << "No key manager has been registered";
     }
@@ -128,7 +137,8 @@ bool KeyHandlerPrivate::authorizeKey(const SignOn::Key &key,
         }
 
         SignOn::Key authorizedKey = anyAuthorizedKey();
-        if (!m_cryptoManager->fileSystemIsMounted()) {
+        if (!m_cryptoManager->fileSystemIsMounted() &&
+            !m_cryptoManager->fileSystemIsMounting()) {
             m_cryptoManager->setEncryptionKey(authorizedKey);
             if (!m_cryptoManager->mountFileSystem()) {
                 BLAME() << "Couldn't mount FS: cannot add new key";
@@ -136,7 +146,8 @@ bool KeyHandlerPrivate::authorizeKey(const SignOn::Key &key,
             }
         }
 
-        // at this point, the FS is mounted
+        /* The FS is mounted, or being mounted: addEncryptionKey() waits for
+         * the mount to finish, and fails if it didn't succeed */
         if (!m_cryptoManager->addEncryptionKey(key, authorizedKey)) {
             BLAME() << "Couldn't add new key";
             return false;
@@ -163,7 +174,8 @@ bool KeyHandlerPrivate::revokeKeyAuthorization(const SignOn::Key &key)
     }
 
     SignOn::Key authorizedKey = anyAuthorizedKey();
-    if (!m_cryptoManager->fileSystemIsMounted()) {
+    if (!m_cryptoManager->fileSystemIsMounted() &&
+        !m_cryptoManager->fileSystemIsMounting()) {
         m_cryptoManager->setEncryptionKey(authorizedKey);
         if (!m_cryptoManager->mountFileSystem()) {
             BLAME() << "Couldn't mount FS: cannot remove key";
@@ -171,7 +183,8 @@ bool KeyHandlerPrivate::revokeKeyAuthorization(const SignOn::Key &key)
         }
     }
 
-    // at this point, the FS is mounted; remove the key
+    /* The FS is mounted, or being mounted: removeEncryptionKey() waits for
+     * the mount to finish, and fails if it didn't succeed */
     if (!m_cryptoManager->removeEncryptionKey(key, authorizedKey)) {
         BLAME() << "Failed to remove key";
         return false;
@@ -202,6 +215,12 @@ void KeyHandlerPrivate::onKeyInserted(const SignOn::Key key)
     if (key.isEmpty()) return;
 
     m_insertedKeys.insert(key);
+    checkInsertedKey(key);
+}
+
+void KeyHandlerPrivate::checkInsertedKey(const SignOn::Key &key)
+{
+    Q_Q(KeyHandler);
 
     if (m_cryptoManager->fileSystemIsSetup()) {
         /* The `key in use` check will attempt to mount using the new key if
@@ -211,12 +230,38 @@ void KeyHandlerPrivate::onKeyInserted(const SignOn::Key key)
             TRACE() << "Key already in use.";
             if (!m_authorizedKeys.contains(key))
                 m_authorizedKeys.insert(key);
+        } else if (m_cryptoManager->fileSystemIsMounting()) {
+            /* Only a successful mount tells whether the key is in use */
+            TRACE() << "Waiting for the file system to be mounted.";
+            m_pendingKeys.insert(key);
+            return;
         }
     }
 
     emit q->keyInserted(key);
 }
 
+void KeyHandlerPrivate::onFileSystemMountFinished()
+{
+    Q_Q(KeyHandler);
+
+    QSet<SignOn::Key> pendingKeys = m_pendingKeys;
+    m_pendingKeys.clear();
+
+    foreach (const SignOn::Key &key, pendingKeys) {
+        if (!m_insertedKeys.contains(key)) continue;
+
+        /* Don't retry the key which has just failed to mount */
+        if (!m_cryptoManager->fileSystemIsMounted() &&
+            m_cryptoManager->encryptionKey() == key) {
+            emit q->keyInserted(key);
+            continue;
+        }
+
+        checkInsertedKey(key);
+    }
+}
+
 
 void KeyHandlerPrivate::onKeyDisabled(const SignOn::Key key)
 {
@@ -227,6 +272,7 @@ void KeyHandlerPrivate::onKeyDisabled(const SignOn::Key key)
     emit q->keyDisabled(key);
 
     m_insertedKeys.remove(key);
+    m_pendingKeys.remove(key);
 
     /* If no authorized inserted keys left, emit a special notification */
     if (authorizedInsertedKeys().isEmpty() &&
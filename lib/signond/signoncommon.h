@@ -45,6 +45,9 @@
 
 #define SIGNOND_MAX_TIMEOUT 0x7FFFFFFF
 
+/* Maximum number of IDs accepted by a getIdentities() call */
+#define SIGNOND_MAX_IDENTITIES_PER_CALL 128
+
 /*
  * todo: the naming convention for interfaces should be clarified
  * */
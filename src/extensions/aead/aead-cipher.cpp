@@ -0,0 +1,164 @@
+/*
+ * This file is part of signon
+ *
+ * Copyright (C) 2013 Canonical Ltd.
+ *
+ * Contact: Alberto Mardegan <alberto.mardegan@canonical.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+
+#include "aead-cipher.h"
+#include "debug.h"
+
+#include <string.h>
+
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/rand.h>
+
+#define UCHAR(data) reinterpret_cast<unsigned char *>(data)
+#define CUCHAR(data) reinterpret_cast<const unsigned char *>(data)
+
+static bool hmacSha256(const QByteArray &key, const QByteArray &data,
+                       QByteArray &mac)
+{
+    unsigned int length = 0;
+    mac.resize(EVP_MAX_MD_SIZE);
+    if (HMAC(EVP_sha256(), key.constData(), key.size(),
+             CUCHAR(data.constData()), data.size(),
+             UCHAR(mac.data()), &length) == 0)
+        return false;
+    mac.resize(length);
+    return true;
+}
+
+QByteArray AeadCipher::randomBytes(int size)
+{
+    QByteArray bytes(size, '\0');
+    if (RAND_bytes(UCHAR(bytes.data()), size) != 1) {
+        BLAME() << "Could not generate random bytes";
+        return QByteArray();
+    }
+    return bytes;
+}
+
+QByteArray AeadCipher::deriveKey(const QByteArray &secret,
+                                 const QByteArray &salt,
+                                 const QByteArray &info)
+{
+    /* HKDF (RFC 5869): a single expansion block is enough for KeySize */
+    QByteArray pseudoRandomKey;
+    if (!hmacSha256(salt, secret, pseudoRandomKey))
+        return QByteArray();
+
+    QByteArray key;
+    bool ok = hmacSha256(pseudoRandomKey, info + char(1), key);
+    wipe(pseudoRandomKey);
+    if (!ok) return QByteArray();
+
+    key.truncate(KeySize);
+    return key;
+}
+
+QByteArray AeadCipher::seal(const QByteArray &key,
+                            const QByteArray &plaintext,
+                            const QByteArray &associatedData)
+{
+    if (key.size() != KeySize) return QByteArray();
+
+    QByteArray nonce = randomBytes(NonceSize);
+    if (nonce.isEmpty()) return QByteArray();
+
+    QByteArray sealed(NonceSize + plaintext.size() + TagSize, '\0');
+    memcpy(sealed.data(), nonce.constData(), NonceSize);
+    unsigned char *ciphertext = UCHAR(sealed.data()) + NonceSize;
+
+    EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
+    int length = 0;
+    bool ok = ctx != 0 &&
+        EVP_EncryptInit_ex(ctx, EVP_aes_256_gcm(), 0, 0, 0) == 1 &&
+        EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_IVLEN,
+                            NonceSize, 0) == 1 &&
+        EVP_EncryptInit_ex(ctx, 0, 0, CUCHAR(key.constData()),
+                           CUCHAR(nonce.constData())) == 1 &&
+        EVP_EncryptUpdate(ctx, 0, &length,
+                          CUCHAR(associatedData.constData()),
+                          associatedData.size()) == 1 &&
+        EVP_EncryptUpdate(ctx, ciphertext, &length,
+                          CUCHAR(plaintext.constData()),
+                          plaintext.size()) == 1 &&
+        EVP_EncryptFinal_ex(ctx, ciphertext + length, &length) == 1 &&
+        EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_GET_TAG, TagSize,
+                            ciphertext + plaintext.size()) == 1;
+    EVP_CIPHER_CTX_free(ctx);
+
+    if (!ok) {
+        BLAME() << "Encryption failed";
+        return QByteArray();
+    }
+    return sealed;
+}
+
+bool AeadCipher::open(const QByteArray &key,
+                      const QByteArray &sealed,
+                      const QByteArray &associatedData,
+                      QByteArray &plaintext)
+{
+    if (key.size() != KeySize || sealed.size() < NonceSize + TagSize)
+        return false;
+
+    int size = sealed.size() - NonceSize - TagSize;
+    const unsigned char *nonce = CUCHAR(sealed.constData());
+    const unsigned char *ciphertext = nonce + NonceSize;
+    QByteArray tag = sealed.right(TagSize);
+    QByteArray decrypted(size, '\0');
+
+    EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
+    int length = 0;
+    bool ok = ctx != 0 &&
+        EVP_DecryptInit_ex(ctx, EVP_aes_256_gcm(), 0, 0, 0) == 1 &&
+        EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_IVLEN,
+                            NonceSize, 0) == 1 &&
+        EVP_DecryptInit_ex(ctx, 0, 0, CUCHAR(key.constData()),
+                           nonce) == 1 &&
+        EVP_DecryptUpdate(ctx, 0, &length,
+                          CUCHAR(associatedData.constData()),
+                          associatedData.size()) == 1 &&
+        EVP_DecryptUpdate(ctx, UCHAR(decrypted.data()), &length,
+                          ciphertext, size) == 1 &&
+        EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_TAG, TagSize,
+                            tag.data()) == 1 &&
+        /* This is where the tag is verified */
+        EVP_DecryptFinal_ex(ctx, UCHAR(decrypted.data()) + length,
+                            &length) == 1;
+    EVP_CIPHER_CTX_free(ctx);
+
+    if (!ok) {
+        wipe(decrypted);
+        return false;
+    }
+    plaintext = decrypted;
+    return true;
+}
+
+void AeadCipher::wipe(QByteArray &data)
+{
+    if (data.isEmpty()) return;
+    OPENSSL_cleanse(data.data(), data.size());
+    data.clear();
+}
@@ -0,0 +1,83 @@
+/*
+ * This file is part of signon
+ *
+ * Copyright (C) 2013 Canonical Ltd.
+ *
+ * Contact: Alberto Mardegan <alberto.mardegan@canonical.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+
+#ifndef AEAD_CIPHER_H
+#define AEAD_CIPHER_H
+
+#include <QByteArray>
+
+/*!
+ * @class AeadCipher
+ * Authenticated encryption with AES-256-GCM, and key derivation with
+ * HKDF-SHA256, as provided by OpenSSL's libcrypto.
+ */
+class AeadCipher
+{
+public:
+    enum {
+        KeySize = 32,
+        NonceSize = 12,
+        TagSize = 16,
+        SaltSize = 16
+    };
+
+    /*!
+     * @returns @size cryptographically strong random bytes, or an empty
+     * array on failure.
+     */
+    static QByteArray randomBytes(int size);
+
+    /*!
+     * Derives a KeySize bytes key from @secret, which is expected to have
+     * high entropy already: no key stretching is done.
+     */
+    static QByteArray deriveKey(const QByteArray &secret,
+                                const QByteArray &salt,
+                                const QByteArray &info);
+
+    /*!
+     * Encrypts @plaintext with @key; @associatedData is authenticated but
+     * not stored.
+     * @returns the nonce, followed by the ciphertext and the tag, or an
+     * empty array on failure.
+     */
+    static QByteArray seal(const QByteArray &key,
+                           const QByteArray &plaintext,
+                           const QByteArray &associatedData);
+
+    /*!
+     * Decrypts the output of seal(); fails if the data was not sealed with
+     * @key and @associatedData, or if it was modified.
+     */
+    static bool open(const QByteArray &key,
+                     const QByteArray &sealed,
+                     const QByteArray &associatedData,
+                     QByteArray &plaintext);
+
+    /*!
+     * Overwrites the contents of @data before clearing it.
+     */
+    static void wipe(QByteArray &data);
+};
+
+#endif // AEAD_CIPHER_H
@@ -0,0 +1,163 @@
+/*
+ * This file is part of signon
+ *
+ * Copyright (C) 2013 Canonical Ltd.
+ *
+ * Contact: Alberto Mardegan <alberto.mardegan@canonical.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+
+#include "aead-crypto-manager.h"
+#include "aead-keyring.h"
+#include "debug.h"
+
+#include <QDir>
+
+static const char keyringFileName[] = "signon-keyring";
+
+AeadCryptoManager::AeadCryptoManager(AeadKeyring *keyring, QObject *parent):
+    SignOn::AbstractCryptoManager(parent),
+    m_keyring(keyring)
+{
+}
+
+AeadCryptoManager::~AeadCryptoManager()
+{
+    m_keyring->lock();
+}
+
+bool AeadCryptoManager::initialize(const QVariantMap &configuration)
+{
+    m_storagePath =
+        QDir(configuration.value(QLatin1String("StoragePath")).toString()).path();
+    if (m_storagePath.startsWith(QLatin1Char('~')))
+        m_storagePath.replace(0, 1, QDir::homePath());
+
+    m_keyring->setFilePath(m_storagePath + QDir::separator() +
+                           QLatin1String(keyringFileName));
+    m_secretsDbName =
+        configuration.value(QLatin1String("SecretsDbName"),
+                            QLatin1String("signon-secrets.db")).toString();
+    setFileSystemSetup(m_keyring->exists());
+    return true;
+}
+
+bool AeadCryptoManager::setupFileSystem()
+{
+    if (encryptionKey().isEmpty()) {
+        TRACE() << "No encryption key set";
+        return false;
+    }
+
+    setFileSystemMounted(false);
+    QDir().mkpath(m_storagePath);
+    if (!m_keyring->create(encryptionKey())) {
+        BLAME() << "Could not create the keyring";
+        return false;
+    }
+
+    setFileSystemSetup(true);
+    setFileSystemMounted(true);
+    return true;
+}
+
+bool AeadCryptoManager::deleteFileSystem()
+{
+    setFileSystemMounted(false);
+    if (!m_keyring->remove()) {
+        BLAME() << "Could not remove the keyring";
+        return false;
+    }
+
+    setFileSystemSetup(false);
+    return true;
+}
+
+bool AeadCryptoManager::mountFileSystem()
+{
+    if (fileSystemIsMounted()) {
+        TRACE() << "Keyring already unlocked";
+        return false;
+    }
+
+    if (encryptionKey().isEmpty()) {
+        TRACE() << "No encryption key set";
+        return false;
+    }
+
+    if (!m_keyring->unlock(encryptionKey()))
+        return false;
+
+    setFileSystemMounted(true);
+    return true;
+}
+
+bool AeadCryptoManager::unmountFileSystem()
+{
+    /* Let the secrets storage be closed before the key goes away */
+    setFileSystemMounted(false);
+    m_keyring->lock();
+    return true;
+}
+
+QString AeadCryptoManager::fileSystemMountPath() const
+{
+    return m_storagePath;
+}
+
+QStringList AeadCryptoManager::backupFiles() const
+{
+    /* The secrets DB is not inside an image: back it up with its keyring.
+     * The names are relative to the storage path. */
+    return QStringList() << QLatin1String(keyringFileName) << m_secretsDbName;
+}
+
+bool AeadCryptoManager::encryptionKeyInUse(const SignOn::Key &key)
+{
+    if (fileSystemIsMounted())
+        return m_keyring->hasKey(key);
+
+    /* As in the LUKS implementation, a valid key unlocks the keyring */
+    if (!m_keyring->unlock(key))
+        return false;
+
+    setEncryptionKey(key);
+    setFileSystemMounted(true);
+    return true;
+}
+
+bool AeadCryptoManager::addEncryptionKey(const SignOn::Key &key,
+                                         const SignOn::Key &existingKey)
+{
+    if (!fileSystemIsMounted() || !m_keyring->hasKey(existingKey)) {
+        BLAME() << "The keyring must be unlocked with a valid key";
+        return false;
+    }
+
+    return m_keyring->addKey(key);
+}
+
+bool AeadCryptoManager::removeEncryptionKey(const SignOn::Key &key,
+                                            const SignOn::Key &remainingKey)
+{
+    if (!m_keyring->hasKey(remainingKey)) {
+        BLAME() << "The remaining key is not valid";
+        return false;
+    }
+
+    return m_keyring->removeKey(key);
+}
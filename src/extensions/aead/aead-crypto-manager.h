@@ -0,0 +1,65 @@
+/*
+ * This file is part of signon
+ *
+ * Copyright (C) 2013 Canonical Ltd.
+ *
+ * Contact: Alberto Mardegan <alberto.mardegan@canonical.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+
+#ifndef AEAD_CRYPTO_MANAGER_H
+#define AEAD_CRYPTO_MANAGER_H
+
+#include <SignOn/AbstractCryptoManager>
+
+class AeadKeyring;
+
+/*!
+ * @class AeadCryptoManager
+ * Crypto manager which doesn't encrypt a file system: "mounting" unlocks
+ * the AeadKeyring, whose data key is used by the AeadSecretsStorage to
+ * encrypt each secret.
+ */
+class AeadCryptoManager: public SignOn::AbstractCryptoManager
+{
+    Q_OBJECT
+
+public:
+    AeadCryptoManager(AeadKeyring *keyring, QObject *parent = 0);
+    ~AeadCryptoManager();
+
+    // reimplemented virtual methods
+    bool initialize(const QVariantMap &configuration);
+    bool setupFileSystem();
+    bool deleteFileSystem();
+    bool mountFileSystem();
+    bool unmountFileSystem();
+    QString fileSystemMountPath() const;
+    QStringList backupFiles() const;
+    bool encryptionKeyInUse(const SignOn::Key &key);
+    bool addEncryptionKey(const SignOn::Key &key,
+                          const SignOn::Key &existingKey);
+    bool removeEncryptionKey(const SignOn::Key &key,
+                             const SignOn::Key &remainingKey);
+
+private:
+    AeadKeyring *m_keyring;
+    QString m_storagePath;
+    QString m_secretsDbName;
+};
+
+#endif // AEAD_CRYPTO_MANAGER_H
@@ -0,0 +1,221 @@
+/*
+ * This file is part of signon
+ *
+ * Copyright (C) 2013 Canonical Ltd.
+ *
+ * Contact: Alberto Mardegan <alberto.mardegan@canonical.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+
+#include "aead-keyring.h"
+#include "aead-cipher.h"
+#include "debug.h"
+
+#include <QDataStream>
+#include <QFile>
+
+#include <stdio.h>
+#include <unistd.h>
+
+#define KEYRING_MAGIC 0x53534f4b /* "SSOK" */
+#define KEYRING_VERSION 1
+
+static const QByteArray slotInfo("signon-aead-keyslot");
+
+AeadKeyring::AeadKeyring()
+{
+}
+
+AeadKeyring::~AeadKeyring()
+{
+    lock();
+}
+
+void AeadKeyring::setFilePath(const QString &filePath)
+{
+    m_filePath = filePath;
+}
+
+bool AeadKeyring::exists() const
+{
+    return QFile::exists(m_filePath);
+}
+
+bool AeadKeyring::create(const SignOn::Key &key)
+{
+    if (key.isEmpty()) return false;
+
+    lock();
+    m_dataKey = AeadCipher::randomBytes(AeadCipher::KeySize);
+    if (m_dataKey.isEmpty()) return false;
+
+    QList<KeySlot> keySlots;
+    KeySlot keySlot = makeSlot(key);
+    if (keySlot.second.isEmpty() ||
+        !writeSlots(keySlots << keySlot)) {
+        lock();
+        return false;
+    }
+    return true;
+}
+
+bool AeadKeyring::remove()
+{
+    lock();
+    return !exists() || QFile::remove(m_filePath);
+}
+
+bool AeadKeyring::unlock(const SignOn::Key &key)
+{
+    if (key.isEmpty()) return false;
+
+    QList<KeySlot> keySlots;
+    if (!readSlots(keySlots)) return false;
+
+    QByteArray dataKey;
+    if (findSlot(keySlots, key, &dataKey) < 0) {
+        TRACE() << "No slot for the given key";
+        return false;
+    }
+
+    lock();
+    m_dataKey = dataKey;
+    return true;
+}
+
+void AeadKeyring::lock()
+{
+    AeadCipher::wipe(m_dataKey);
+}
+
+bool AeadKeyring::hasKey(const SignOn::Key &key) const
+{
+    QList<KeySlot> keySlots;
+    return readSlots(keySlots) && findSlot(keySlots, key) >= 0;
+}
+
+bool AeadKeyring::addKey(const SignOn::Key &key)
+{
+    if (!isUnlocked() || key.isEmpty()) return false;
+
+    QList<KeySlot> keySlots;
+    if (!readSlots(keySlots)) return false;
+    if (findSlot(keySlots, key) >= 0) return true;
+
+    KeySlot keySlot = makeSlot(key);
+    if (keySlot.second.isEmpty()) return false;
+    return writeSlots(keySlots << keySlot);
+}
+
+bool AeadKeyring::removeKey(const SignOn::Key &key)
+{
+    QList<KeySlot> keySlots;
+    if (!readSlots(keySlots)) return false;
+
+    int index = findSlot(keySlots, key);
+    if (index < 0) return true;
+    if (keySlots.count() == 1) {
+        BLAME() << "Cannot remove the last key";
+        return false;
+    }
+
+    keySlots.removeAt(index);
+    return writeSlots(keySlots);
+}
+
+bool AeadKeyring::readSlots(QList<KeySlot> &keySlots) const
+{
+    QFile file(m_filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        TRACE() << "Cannot open" << m_filePath;
+        return false;
+    }
+
+    QDataStream stream(&file);
+    quint32 magic, version;
+    stream >> magic >> version;
+    if (magic != KEYRING_MAGIC || version != KEYRING_VERSION) {
+        BLAME() << "Invalid keyring file" << m_filePath;
+        return false;
+    }
+
+    stream >> keySlots;
+    return stream.status() == QDataStream::Ok;
+}
+
+bool AeadKeyring::writeSlots(const QList<KeySlot> &keySlots) const
+{
+    /* Write a new file, sync it and rename it over the old one: rename() is
+     * atomic, so that after a crash the keyring is either the old or the new
+     * one, never truncated nor missing */
+    QString newFilePath = m_filePath + QLatin1String(".new");
+    QFile file(newFilePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        BLAME() << "Cannot write" << newFilePath;
+        return false;
+    }
+    file.setPermissions(QFile::ReadOwner | QFile::WriteOwner);
+
+    QDataStream stream(&file);
+    stream << quint32(KEYRING_MAGIC) << quint32(KEYRING_VERSION) << keySlots;
+    bool ok = stream.status() == QDataStream::Ok && file.flush() &&
+        ::fsync(file.handle()) == 0;
+    file.close();
+
+    if (!ok ||
+        ::rename(QFile::encodeName(newFilePath).constData(),
+                 QFile::encodeName(m_filePath).constData()) != 0) {
+        BLAME() << "Cannot write" << m_filePath;
+        QFile::remove(newFilePath);
+        return false;
+    }
+    return true;
+}
+
+int AeadKeyring::findSlot(const QList<KeySlot> &keySlots,
+                          const SignOn::Key &key,
+                          QByteArray *dataKey) const
+{
+    if (key.isEmpty()) return -1;
+
+    for (int i = 0; i < keySlots.count(); i++) {
+        const KeySlot &keySlot = keySlots[i];
+        QByteArray slotKey =
+            AeadCipher::deriveKey(key, keySlot.first, slotInfo);
+        QByteArray slotDataKey;
+        bool ok = AeadCipher::open(slotKey, keySlot.second, slotInfo,
+                                   slotDataKey);
+        AeadCipher::wipe(slotKey);
+        if (!ok) continue;
+
+        if (dataKey != 0)
+            *dataKey = slotDataKey;
+        else
+            AeadCipher::wipe(slotDataKey);
+        return i;
+    }
+    return -1;
+}
+
+AeadKeyring::KeySlot AeadKeyring::makeSlot(const SignOn::Key &key) const
+{
+    QByteArray salt = AeadCipher::randomBytes(AeadCipher::SaltSize);
+    QByteArray slotKey = AeadCipher::deriveKey(key, salt, slotInfo);
+    QByteArray sealed = AeadCipher::seal(slotKey, m_dataKey, slotInfo);
+    AeadCipher::wipe(slotKey);
+    return KeySlot(salt, sealed);
+}
@@ -0,0 +1,103 @@
+/*
+ * This file is part of signon
+ *
+ * Copyright (C) 2013 Canonical Ltd.
+ *
+ * Contact: Alberto Mardegan <alberto.mardegan@canonical.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+
+#ifndef AEAD_KEYRING_H
+#define AEAD_KEYRING_H
+
+#include <SignOn/AbstractKeyManager>
+
+#include <QList>
+#include <QPair>
+#include <QString>
+
+/*!
+ * @class AeadKeyring
+ * The key slots file, modeled after a LUKS header: the secrets are encrypted
+ * with a random data key, and each authorized SignOn::Key has a slot holding
+ * a copy of the data key, encrypted with a key derived from it.
+ * Unlocking only takes a key derivation and a decryption, and needs no
+ * privileges.
+ */
+class AeadKeyring
+{
+public:
+    AeadKeyring();
+    ~AeadKeyring();
+
+    void setFilePath(const QString &filePath);
+    QString filePath() const { return m_filePath; }
+    bool exists() const;
+
+    /*!
+     * Creates a new data key, discarding any existing slot, and adds a slot
+     * for @key. The keyring is left unlocked.
+     */
+    bool create(const SignOn::Key &key);
+
+    /*!
+     * Deletes the key slots file, and locks the keyring.
+     */
+    bool remove();
+
+    /*!
+     * Loads the data key from the slot of @key.
+     */
+    bool unlock(const SignOn::Key &key);
+    void lock();
+    bool isUnlocked() const { return !m_dataKey.isEmpty(); }
+
+    /*!
+     * @returns the data key, or an empty array if the keyring is locked.
+     */
+    QByteArray dataKey() const { return m_dataKey; }
+
+    /*!
+     * @returns whether @key has a slot in the keyring.
+     */
+    bool hasKey(const SignOn::Key &key) const;
+
+    /*!
+     * Adds a slot for @key; the keyring must be unlocked.
+     */
+    bool addKey(const SignOn::Key &key);
+
+    /*!
+     * Removes the slot of @key; the last slot cannot be removed.
+     */
+    bool removeKey(const SignOn::Key &key);
+
+private:
+    /* The salt, and the sealed data key */
+    typedef QPair<QByteArray, QByteArray> KeySlot;
+
+    bool readSlots(QList<KeySlot> &keySlots) const;
+    bool writeSlots(const QList<KeySlot> &keySlots) const;
+    int findSlot(const QList<KeySlot> &keySlots, const SignOn::Key &key,
+                 QByteArray *dataKey = 0) const;
+    KeySlot makeSlot(const SignOn::Key &key) const;
+
+    QString m_filePath;
+    QByteArray m_dataKey;
+};
+
+#endif // AEAD_KEYRING_H
@@ -0,0 +1,48 @@
+/*
+ * This file is part of signon
+ *
+ * Copyright (C) 2013 Canonical Ltd.
+ *
+ * Contact: Alberto Mardegan <alberto.mardegan@canonical.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+
+#include "aead-plugin.h"
+#include "aead-crypto-manager.h"
+#include "aead-secrets-storage.h"
+
+using namespace SignOn;
+
+AeadPlugin::AeadPlugin():
+    QObject(0)
+{
+    setObjectName(QLatin1String("aead"));
+}
+
+AbstractCryptoManager *AeadPlugin::cryptoManager(QObject *parent) const
+{
+    return new AeadCryptoManager(&m_keyring, parent);
+}
+
+AbstractSecretsStorage *AeadPlugin::secretsStorage(QObject *parent) const
+{
+    return new AeadSecretsStorage(&m_keyring, parent);
+}
+
+#if QT_VERSION < QT_VERSION_CHECK(5, 0, 0)
+Q_EXPORT_PLUGIN2(aead, AeadPlugin);
+#endif
@@ -0,0 +1,390 @@
+/*
+ * This file is part of signon
+ *
+ * Copyright (C) 2013 Canonical Ltd.
+ *
+ * Contact: Alberto Mardegan <alberto.mardegan@canonical.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+
+#include "aead-secrets-storage.h"
+#include "aead-cipher.h"
+#include "aead-keyring.h"
+#include "debug.h"
+
+#include <QDataStream>
+#include <QSqlError>
+#include <QStringList>
+
+#define S(s) QLatin1String(s)
+
+/* The same limit as SSO_MAX_TOKEN_STORAGE, enforced by the default storage:
+ * 4 kB for token store/identity/method */
+#define MAX_TOKEN_STORAGE (4*1024)
+
+#define RETURN_IF_NOT_OPEN(retval) \
+    if (!isOpen()) { \
+        TRACE() << "Secrets DB is not available"; \
+        setLastError(SignOn::CredentialsDBError( \
+            S("Not open"), SignOn::CredentialsDBError::NotOpen)); \
+        return retval; \
+    }
+
+static QByteArray credentialsTag(quint32 id)
+{
+    return "credentials:" + QByteArray::number(id);
+}
+
+static QByteArray dataTag(quint32 id, quint32 method)
+{
+    return "data:" + QByteArray::number(id) + ':' +
+        QByteArray::number(method);
+}
+
+AeadSecretsStorage::AeadSecretsStorage(AeadKeyring *keyring,
+                                       QObject *parent):
+    SignOn::AbstractSecretsStorage(parent),
+    m_keyring(keyring),
+    m_connectionName(S("SSO-aead-secrets"))
+{
+}
+
+AeadSecretsStorage::~AeadSecretsStorage()
+{
+    close();
+}
+
+bool AeadSecretsStorage::initialize(const QVariantMap &configuration)
+{
+    if (isOpen()) {
+        TRACE() << "Initializing open DB; closing first...";
+        close();
+    }
+
+    if (!m_keyring->isUnlocked()) {
+        setLastError(SignOn::CredentialsDBError(
+            S("Keyring is locked"), SignOn::CredentialsDBError::NotOpen));
+        return false;
+    }
+
+    QSqlDatabase db = QSqlDatabase::addDatabase(S("QSQLITE"),
+                                                m_connectionName);
+    db.setDatabaseName(configuration.value(S("name")).toString());
+    if (!db.open()) {
+        BLAME() << "Could not open the secrets DB:" << db.lastError().text();
+        setLastError(SignOn::CredentialsDBError(
+            db.lastError().text(),
+            SignOn::CredentialsDBError::ConnectionError));
+        db = QSqlDatabase();
+        QSqlDatabase::removeDatabase(m_connectionName);
+        return false;
+    }
+
+    m_dataKey = m_keyring->dataKey();
+    setIsOpen(true);
+    if (!createTables()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool AeadSecretsStorage::close()
+{
+    if (QSqlDatabase::contains(m_connectionName)) {
+        QSqlDatabase::database(m_connectionName, false).close();
+        QSqlDatabase::removeDatabase(m_connectionName);
+    }
+    AeadCipher::wipe(m_dataKey);
+    return AbstractSecretsStorage::close();
+}
+
+bool AeadSecretsStorage::createTables()
+{
+    /* The table names differ from those of the default storage, so that
+     * both can share the same file without clashing */
+    QStringList queries = QStringList()
+        << S("CREATE TABLE IF NOT EXISTS SEALED_CREDENTIALS"
+             "(id INTEGER NOT NULL PRIMARY KEY,"
+             "secret BLOB)")
+        << S("CREATE TABLE IF NOT EXISTS SEALED_STORE"
+             "(identity_id INTEGER,"
+             "method_id INTEGER,"
+             "secret BLOB,"
+             "PRIMARY KEY (identity_id, method_id))")
+        << S("CREATE TRIGGER IF NOT EXISTS tg_delete_sealed_credentials "
+             "BEFORE DELETE ON SEALED_CREDENTIALS "
+             "FOR EACH ROW BEGIN "
+             "    DELETE FROM SEALED_STORE "
+             "    WHERE SEALED_STORE.identity_id = OLD.id; "
+             "END; ");
+    return transactionalExec(queries);
+}
+
+bool AeadSecretsStorage::exec(QSqlQuery &query)
+{
+    if (!query.exec()) {
+        TRACE() << "Query exec error:" << query.lastError().text();
+        setLastError(SignOn::CredentialsDBError(
+            query.lastError().text(),
+            SignOn::CredentialsDBError::StatementError));
+        return false;
+    }
+    return true;
+}
+
+bool AeadSecretsStorage::exec(const QString &queryStr)
+{
+    QSqlQuery query(QSqlDatabase::database(m_connectionName));
+    query.prepare(queryStr);
+    return exec(query);
+}
+
+bool AeadSecretsStorage::transactionalExec(const QStringList &queries)
+{
+    QSqlDatabase db = QSqlDatabase::database(m_connectionName);
+    if (!db.transaction()) {
+        TRACE() << "Could not start transaction";
+        return false;
+    }
+
+    foreach (const QString &queryStr, queries) {
+        if (!exec(queryStr)) {
+            db.rollback();
+            return false;
+        }
+    }
+    return db.commit();
+}
+
+bool AeadSecretsStorage::clear()
+{
+    RETURN_IF_NOT_OPEN(false);
+
+    return transactionalExec(QStringList() <<
+                             S("DELETE FROM SEALED_CREDENTIALS") <<
+                             S("DELETE FROM SEALED_STORE"));
+}
+
+bool AeadSecretsStorage::insertCredentials(const quint32 id,
+                                           const QString &username,
+                                           const QString &password)
+{
+    QByteArray plaintext;
+    QDataStream stream(&plaintext, QIODevice::WriteOnly);
+    stream << username << password;
+    QByteArray sealed =
+        AeadCipher::seal(m_dataKey, plaintext, credentialsTag(id));
+    AeadCipher::wipe(plaintext);
+    if (sealed.isEmpty()) return false;
+
+    QSqlQuery query(QSqlDatabase::database(m_connectionName));
+    query.prepare(S("INSERT OR REPLACE INTO SEALED_CREDENTIALS "
+                    "(id, secret) VALUES(:id, :secret)"));
+    query.bindValue(S(":id"), id);
+    query.bindValue(S(":secret"), sealed);
+    return exec(query);
+}
+
+bool AeadSecretsStorage::updateCredentials(const quint32 id,
+                                           const QString &username,
+                                           const QString &password)
+{
+    RETURN_IF_NOT_OPEN(false);
+
+    return updateCredentialsBatch(QList<SignOn::SecretsCredentials>() <<
+                                  SignOn::SecretsCredentials(id, username,
+                                                             password));
+}
+
+bool AeadSecretsStorage::updateCredentialsBatch(
+    const QList<SignOn::SecretsCredentials> &items)
+{
+    RETURN_IF_NOT_OPEN(false);
+
+    QSqlDatabase db = QSqlDatabase::database(m_connectionName);
+    if (!db.transaction()) {
+        TRACE() << "Could not start transaction";
+        return false;
+    }
+
+    foreach (const SignOn::SecretsCredentials &item, items) {
+        if (!insertCredentials(item.id, item.username, item.password)) {
+            db.rollback();
+            return false;
+        }
+    }
+    return db.commit();
+}
+
+bool AeadSecretsStorage::removeCredentials(const quint32 id)
+{
+    RETURN_IF_NOT_OPEN(false);
+
+    return transactionalExec(QStringList() <<
+        QString::fromLatin1("DELETE FROM SEALED_CREDENTIALS "
+                            "WHERE id = %1").arg(id) <<
+        QString::fromLatin1("DELETE FROM SEALED_STORE "
+                            "WHERE identity_id = %1").arg(id));
+}
+
+bool AeadSecretsStorage::loadCredentials(const quint32 id,
+                                         QString &username,
+                                         QString &password)
+{
+    RETURN_IF_NOT_OPEN(false);
+
+    QSqlQuery query(QSqlDatabase::database(m_connectionName));
+    query.prepare(S("SELECT secret FROM SEALED_CREDENTIALS WHERE id = :id"));
+    query.bindValue(S(":id"), id);
+    if (!exec(query) || !query.first()) {
+        TRACE() << "No credentials for" << id;
+        return false;
+    }
+
+    QByteArray plaintext;
+    if (!AeadCipher::open(m_dataKey, query.value(0).toByteArray(),
+                          credentialsTag(id), plaintext)) {
+        BLAME() << "Could not decrypt the credentials of" << id;
+        return false;
+    }
+
+    QDataStream stream(plaintext);
+    stream >> username >> password;
+    AeadCipher::wipe(plaintext);
+    return stream.status() == QDataStream::Ok;
+}
+
+QVariantMap AeadSecretsStorage::loadData(quint32 id, quint32 method)
+{
+    RETURN_IF_NOT_OPEN(QVariantMap());
+
+    QSqlQuery query(QSqlDatabase::database(m_connectionName));
+    query.prepare(S("SELECT secret FROM SEALED_STORE "
+                    "WHERE identity_id = :id AND method_id = :method"));
+    query.bindValue(S(":id"), id);
+    query.bindValue(S(":method"), method);
+    if (!exec(query) || !query.first())
+        return QVariantMap();
+
+    QByteArray plaintext;
+    if (!AeadCipher::open(m_dataKey, query.value(0).toByteArray(),
+                          dataTag(id, method), plaintext)) {
+        BLAME() << "Could not decrypt the data of" << id << method;
+        return QVariantMap();
+    }
+
+    QVariantMap data;
+    QDataStream stream(plaintext);
+    stream >> data;
+    AeadCipher::wipe(plaintext);
+    return data;
+}
+
+bool AeadSecretsStorage::replaceData(quint32 id, quint32 method,
+                                     const QVariantMap &data)
+{
+    /* Invalid values mean removal, as in the default storage */
+    QVariantMap validData;
+    qint32 dataCounter = 0;
+    QMapIterator<QString, QVariant> it(data);
+    while (it.hasNext()) {
+        it.next();
+
+        QByteArray array;
+        QDataStream valueStream(&array, QIODevice::WriteOnly);
+        valueStream << it.value();
+        dataCounter += it.key().size() + array.size();
+        if (dataCounter >= MAX_TOKEN_STORAGE) {
+            BLAME() << "storing data max size exceeded";
+            return false;
+        }
+
+        if (it.value().isValid() && !it.value().isNull())
+            validData.insert(it.key(), it.value());
+    }
+
+    QSqlQuery query(QSqlDatabase::database(m_connectionName));
+    if (validData.isEmpty()) {
+        query.prepare(S("DELETE FROM SEALED_STORE "
+                        "WHERE identity_id = :id AND method_id = :method"));
+        query.bindValue(S(":id"), id);
+        query.bindValue(S(":method"), method);
+        return exec(query);
+    }
+
+    QByteArray plaintext;
+    QDataStream stream(&plaintext, QIODevice::WriteOnly);
+    stream << validData;
+    QByteArray sealed =
+        AeadCipher::seal(m_dataKey, plaintext, dataTag(id, method));
+    AeadCipher::wipe(plaintext);
+    if (sealed.isEmpty()) return false;
+
+    query.prepare(S("INSERT OR REPLACE INTO SEALED_STORE "
+                    "(identity_id, method_id, secret) "
+                    "VALUES(:id, :method, :secret)"));
+    query.bindValue(S(":id"), id);
+    query.bindValue(S(":method"), method);
+    query.bindValue(S(":secret"), sealed);
+    return exec(query);
+}
+
+bool AeadSecretsStorage::storeData(quint32 id, quint32 method,
+                                   const QVariantMap &data)
+{
+    RETURN_IF_NOT_OPEN(false);
+
+    return storeDataBatch(QList<SignOn::SecretsData>() <<
+                          SignOn::SecretsData(id, method, data));
+}
+
+bool AeadSecretsStorage::storeDataBatch(
+    const QList<SignOn::SecretsData> &items)
+{
+    RETURN_IF_NOT_OPEN(false);
+
+    QSqlDatabase db = QSqlDatabase::database(m_connectionName);
+    if (!db.transaction()) {
+        TRACE() << "Could not start transaction";
+        return false;
+    }
+
+    foreach (const SignOn::SecretsData &item, items) {
+        if (!replaceData(item.id, item.method, item.data)) {
+            db.rollback();
+            return false;
+        }
+    }
+    return db.commit();
+}
+
+bool AeadSecretsStorage::removeData(quint32 id, quint32 method)
+{
+    RETURN_IF_NOT_OPEN(false);
+
+    QSqlQuery query(QSqlDatabase::database(m_connectionName));
+    if (method == 0) {
+        query.prepare(S("DELETE FROM SEALED_STORE WHERE identity_id = :id"));
+    } else {
+        query.prepare(S("DELETE FROM SEALED_STORE "
+                        "WHERE identity_id = :id AND method_id = :method"));
+        query.bindValue(S(":method"), method);
+    }
+    query.bindValue(S(":id"), id);
+    return exec(query);
+}
@@ -0,0 +1,84 @@
+/*
+ * This file is part of signon
+ *
+ * Copyright (C) 2013 Canonical Ltd.
+ *
+ * Contact: Alberto Mardegan <alberto.mardegan@canonical.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+
+#ifndef AEAD_SECRETS_STORAGE_H
+#define AEAD_SECRETS_STORAGE_H
+
+#include <SignOn/AbstractSecretsStorage>
+
+#include <QSqlDatabase>
+#include <QSqlQuery>
+
+class AeadKeyring;
+
+/*!
+ * @class AeadSecretsStorage
+ * SQLite-based secrets storage, where each row is encrypted with the data
+ * key of the AeadKeyring, using AES-256-GCM. The identity and method
+ * which a row belongs to are authenticated as well, so that rows cannot be
+ * swapped.
+ * The username and password of an identity are sealed together, and so are
+ * all the data of an identity for a method.
+ */
+class AeadSecretsStorage: public SignOn::AbstractSecretsStorage
+{
+    Q_OBJECT
+
+public:
+    AeadSecretsStorage(AeadKeyring *keyring, QObject *parent = 0);
+    ~AeadSecretsStorage();
+
+    // reimplemented virtual methods
+    bool initialize(const QVariantMap &configuration);
+    bool close();
+    bool clear();
+    bool updateCredentials(const quint32 id,
+                           const QString &username,
+                           const QString &password);
+    bool removeCredentials(const quint32 id);
+    bool loadCredentials(const quint32 id,
+                         QString &username,
+                         QString &password);
+    QVariantMap loadData(quint32 id, quint32 method);
+    bool storeData(quint32 id, quint32 method, const QVariantMap &data);
+    bool removeData(quint32 id, quint32 method);
+    bool updateCredentialsBatch(
+        const QList<SignOn::SecretsCredentials> &items);
+    bool storeDataBatch(const QList<SignOn::SecretsData> &items);
+
+private:
+    bool createTables();
+    bool exec(QSqlQuery &query);
+    bool exec(const QString &queryStr);
+    bool transactionalExec(const QStringList &queries);
+    bool insertCredentials(const quint32 id,
+                           const QString &username,
+                           const QString &password);
+    bool replaceData(quint32 id, quint32 method, const QVariantMap &data);
+
+    AeadKeyring *m_keyring;
+    QByteArray m_dataKey;
+    QString m_connectionName;
+};
+
+#endif // AEAD_SECRETS_STORAGE_H
@@ -0,0 +1,47 @@
+include( ../../../common-project-config.pri )
+include( $${TOP_SRC_DIR}/common-vars.pri )
+
+TEMPLATE = lib
+TARGET = aead
+
+CONFIG += \
+    plugin \
+    qt
+
+HEADERS = \
+    aead-cipher.h \
+    aead-crypto-manager.h \
+    aead-keyring.h \
+    aead-plugin.h \
+    aead-secrets-storage.h \
+    debug.h
+
+INCLUDEPATH += \
+    $${TOP_SRC_DIR}/lib/signond
+
+SOURCES += \
+    aead-cipher.cpp \
+    aead-crypto-manager.cpp \
+    aead-keyring.cpp \
+    aead-plugin.cpp \
+    aead-secrets-storage.cpp
+
+QT += core sql
+QT -= gui
+
+QMAKE_CXXFLAGS += \
+    -fno-exceptions \
+    -fno-rtti \
+    -fvisibility=hidden
+
+DEFINES += QT_NO_CAST_TO_ASCII QT_NO_CAST_FROM_ASCII
+DEFINES += \
+    SIGNON_TRACE
+
+PKGCONFIG += \
+    libcrypto
+
+include( $${TOP_SRC_DIR}/common-installs-config.pri )
+
+target.path  = $${INSTALL_LIBDIR}/signon/extensions
+INSTALLS    += target
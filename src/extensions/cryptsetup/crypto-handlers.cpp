@@ -50,15 +50,20 @@
 
 #define SIGNON_EXTERNAL_PROCESS_READ_TIMEOUT 300
 
+#define SIGNON_CRYPTSETUP_APP     "/sbin/cryptsetup"
+
 #define KILO_BYTE_SIZE 1024
 #define MEGA_BYTE_SIZE (KILO_BYTE_SIZE * 1024)
 
 /*  ------------- SystemCommandLineCallHandler implementation -------------- */
 
-SystemCommandLineCallHandler::SystemCommandLineCallHandler()
+SystemCommandLineCallHandler::SystemCommandLineCallHandler():
+    m_isAsyncCall(false)
 {
     connect(&m_process, SIGNAL(error(QProcess::ProcessError)),
             this, SLOT(error(QProcess::ProcessError)));
+    connect(&m_process, SIGNAL(finished(int, QProcess::ExitStatus)),
+            this, SLOT(onFinished(int, QProcess::ExitStatus)));
 }
 
 SystemCommandLineCallHandler::~SystemCommandLineCallHandler()
@@ -102,9 +107,69 @@ bool SystemCommandLineCallHandler::makeCall(const QString &appPath,
     return true;
 }
 
+bool SystemCommandLineCallHandler::startCall(const QString &appPath,
+                                             const QStringList &args,
+                                             const QByteArray &input)
+{
+    if (m_isAsyncCall) {
+        BLAME() << "Another call is running";
+        return false;
+    }
+
+    QString trace;
+    QTextStream stream(&trace);
+    stream << appPath << QLatin1Char(' ') << args.join(QLatin1String(" "));
+    TRACE() << trace;
+
+    m_output.clear();
+    m_isAsyncCall = true;
+    m_process.start(appPath, args);
+    /* The input is buffered until the process is started */
+    if (!input.isEmpty())
+        m_process.write(input);
+    m_process.closeWriteChannel();
+    return true;
+}
+
+void SystemCommandLineCallHandler::waitForCall()
+{
+    /* Failing to start or to finish emits finished() through the slots */
+    if (m_isAsyncCall && !m_process.waitForFinished(-1) && m_isAsyncCall)
+        finishCall(false);
+}
+
+void SystemCommandLineCallHandler::abortCall()
+{
+    if (!m_isAsyncCall) return;
+
+    m_isAsyncCall = false;
+    m_process.kill();
+    m_process.waitForFinished();
+}
+
+void SystemCommandLineCallHandler::finishCall(bool ok)
+{
+    m_isAsyncCall = false;
+    Q_EMIT finished(ok);
+}
+
 void SystemCommandLineCallHandler::error(QProcess::ProcessError err)
 {
     TRACE() << "Process erorr:" << err;
+
+    /* No finished() signal follows a failure to start */
+    if (m_isAsyncCall && err == QProcess::FailedToStart)
+        finishCall(false);
+}
+
+void SystemCommandLineCallHandler::onFinished(int exitCode,
+                                              QProcess::ExitStatus exitStatus)
+{
+    if (!m_isAsyncCall) return;
+
+    TRACE() << "Process exited:" << exitStatus << exitCode;
+    m_output = m_process.readAllStandardOutput();
+    finishCall(exitStatus == QProcess::NormalExit && exitCode == 0);
 }
 
 
@@ -139,8 +204,10 @@ bool PartitionHandler::createPartitionFile(const QString &fileName,
     return true;
 }
 
-bool PartitionHandler::formatPartitionFile(const QString &fileName,
-                                           const quint32 fileSystemType)
+bool PartitionHandler::formatPartitionFile(
+                                    SystemCommandLineCallHandler *handler,
+                                    const QString &fileName,
+                                    const quint32 fileSystemType)
 {
     QString mkfsApp = QString::fromLatin1("/sbin/mkfs.ext2");
     switch (fileSystemType) {
@@ -150,10 +217,7 @@ bool PartitionHandler::formatPartitionFile(const QString &fileName,
         default: break;
     }
 
-    SystemCommandLineCallHandler handler;
-    return handler.makeCall(
-                        mkfsApp,
-                        QStringList() << fileName);
+    return handler->startCall(mkfsApp, QStringList() << fileName);
 }
 
 
@@ -200,30 +264,28 @@ bool MountHandler::umount(const QString &mountPath)
 
 /*  ----------------------- LosetupHandler implementation ----------------------- */
 
-bool LosetupHandler::setupDevice(const QString &deviceName,
+bool LosetupHandler::setupDevice(SystemCommandLineCallHandler *handler,
+                                 const QString &deviceName,
                                  const QString &blockDevice)
 {
-    SystemCommandLineCallHandler handler;
-    return handler.makeCall(
-                        QLatin1String("/sbin/losetup"),
-                        QStringList() << deviceName << blockDevice);
+    return handler->startCall(QLatin1String("/sbin/losetup"),
+                              QStringList() << deviceName << blockDevice);
 }
 
-QString LosetupHandler::findAvailableDevice()
+bool LosetupHandler::findAvailableDevice(SystemCommandLineCallHandler *handler)
 {
-    SystemCommandLineCallHandler handler;
-    QString deviceName;
-    bool ret = handler.makeCall(
-                            QLatin1String("/sbin/losetup"),
-                            QStringList() << QLatin1String("-f"),
-                            true);
-
-    deviceName = QString::fromLocal8Bit(handler.output().trimmed());
+    return handler->startCall(QLatin1String("/sbin/losetup"),
+                              QStringList() << QLatin1String("-f"));
+}
 
-    if (ret)
-        return deviceName;
+QString LosetupHandler::availableDevice(
+                                const SystemCommandLineCallHandler *handler)
+{
+    QString deviceName = QString::fromLocal8Bit(handler->output().trimmed());
+    if (deviceName.isEmpty())
+        return QString();
 
-    return QString();
+    return deviceName;
 }
 
 bool LosetupHandler::releaseDevice(const QString &deviceName)
@@ -272,193 +334,47 @@ static int yesDialog_wrapper(const char *msg, void *usrptr)
     return xyesDialog((char*)msg);
 }
 
-int crypt_luksFormatBinary(struct crypt_options *options,
-                           const char *pwd,
-                           unsigned int pwdLen)
-{
-    struct crypt_device *cd = NULL;
-    struct crypt_params_luks1 cp = {
-        options->hash,
-        options->align_payload
-    };
-    int r;
-
-    if ((r = crypt_init(&cd, options->device)))
-        return -EINVAL;
-
-    crypt_set_log_callback(cd, log_wrapper, (void*) options->icb->log);
-    crypt_set_confirm_callback(cd, yesDialog_wrapper,
-                               (void*) options->icb->yesDialog);
-
-    crypt_set_timeout(cd, options->timeout);
-    crypt_set_password_retry(cd, options->tries);
-    crypt_set_iterarion_time(cd, options->iteration_time ?: 1000);
-    crypt_set_password_verify(cd, options->flags & CRYPT_FLAG_VERIFY);
-
-    r = crypt_format(cd, CRYPT_LUKS1,
-                     SIGNON_LUKS_CIPHER_NAME, SIGNON_LUKS_CIPHER_MODE,
-                     NULL, NULL, options->key_size, &cp);
-    if (r < 0)
-        goto out;
-
-    /* Add keyslot using internally stored volume key generated during format */
-    r = crypt_keyslot_add_by_volume_key(cd, options->key_slot, NULL, 0,
-                                        pwd, pwdLen);
-out:
-    crypt_free(cd);
-    return (r < 0) ? r : 0;
-
-}
-
-bool CryptsetupHandler::formatFile(const QByteArray &key,
+bool CryptsetupHandler::formatFile(SystemCommandLineCallHandler *handler,
+                                   const QByteArray &key,
                                    const QString &deviceName)
 {
-    struct crypt_options options;
-
-    options.key_size = SIGNON_LUKS_KEY_SIZE / 8;
-    options.key_slot = SIGNON_LUKS_BASE_KEYSLOT;
-
-    char *localDeviceName = (char *)malloc(deviceName.length() + 1);
-    Q_ASSERT(localDeviceName != NULL);
-
-    strcpy(localDeviceName, deviceName.toLatin1().constData());
-    options.device = localDeviceName;
-
-    options.cipher = SIGNON_LUKS_CIPHER;
-    options.new_key_file = NULL;
-
-    char *localKey = (char *)malloc(key.length());
-    Q_ASSERT(localKey != NULL);
-    memcpy(localKey, key.constData(), key.length());
-
-    options.flags = 0;
-    options.iteration_time = 1000;
-    options.timeout = 0;
-    options.align_payload = 0;
-
-    static struct interface_callbacks cmd_icb;
-    cmd_icb.yesDialog = 0;
-    cmd_icb.log = 0;
-    options.icb = &cmd_icb;
-
-    TRACE() << "Device: [" << options.device << "]";
+    TRACE() << "Device: [" << deviceName << "]";
     TRACE() << "Key size:" << key.length();
 
-    int ret = crypt_luksFormatBinary(&options, localKey, key.length());
-
-    if (ret != 0)
-        TRACE() << "LUKS format API call result:" << ret << "." << error();
-
-    if (localDeviceName)
-        free(localDeviceName);
-
-    if (localKey) {
-        memset(localKey, 0x00, key.length());
-        free(localKey);
-    }
-
-    return (ret == 0);
-}
-
-int crypt_luksOpenBinary(struct crypt_options *options,
-                         const char *pwd, unsigned int pwdLen)
-{
-    struct crypt_device *cd = NULL;
-    uint32_t flags = 0;
-    int r;
-
-    if ((r = crypt_init(&cd, options->device)))
-        return -EINVAL;
-
-    crypt_set_log_callback(cd, log_wrapper, (void*) options->icb->log);
-    crypt_set_confirm_callback(cd, yesDialog_wrapper,
-                               (void*) options->icb->yesDialog);
-
-    crypt_set_timeout(cd, options->timeout);
-    crypt_set_password_retry(cd, options->tries);
-    crypt_set_iterarion_time(cd, options->iteration_time ?: 1000);
-    crypt_set_password_verify(cd, options->flags & CRYPT_FLAG_VERIFY);
-
-    if ((r = crypt_load(cd, CRYPT_LUKS1, NULL))) {
-        crypt_free(cd);
-        return r;
-    }
-
-    if (options->flags & CRYPT_FLAG_READONLY)
-        flags |= CRYPT_ACTIVATE_READONLY;
-
-    if (options->flags & CRYPT_FLAG_NON_EXCLUSIVE_ACCESS)
-        flags |= CRYPT_ACTIVATE_NO_UUID;
-
-    if (options->key_file)
-        r = -1;
-    else
-        r = crypt_activate_by_passphrase(cd, options->name,
-                                         CRYPT_ANY_SLOT,
-                                         pwd, pwdLen, flags);
-
-    crypt_free(cd);
-    return (r < 0) ? r : 0;
+    /* The key is passed on std::in, so that it doesn't show up in the
+     * process list */
+    QStringList args;
+    args << QLatin1String("--batch-mode")
+        << QLatin1String("--type") << QLatin1String("luks1")
+        << QLatin1String("--cipher") << QLatin1String(SIGNON_LUKS_CIPHER)
+        << QLatin1String("--key-size") <<
+            QString::number(SIGNON_LUKS_KEY_SIZE)
+        << QLatin1String("--hash") << QLatin1String(SIGNON_LUKS_DEFAULT_HASH)
+        << QLatin1String("--iter-time") << QLatin1String("1000")
+        << QLatin1String("--key-slot") <<
+            QString::number(SIGNON_LUKS_BASE_KEYSLOT)
+        << QLatin1String("--key-file=-")
+        << QLatin1String("luksFormat") << deviceName;
+
+    return handler->startCall(QLatin1String(SIGNON_CRYPTSETUP_APP),
+                              args, key);
 }
 
-bool CryptsetupHandler::openFile(const QByteArray &key,
+bool CryptsetupHandler::openFile(SystemCommandLineCallHandler *handler,
+                                 const QByteArray &key,
                                  const QString &deviceName,
                                  const QString &deviceMap)
 {
-    struct crypt_options options;
-
-    char *localDeviceMap = (char *)malloc(deviceMap.length() + 1);
-    Q_ASSERT(localDeviceMap != NULL);
-    strcpy(localDeviceMap, deviceMap.toLatin1().constData());
-    options.name = localDeviceMap;
-
-    char *localDeviceName = (char *)malloc(deviceName.length() + 1);
-    Q_ASSERT(localDeviceName != NULL);
-    strcpy(localDeviceName, deviceName.toLatin1().constData());
-    options.device = localDeviceName;
-
-    char *localKey = (char *)malloc(key.length());
-    Q_ASSERT(localKey != NULL);
-    memcpy(localKey, key.constData(), key.length());
-
-    options.key_file = NULL;
-    options.timeout = 0;
-    /*
-        Do not change this:
-        1) In case of failure to open, libcryptsetup code will
-        enter infinite loop - library BUG/FEATURE.
-        2) There is no need for multiple tries, option is intended for
-        command line use of the utility.
-    */
-    options.tries = 0;
-    options.flags = 0;
-
-    static struct interface_callbacks cmd_icb;
-    cmd_icb.yesDialog = yesDialog;
-    cmd_icb.log = cmdLineLog;
-    options.icb = &cmd_icb;
-
-    TRACE() << "Device [" << options.device << "]";
-    TRACE() << "Map name [" << options.name << "]";
+    TRACE() << "Device [" << deviceName << "]";
+    TRACE() << "Map name [" << deviceMap << "]";
     TRACE() << "Key size:" << key.length();
 
-    int ret = crypt_luksOpenBinary(&options, localKey, key.length());
+    QStringList args;
+    args << QLatin1String("--key-file=-")
+        << QLatin1String("luksOpen") << deviceName << deviceMap;
 
-    if (ret != 0)
-        TRACE() << "LUKS open API call result:" << ret << "." << error() << ".";
-
-    if (localDeviceName)
-        free(localDeviceName);
-
-    if (localDeviceMap)
-        free(localDeviceMap);
-
-    if (localKey) {
-        memset(localKey, 0x00, key.length());
-        free(localKey);
-    }
-
-    return (ret == 0);
+    return handler->startCall(QLatin1String(SIGNON_CRYPTSETUP_APP),
+                              args, key);
 }
 
 bool CryptsetupHandler::closeFile(const QString &deviceMap)
@@ -649,12 +565,10 @@ bool CryptsetupHandler::removeKeySlot(const QString &deviceName,
     return (ret == 0);
 }
 
-bool CryptsetupHandler::loadDmMod()
+bool CryptsetupHandler::loadDmMod(SystemCommandLineCallHandler *handler)
 {
-    SystemCommandLineCallHandler handler;
-    return handler.makeCall(
-                        QLatin1String("/sbin/modprobe"),
-                        QStringList() << QString::fromLatin1("dm_mod"));
+    return handler->startCall(QLatin1String("/sbin/modprobe"),
+                              QStringList() << QString::fromLatin1("dm_mod"));
 }
 
 QString CryptsetupHandler::error()
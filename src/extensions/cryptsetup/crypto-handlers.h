@@ -68,18 +68,59 @@ public:
                   const QStringList &args,
                   bool readOutput = false);
 
+    /*!
+     * Starts the application at appPath in a separate child process, without
+     * waiting for it: finished() is emitted when the process exits, and its
+     * output is then available from output().
+     * @param appPath Path of the application to be executed.
+     * @param args List of arguments for the executed application.
+     * @param input Data to be written to the std::in of the application.
+     * @returns false if another call is still running, true otherwise.
+     */
+    bool startCall(const QString &appPath,
+                   const QStringList &args,
+                   const QByteArray &input = QByteArray());
+
+    /*!
+     * Blocks until the call started with startCall() is finished; finished()
+     * is emitted before this method returns.
+     */
+    void waitForCall();
+
+    /*!
+     * @returns whether a call started with startCall() is running.
+     */
+    bool isCallRunning() const { return m_isAsyncCall; }
+
+    /*!
+     * Stops the call started with startCall(), if any, without emitting
+     * finished().
+     */
+    void abortCall();
+
     /*!
      * @returns the raw untrimmed output of the last process called with
-     * makeCall and readOutput set to true
+     * makeCall and readOutput set to true, or with startCall.
      */
     QByteArray output() const { return m_output; }
 
+Q_SIGNALS:
+    /*!
+     * Emitted when the process started with startCall() exits.
+     * @param ok Whether the process exited normally with a zero exit code.
+     */
+    void finished(bool ok);
+
 private Q_SLOTS:
     void error(QProcess::ProcessError err);
+    void onFinished(int exitCode, QProcess::ExitStatus exitStatus);
 
 private:
+    void finishCall(bool ok);
+
     QProcess m_process;
     QByteArray m_output;
+    bool m_isAsyncCall;
 
     Q_DISABLE_COPY(SystemCommandLineCallHandler);
 };
@@ -104,13 +145,15 @@ struct PartitionHandler
                                     const quint32 fileSize);
 
     /*!
-     * Formats a file (block device) for a specific file system type
-     * (ext2,ext3,ext4)
+     * Starts formatting a file (block device) for a specific file system type
+     * (ext2,ext3,ext4); the handler emits finished() when done.
+     * @param handler The handler running the mkfs process.
      * @param fileName Name of the file to be formatted.
      * @param fileSystemType Type of the file syste
-     * @returns true upon success, false otherwise.
+     * @returns true if the process was started, false otherwise.
      */
-    static bool formatPartitionFile(const QString &fileName,
+    static bool formatPartitionFile(SystemCommandLineCallHandler *handler,
+                                    const QString &fileName,
                                     const quint32 fileSystemType);
 
 private:
@@ -161,18 +204,30 @@ private:
 struct LosetupHandler
 {
     /*!
-     * Mounts a block device to loopback device.
+     * Starts mounting a block device to loopback device; the handler emits
+     * finished() when done.
+     * @param handler The handler running the losetup process.
      * @param deviceName Loopback device to pe set up.
      * @param blockDevice Block device to be loopback mounted.
+     * @returns true if the process was started, false otherwise.
      */
-    static bool setupDevice(const QString &deviceName,
+    static bool setupDevice(SystemCommandLineCallHandler *handler,
+                            const QString &deviceName,
                             const QString &blockDevice);
 
     /*!
-     * Finds an available loopback device.
+     * Starts looking for an available loopback device; the handler emits
+     * finished() when done, and availableDevice() can then be called.
+     * @param handler The handler running the losetup process.
+     * @returns true if the process was started, false otherwise.
+     */
+    static bool findAvailableDevice(SystemCommandLineCallHandler *handler);
+
+    /*!
+     * @param handler The handler which ran findAvailableDevice().
      * @return the name of a spare device or a null string if none found.
      */
-    static QString findAvailableDevice();
+    static QString availableDevice(const SystemCommandLineCallHandler *handler);
 
     /*!
      * Releases a used loopback device.
@@ -199,19 +254,28 @@ private:
 struct CryptsetupHandler
 {
     /*!
-     * Formats the file system.
+     * Starts formatting the file system, with the cryptsetup tool; the
+     * handler emits finished() when done.
+     * @param  handler, the handler running the cryptsetup process.
      * @param  key, key of the ecrypted file system
      * @param  deviceName, name of the loop device LUKS formatted.
+     * @returns true if the process was started, false otherwise.
      */
-    static bool formatFile(const QByteArray &key, const QString &deviceName);
+    static bool formatFile(SystemCommandLineCallHandler *handler,
+                           const QByteArray &key,
+                           const QString &deviceName);
 
     /*!
-     * Opens the file system.
+     * Starts opening the file system, with the cryptsetup tool; the handler
+     * emits finished() when done.
+     * @param  handler, the handler running the cryptsetup process.
      * @param  key, key of the ecrypted file system
      * @param  deviceName, name of the loop device to be opened.
      * @param  deviceMap, name of the device mapper mapped device.
+     * @returns true if the process was started, false otherwise.
      */
-    static bool openFile(const QByteArray &key,
+    static bool openFile(SystemCommandLineCallHandler *handler,
+                         const QByteArray &key,
                          const QString &deviceName,
                          const QString &deviceMap);
 
@@ -253,10 +317,12 @@ struct CryptsetupHandler
                               const QByteArray &remainingKey);
 
     /*!
-     * Loads the `dm_mod` kernel module
-     * @returns whether the dm_mod was successfully loaded or not.
+     * Starts loading the `dm_mod` kernel module; the handler emits finished()
+     * when done.
+     * @param  handler, the handler running the modprobe process.
+     * @returns true if the process was started, false otherwise.
      */
-    static bool loadDmMod();
+    static bool loadDmMod(SystemCommandLineCallHandler *handler);
 
     /*!
      * @returns the last error as string.
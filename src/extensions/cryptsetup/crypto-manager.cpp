@@ -86,12 +86,14 @@ CryptoManager::CryptoManager(QObject *parent):
     m_fileSystemName(QString()),
     m_fileSystemMountPath(QString()),
     m_loopDeviceName(QString()),
+    m_callHandler(new SystemCommandLineCallHandler),
     m_fileSystemType(Ext2),
     m_fileSystemSize(4)
 {
+    m_callHandler->setParent(this);
+    connect(m_callHandler, SIGNAL(finished(bool)),
+            this, SLOT(onStepFinished(bool)));
     updateMountState(Unmounted);
-    if (!CryptsetupHandler::loadDmMod())
-        BLAME() << "Could not load `dm_mod`!";
 }
 
 CryptoManager::~CryptoManager()
@@ -174,7 +176,7 @@ void CryptoManager::checkFileSystemSetup()
 
 bool CryptoManager::setupFileSystem()
 {
-    if (m_mountState == Mounted) {
+    if (m_mountState == Mounted || isMountInProgress()) {
         TRACE() << "Ecrypyted file system already mounted.";
         return false;
     }
@@ -184,72 +186,18 @@ bool CryptoManager::setupFileSystem()
         return false;
     }
 
-    if (!CryptsetupHandler::loadDmMod()) {
-        BLAME() << "Could not load `dm_mod`!";
-        return false;
-    }
-
     clearFileSystemResources();
 
-    m_loopDeviceName = LosetupHandler::findAvailableDevice();
-    if (m_loopDeviceName.isNull()) {
-        BLAME() << "No free loop device available!";
-        return false;
-    }
-
     if (!PartitionHandler::createPartitionFile(m_fileSystemPath,
                                                m_fileSystemSize)) {
         BLAME() << "Could not create partition file.";
-        unmountFileSystem();
         return false;
     }
     checkFileSystemSetup();
 
-    if (!LosetupHandler::setupDevice(m_loopDeviceName,
-                                     m_fileSystemPath)) {
-        BLAME() << "Failed to setup loop device:" << m_loopDeviceName;
-        unmountFileSystem();
-        return false;
-    }
-    updateMountState(LoopSet);
-
-    if (!CryptsetupHandler::formatFile(encryptionKey(), m_loopDeviceName)) {
-        BLAME() << "Failed to LUKS format.";
-        unmountFileSystem();
-        return false;
-    }
-    updateMountState(LoopLuksFormatted);
-
-    //attempt luks close, in case of a leftover.
-    if (QFile::exists(QLatin1String(DEVICE_MAPPER_DIR) + m_fileSystemName)) {
-        TRACE() << "Filesystem exists, closing";
-        CryptsetupHandler::closeFile(m_fileSystemName);
-    }
-
-    if (!CryptsetupHandler::openFile(encryptionKey(),
-                                     m_loopDeviceName,
-                                     m_fileSystemName)) {
-        BLAME() << "Failed to LUKS open";
-        unmountFileSystem();
-        return false;
-    }
-    updateMountState(LoopLuksOpened);
-
-    if (!PartitionHandler::formatPartitionFile(m_fileSystemMapPath,
-                                               m_fileSystemType)) {
-        BLAME() << "Could not format mapped partition.";
-        unmountFileSystem();
-        return false;
-    }
-
-    if (!mountMappedDevice()) {
-        BLAME() << "Failed to mount ecrypted file system.";
-        unmountFileSystem();
-        return false;
-    }
-
-    addKeyToKeychain(encryptionKey());
-    updateMountState(Mounted);
+    startMountSequence(QList<MountStep>() << LoadDmMod << FindLoopDevice <<
+                       SetupLoopDevice << LuksFormat << LuksOpen <<
+                       FormatMappedDevice);
     return true;
 }
 
@@ -257,7 +205,7 @@ bool CryptoManager::setupFileSystem()
 //failure
 bool CryptoManager::mountFileSystem()
 {
-    if (m_mountState == Mounted) {
+    if (m_mountState == Mounted || isMountInProgress()) {
         TRACE() << "Ecrypyted file system already mounted.";
         return false;
     }
@@ -269,46 +217,143 @@ bool CryptoManager::mountFileSystem()
 
     clearFileSystemResources();
 
-    if (!CryptsetupHandler::loadDmMod()) {
-        BLAME() << "Could not load `dm_mod`!";
-        return false;
-    }
+    startMountSequence(QList<MountStep>() << LoadDmMod << FindLoopDevice <<
+                       SetupLoopDevice << LuksOpen);
+    return true;
+}
 
-    m_loopDeviceName = LosetupHandler::findAvailableDevice();
-    if (m_loopDeviceName.isNull()) {
-        BLAME() << "No free loop device available!";
-        return false;
-    }
+void CryptoManager::startMountSequence(const QList<MountStep> &steps)
+{
+    m_pendingSteps = steps;
+    setFileSystemMounting(true);
+    runNextStep();
+}
 
-    if (!LosetupHandler::setupDevice(m_loopDeviceName, m_fileSystemPath)) {
-        BLAME() << "Failed to setup loop device:" << m_loopDeviceName;
+void CryptoManager::runNextStep()
+{
+    bool isOk = false;
+
+    switch (m_pendingSteps.first()) {
+    case LoadDmMod:
+        isOk = CryptsetupHandler::loadDmMod(m_callHandler);
+        break;
+    case FindLoopDevice:
+        isOk = LosetupHandler::findAvailableDevice(m_callHandler);
+        break;
+    case SetupLoopDevice:
+        isOk = LosetupHandler::setupDevice(m_callHandler,
+                                           m_loopDeviceName,
+                                           m_fileSystemPath);
+        break;
+    case LuksFormat:
+        isOk = CryptsetupHandler::formatFile(m_callHandler,
+                                             encryptionKey(),
+                                             m_loopDeviceName);
+        break;
+    case LuksOpen:
+        //attempt luks close, in case of a leftover.
+        if (QFile::exists(QLatin1String(DEVICE_MAPPER_DIR) +
+                          m_fileSystemName)) {
+            TRACE() << "Filesystem exists, closing";
+            CryptsetupHandler::closeFile(m_fileSystemName);
+        }
+        isOk = CryptsetupHandler::openFile(m_callHandler,
+                                           encryptionKey(),
+                                           m_loopDeviceName,
+                                           m_fileSystemName);
+        break;
+    case FormatMappedDevice:
+        isOk = PartitionHandler::formatPartitionFile(m_callHandler,
+                                                     m_fileSystemMapPath,
+                                                     m_fileSystemType);
+        break;
+    }
+
+    if (!isOk) {
+        BLAME() << "Could not start mount step" << m_pendingSteps.first();
+        m_pendingSteps.clear();
         unmountFileSystem();
-        return false;
     }
-    updateMountState(LoopSet);
-
-    //attempt luks close, in case of a leftover.
-    if (QFile::exists(QLatin1String(DEVICE_MAPPER_DIR) + m_fileSystemName))
-        CryptsetupHandler::closeFile(m_fileSystemName);
+}
 
-    if (!CryptsetupHandler::openFile(encryptionKey(),
-                                     m_loopDeviceName,
-                                     m_fileSystemName)) {
-        BLAME() << "Failed to LUKS open.";
+void CryptoManager::onStepFinished(bool ok)
+{
+    if (!isMountInProgress()) return;
+
+    switch (m_pendingSteps.takeFirst()) {
+    case LoadDmMod:
+        if (!ok)
+            BLAME() << "Could not load `dm_mod`!";
+        break;
+    case FindLoopDevice:
+        m_loopDeviceName = ok ?
+            LosetupHandler::availableDevice(m_callHandler) : QString();
+        if (m_loopDeviceName.isNull()) {
+            BLAME() << "No free loop device available!";
+            ok = false;
+        }
+        break;
+    case SetupLoopDevice:
+        if (ok)
+            updateMountState(LoopSet);
+        else
+            BLAME() << "Failed to setup loop device:" << m_loopDeviceName;
+        break;
+    case LuksFormat:
+        if (ok)
+            updateMountState(LoopLuksFormatted);
+        else
+            BLAME() << "Failed to LUKS format.";
+        break;
+    case LuksOpen:
+        if (ok)
+            updateMountState(LoopLuksOpened);
+        else
+            BLAME() << "Failed to LUKS open.";
+        break;
+    case FormatMappedDevice:
+        if (!ok)
+            BLAME() << "Could not format mapped partition.";
+        break;
+    }
+
+    if (!ok) {
+        m_pendingSteps.clear();
         unmountFileSystem();
-        return false;
+    } else if (m_pendingSteps.isEmpty()) {
+        finishMountSequence();
+    } else {
+        runNextStep();
     }
-    updateMountState(LoopLuksOpened);
+}
 
+void CryptoManager::finishMountSequence()
+{
     if (!mountMappedDevice()) {
-        TRACE() << "Failed to mount ecrypted file system.";
+        BLAME() << "Failed to mount ecrypted file system.";
         unmountFileSystem();
-        return false;
+        return;
     }
 
     addKeyToKeychain(encryptionKey());
     updateMountState(Mounted);
-    return true;
+    setFileSystemMounting(false);
+}
+
+void CryptoManager::abortMountSequence()
+{
+    if (!isMountInProgress()) return;
+
+    TRACE() << "Aborting the mount sequence";
+    m_pendingSteps.clear();
+    m_callHandler->abortCall();
+}
+
+void CryptoManager::waitForMountSequence()
+{
+    /* Each finished step starts the next one, from the finished() signal */
+    while (isMountInProgress() && m_callHandler->isCallRunning())
+        m_callHandler->waitForCall();
 }
 
 void CryptoManager::clearFileSystemResources()
@@ -344,8 +389,11 @@ void CryptoManager::clearFileSystemResources()
 
 bool CryptoManager::unmountFileSystem()
 {
+    abortMountSequence();
+
     if (m_mountState == Unmounted) {
         TRACE() << "Ecrypyted file system not mounted.";
+        setFileSystemMounting(false);
         return true;
     }
 
@@ -377,6 +425,7 @@ bool CryptoManager::unmountFileSystem()
     }
 
     updateMountState(Unmounted);
+    setFileSystemMounting(false);
     return isOk;
 }
 
@@ -440,6 +489,7 @@ bool CryptoManager::addEncryptionKey(const SignOn::Key &key,
     /*
      * TODO -- limit number of stored keys to the total available slots - 1.
      */
+    waitForMountSequence();
     if (m_mountState >= LoopLuksOpened) {
         if (CryptsetupHandler::addKeySlot(
                 m_loopDeviceName, key, existingKey)) {
@@ -455,6 +505,7 @@ bool CryptoManager::addEncryptionKey(const SignOn::Key &key,
 bool CryptoManager::removeEncryptionKey(const SignOn::Key &key,
                                         const SignOn::Key &remainingKey)
 {
+    waitForMountSequence();
     if (m_mountState >= LoopLuksOpened) {
         if (CryptsetupHandler::removeKeySlot(
             m_loopDeviceName, key, remainingKey))
@@ -469,12 +520,21 @@ bool CryptoManager::removeEncryptionKey(const SignOn::Key &key,
 
 bool CryptoManager::encryptionKeyInUse(const SignOn::Key &key)
 {
+    /* The key is not in use until LUKS has accepted it: while the mount
+     * sequence runs, the caller must wait for fileSystemMountFinished() */
+    if (isMountInProgress()) {
+        if (encryptionKey() == key)
+            return false;
+        waitForMountSequence();
+    }
+
     if (fileSystemIsMounted() && (encryptionKey() == key))
         return true;
 
     if(!fileSystemIsMounted()) {
        setEncryptionKey(key);
-       return mountFileSystem();
+       mountFileSystem();
+       return false;
     }
 
     /* Variant that tests if the key is in the LUKS keychain
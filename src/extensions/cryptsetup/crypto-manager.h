@@ -33,13 +33,19 @@
 
 #include <SignOn/AbstractCryptoManager>
 
+#include <QList>
 #include <QObject>
 
+class SystemCommandLineCallHandler;
+
 #define MINUMUM_ENCRYPTED_FILE_SYSTEM_SIZE 4
 
 /*!
  * @class CryptoManager
  * Encrypted file system manager. Uses cryptsetup and LUKS.
+ * The external tools are run asynchronously, so that the daemon keeps
+ * serving requests while the file system is being mounted; the
+ * fileSystemMounted() signal is emitted when the sequence is complete.
  * @ingroup Accounts_and_SSO_Framework
  */
 class CryptoManager: public SignOn::AbstractCryptoManager
@@ -55,6 +61,16 @@ class CryptoManager: public SignOn::AbstractCryptoManager
         Mounted
     };
 
+    /* Steps of the mount sequence, each one running an external process */
+    enum MountStep {
+        LoadDmMod = 0,
+        FindLoopDevice,
+        SetupLoopDevice,
+        LuksFormat,
+        LuksOpen,
+        FormatMappedDevice
+    };
+
     static const uint signonMinumumDbSize;
     static const char signonDefaultFileSystemName[];
     static const char signonDefaultFileSystemType[];
@@ -90,7 +106,8 @@ public:
      * Use mountFileSystem() on subsequent uses. This method handles also the
      * mounting so when using it, a call
      * to mountFileSystem() is not necessary.
-     * @returns true, if successful, false otherwise.
+     * The file system is formatted and mounted asynchronously.
+     * @returns true, if the sequence was started, false otherwise.
      * @warning this method will always format the file system, use carefully.
      */
     bool setupFileSystem();
@@ -104,8 +121,9 @@ public:
     bool deleteFileSystem();
 
     /*!
-     * Mounts the encrypted file system.
-     * @returns true, if successful, false otherwise.
+     * Starts mounting the encrypted file system; fileSystemMounted() is
+     * emitted when done.
+     * @returns true, if the sequence was started, false otherwise.
      */
     bool mountFileSystem();
 
@@ -126,9 +144,9 @@ public:
     QStringList backupFiles() const;
 
     /*!
-     * @attention if the file system is not mounted and the encryption
-     * key can access it, this method will cause the file system to be
-     * mounted.
+     * @attention if the file system is not mounted, this method will start
+     * mounting it with the key `key`, and return false: the key is in use
+     * only if the mount sequence succeeds.
      * @returns whether the key `key` is occupying a keyslot in the encrypted
      * file system.
      */
@@ -138,6 +156,8 @@ public:
      * Adds an encryption key to one of the available keyslots of the LUKS
      * partition's header.
      * Use the `keyTag` parameter in order to store and keep track of the key.
+     * If the file system is being mounted, this method blocks until the
+     * mount sequence is complete.
      * @sa isEncryptionKey(const SignOn::Key &key)
      * @param key The key to be added/set.
      * @param existingKey An already existing key.
@@ -151,12 +171,24 @@ public:
      * @param key The key to be removed.
      * @param remainingKey Another valid key
      * @attention The system cannot remain keyless.
+     * If the file system is being mounted, this method blocks until the
+     * mount sequence is complete.
      * @returns true, if succeeded, false otherwise.
      */
     bool removeEncryptionKey(const SignOn::Key &key,
                              const SignOn::Key &remainingKey);
 
+private Q_SLOTS:
+    void onStepFinished(bool ok);
+
 private:
+    void startMountSequence(const QList<MountStep> &steps);
+    void runNextStep();
+    void finishMountSequence();
+    void abortMountSequence();
+    bool isMountInProgress() const { return !m_pendingSteps.isEmpty(); }
+    void waitForMountSequence();
+
     bool setFileSystemType(const QString &type);
     bool setFileSystemSize(const quint32 size);
     void setFileSystemPath(const QString &path);
@@ -186,6 +218,9 @@ private:
     QString m_fileSystemMountPath;
     QString m_loopDeviceName;
 
+    SystemCommandLineCallHandler *m_callHandler;
+    QList<MountStep> m_pendingSteps;
+
     FileSystemMountState m_mountState;
     FileSystemType m_fileSystemType;
     quint32 m_fileSystemSize;
@@ -4,3 +4,7 @@ SUBDIRS =
 CONFIG(cryptsetup) {
     SUBDIRS += cryptsetup
 }
+
+CONFIG(aead) {
+    SUBDIRS += aead
+}
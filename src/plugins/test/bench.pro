@@ -0,0 +1,11 @@
+TARGET = benchplugin
+
+include( ../plugins.pri )
+
+HEADERS += benchplugin.h \
+           benchdata.h
+
+SOURCES += benchplugin.cpp
+
+headers.files = $$HEADERS
+INSTALLS += headers
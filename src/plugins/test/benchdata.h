@@ -0,0 +1,48 @@
+/*
+ * This file is part of signon
+ *
+ * Copyright (C) 2013 Canonical Ltd.
+ *
+ * Contact: Alberto Mardegan <alberto.mardegan@canonical.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+#ifndef BENCHDATA_H
+#define BENCHDATA_H
+
+#include "SignOn/sessiondata.h"
+
+namespace BenchPluginNS {
+
+/*!
+ * Parameters of the bench plugin.
+ */
+class BenchData: public SignOn::SessionData
+{
+public:
+    /* Opaque data; echoed back by the "echo" mechanism */
+    SIGNON_SESSION_DECLARE_PROPERTY(QByteArray, Payload);
+    /* If set, the Payload of the reply is replaced by one of this size */
+    SIGNON_SESSION_DECLARE_PROPERTY(int, ResponseSize);
+    /* Number of statusChanged() signals emitted before the reply */
+    SIGNON_SESSION_DECLARE_PROPERTY(int, StatusCount);
+    /* If set, store() is called with a Payload of this size before the
+     * reply */
+    SIGNON_SESSION_DECLARE_PROPERTY(int, StoreSize);
+};
+
+}  // namespace BenchPluginNS
+
+#endif // BENCHDATA_H
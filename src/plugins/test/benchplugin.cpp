@@ -0,0 +1,88 @@
+/*
+ * This file is part of signon
+ *
+ * Copyright (C) 2013 Canonical Ltd.
+ *
+ * Contact: Alberto Mardegan <alberto.mardegan@canonical.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+#include "benchplugin.h"
+#include "benchdata.h"
+
+#include "SignOn/signonplugincommon.h"
+
+using namespace SignOn;
+
+namespace BenchPluginNS {
+
+BenchPlugin::BenchPlugin(QObject *parent):
+    AuthPluginInterface(parent)
+{
+}
+
+BenchPlugin::~BenchPlugin()
+{
+}
+
+QString BenchPlugin::type() const
+{
+    return QLatin1String("bench");
+}
+
+QStringList BenchPlugin::mechanisms() const
+{
+    return QStringList() << QLatin1String("noop") << QLatin1String("echo");
+}
+
+void BenchPlugin::cancel()
+{
+}
+
+void BenchPlugin::process(const SignOn::SessionData &inData,
+                          const QString &mechanism)
+{
+    BenchData input = inData.data<BenchData>();
+
+    BenchData response;
+    if (mechanism == QLatin1String("echo")) {
+        response = input;
+    } else if (mechanism != QLatin1String("noop")) {
+        emit error(Error(Error::MechanismNotAvailable,
+                         QLatin1String("The given mechanism is unavailable")));
+        return;
+    }
+
+    for (int i = 0; i < input.StatusCount(); i++) {
+        emit statusChanged(PLUGIN_STATE_WAITING,
+                           QLatin1String("bench plugin status"));
+    }
+
+    if (input.StoreSize() > 0) {
+        BenchData storeData;
+        storeData.setPayload(QByteArray(input.StoreSize(), 'x'));
+        emit store(storeData);
+    }
+
+    if (input.ResponseSize() > 0)
+        response.setPayload(QByteArray(input.ResponseSize(), 'x'));
+
+    emit result(response);
+}
+
+SIGNON_DECL_AUTH_PLUGIN(BenchPlugin)
+
+} //namespace BenchPluginNS
@@ -0,0 +1,57 @@
+/*
+ * This file is part of signon
+ *
+ * Copyright (C) 2013 Canonical Ltd.
+ *
+ * Contact: Alberto Mardegan <alberto.mardegan@canonical.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+#ifndef BENCHPLUGIN_H_
+#define BENCHPLUGIN_H_
+
+#include <QtCore>
+
+#include "SignOn/authpluginif.h"
+
+namespace BenchPluginNS {
+
+/*!
+ * @class BenchPlugin
+ * Plugin which replies right away, without any processing of its own, for
+ * measuring the overhead of the daemon and of the plugin IPC.
+ * The "noop" mechanism replies with empty data, while the "echo" mechanism
+ * replies with the request data; both take the parameters of BenchData.
+ */
+class BenchPlugin: public AuthPluginInterface
+{
+    Q_OBJECT
+    Q_INTERFACES(AuthPluginInterface)
+public:
+    BenchPlugin(QObject *parent = 0);
+    virtual ~BenchPlugin();
+
+public Q_SLOTS:
+    QString type() const;
+    QStringList mechanisms() const;
+    void cancel();
+    void process(const SignOn::SessionData &inData,
+                 const QString &mechanism = 0);
+};
+
+} //namespace BenchPluginNS
+
+#endif /* BENCHPLUGIN_H_ */
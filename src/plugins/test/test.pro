@@ -1,4 +1,5 @@
 TEMPLATE = subdirs
 SUBDIRS = \
     ssotest.pro \
-    ssotest2.pro
+    ssotest2.pro \
+    bench.pro
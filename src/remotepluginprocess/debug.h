@@ -29,9 +29,11 @@
     extern int debugLevel;
 
     #define TRACE() \
-        if (debugLevel >= 2) qDebug() << __FILE__ << __LINE__ << __func__
+        if (debugLevel < 2) {} else \
+            qDebug() << __FILE__ << __LINE__ << __func__
     #define BLAME() \
-        if (debugLevel >= 1) qCritical() << __FILE__ << __LINE__ << __func__
+        if (debugLevel < 1) {} else \
+            qCritical() << __FILE__ << __LINE__ << __func__
 #else
     #define TRACE() while (0) qDebug()
     #define BLAME() while (0) qDebug()
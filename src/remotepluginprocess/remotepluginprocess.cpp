@@ -24,6 +24,7 @@
 #include <QTimer>
 #include <QBuffer>
 #include <QDataStream>
+#include <time.h>
 #include <unistd.h>
 
 #include "debug.h"
@@ -42,6 +43,14 @@ namespace RemotePluginProcessNS {
 
 static CancelEventThread *cancelThread = NULL;
 
+/* Same clock used by signond, in microseconds */
+static qint64 timestamp()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return qint64(now.tv_sec) * 1000000 + now.tv_nsec / 1000;
+}
+
 /* ---------------------- RemotePluginProcess ---------------------- */
 
 RemotePluginProcess::RemotePluginProcess(QObject *parent):
@@ -50,6 +59,7 @@ RemotePluginProcess::RemotePluginProcess(QObject *parent):
     m_plugin = NULL;
     m_readnotifier = NULL;
     m_errnotifier = NULL;
+    m_receivedTime = 0;
 
     qRegisterMetaType<SignOn::SessionData>("SignOn::SessionData");
     qRegisterMetaType<QString>("QString");
@@ -213,6 +223,7 @@ void RemotePluginProcess::result(const SignOn::SessionData &data)
     foreach(QString key, data.propertyNames())
         resultDataMap[key] = data.getProperty(key);
 
+    sendTiming();
     out << (quint32)PLUGIN_RESPONSE_RESULT;
 
     m_blobIOHandler->sendData(resultDataMap);
@@ -239,6 +250,7 @@ void RemotePluginProcess::error(const SignOn::Error &err)
 {
     disableCancelThread();
 
+    sendTiming();
     QDataStream out(&m_outFile);
 
     out << (quint32)PLUGIN_RESPONSE_ERROR;
@@ -260,6 +272,7 @@ void RemotePluginProcess::userActionRequired(const SignOn::UiSessionData &data)
     foreach(QString key, data.propertyNames())
         resultDataMap[key] = data.getProperty(key);
 
+    sendTiming();
     out << (quint32)PLUGIN_RESPONSE_UI;
     m_blobIOHandler->sendData(resultDataMap);
     m_outFile.flush();
@@ -278,6 +291,7 @@ void RemotePluginProcess::refreshed(const SignOn::UiSessionData &data)
 
     m_readnotifier->setEnabled(true);
 
+    sendTiming();
     out << (quint32)PLUGIN_RESPONSE_REFRESHED;
 
     m_blobIOHandler->sendData(resultDataMap);
@@ -298,6 +312,20 @@ void RemotePluginProcess::statusChanged(const AuthPluginState state,
     m_outFile.flush();
 }
 
+void RemotePluginProcess::sendTiming()
+{
+    if (m_receivedTime == 0)
+        return;
+
+    QDataStream out(&m_outFile);
+
+    out << (quint32)PLUGIN_RESPONSE_TIMING;
+    out << m_receivedTime;
+    out << timestamp();
+
+    m_receivedTime = 0;
+}
+
 QString RemotePluginProcess::getPluginName(const QString &type)
 {
     QString dirName = qgetenv("SSO_PLUGINS_DIR");
@@ -368,6 +396,7 @@ void RemotePluginProcess::refresh()
 
 void RemotePluginProcess::sessionDataReceived(const QVariantMap &sessionDataMap)
 {
+    m_receivedTime = timestamp();
     enableCancelThread();
     TRACE() << "The cancel thread is started";
 
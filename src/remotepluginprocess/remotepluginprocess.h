@@ -125,6 +125,8 @@ private:
     //Requiered for async session data reading
     quint32 m_currentOperation;
     QString m_currentMechanism;
+    //When the data of the current operation was received
+    qint64 m_receivedTime;
 
 private:
     QString getPluginName(const QString &type);
@@ -136,6 +138,8 @@ private:
     void userActionFinished();
     void refresh();
 
+    void sendTiming();
+
     void enableCancelThread();
     void disableCancelThread();
 
@@ -37,7 +37,8 @@ QMAKE_LIBDIR += \
 
 LIBS += \
     -lsignon-plugins-common \
-    -lsignon-plugins
+    -lsignon-plugins \
+    -lrt
 
 QMAKE_CXXFLAGS += -fno-exceptions \
                   -fno-rtti
@@ -28,6 +28,7 @@
 #include <QBuffer>
 #include <QDBusConnection>
 #include <QDBusConnectionInterface>
+#include <QDBusPendingReply>
 #ifdef ENABLE_P2P
 #include <dbus/dbus.h>
 #endif
@@ -36,6 +37,10 @@
 #include "signond-common.h"
 #include "credentialsaccessmanager.h"
 #include "signonidentity.h"
+#include "signonmetrics.h"
+
+#undef SIGNON_TRACE_CATEGORY
+#define SIGNON_TRACE_CATEGORY SignOn::AccessControlCategory
 
 using namespace SignonDaemonNS;
 
@@ -47,7 +52,11 @@ AccessControlManagerHelper *AccessControlManagerHelper::instance()
 }
 
 AccessControlManagerHelper::AccessControlManagerHelper(
-                                SignOn::AbstractAccessControlManager *acManager)
+                                SignOn::AbstractAccessControlManager *acManager):
+    QObject(),
+    m_aclGeneration(0),
+    m_cacheHits(0),
+    m_cacheMisses(0)
 {
     if (!m_pInstance) {
         m_pInstance = this;
@@ -59,23 +68,86 @@ AccessControlManagerHelper::AccessControlManagerHelper(
 
 AccessControlManagerHelper::~AccessControlManagerHelper()
 {
+    TRACE() << "Access decisions cache hits:" << m_cacheHits <<
+        "misses:" << m_cacheMisses;
     m_acManager = NULL;
     m_pInstance = NULL;
 }
 
-
 bool AccessControlManagerHelper::isPeerAllowedToUseIdentity(
                                        const QDBusConnection &peerConnection,
                                        const QDBusMessage &peerMessage,
                                        const quint32 identityId)
 {
-    // TODO - improve this, the error handling and more precise behaviour
+    SignonMetrics::instance()->aclChecked(SignonMetrics::IdentityAccessCheck);
 
     CredentialsDB *db = CredentialsAccessManager::instance()->credentialsDB();
     if (db == 0) {
         TRACE() << "NULL db pointer, secure storage might be unavailable,";
         return false;
     }
+    watchCredentialsDB(db);
+
+    QString peer = cacheablePeer(peerConnection, peerMessage);
+    if (!peer.isEmpty()) {
+        int isAllowed = cachedDecision(peer, identityId).isAllowed;
+        if (isAllowed >= 0) {
+            m_cacheHits++;
+            return isAllowed != 0;
+        }
+        m_cacheMisses++;
+    }
+
+    bool dbError = false;
+    bool isAllowed = checkIdentityAccess(peerConnection, peerMessage,
+                                         identityId, db, dbError);
+    if (!peer.isEmpty() && !dbError)
+        decision(peer, identityId).isAllowed = isAllowed ? 1 : 0;
+    return isAllowed;
+}
+
+AccessControlManagerHelper::IdentityOwnership
+AccessControlManagerHelper::isPeerOwnerOfIdentity(
+                                       const QDBusConnection &peerConnection,
+                                       const QDBusMessage &peerMessage,
+                                       const quint32 identityId)
+{
+    SignonMetrics::instance()->aclChecked(SignonMetrics::OwnershipCheck);
+
+    CredentialsDB *db = CredentialsAccessManager::instance()->credentialsDB();
+    if (db == 0) {
+        TRACE() << "NULL db pointer, secure storage might be unavailable,";
+        return ApplicationIsNotOwner;
+    }
+    watchCredentialsDB(db);
+
+    QString peer = cacheablePeer(peerConnection, peerMessage);
+    if (!peer.isEmpty()) {
+        int ownership = cachedDecision(peer, identityId).ownership;
+        if (ownership >= 0) {
+            m_cacheHits++;
+            return IdentityOwnership(ownership);
+        }
+        m_cacheMisses++;
+    }
+
+    bool dbError = false;
+    IdentityOwnership ownership = checkOwnership(peerConnection, peerMessage,
+                                                 identityId, db, dbError);
+    if (!peer.isEmpty() && !dbError)
+        decision(peer, identityId).ownership = ownership;
+    return ownership;
+}
+
+bool AccessControlManagerHelper::checkIdentityAccess(
+                                       const QDBusConnection &peerConnection,
+                                       const QDBusMessage &peerMessage,
+                                       const quint32 identityId,
+                                       CredentialsDB *db,
+                                       bool &dbError)
+{
+    // TODO - improve this, the error handling and more precise behaviour
+
     QStringList acl = db->accessControlList(identityId);
 
     TRACE() << QString(QLatin1String("Access control list of identity: "
@@ -84,8 +156,10 @@ bool AccessControlManagerHelper::isPeerAllowedToUseIdentity(
                                 .arg(acl.join(QLatin1String(", ")))
                                 .arg(acl.size());
 
-    if (db->errorOccurred())
+    if (db->errorOccurred()) {
+        dbError = true;
         return false;
+    }
 
     IdentityOwnership ownership =
         isPeerOwnerOfIdentity(peerConnection, peerMessage, identityId);
@@ -102,20 +176,19 @@ bool AccessControlManagerHelper::isPeerAllowedToUseIdentity(
 }
 
 AccessControlManagerHelper::IdentityOwnership
-AccessControlManagerHelper::isPeerOwnerOfIdentity(
+AccessControlManagerHelper::checkOwnership(
                                        const QDBusConnection &peerConnection,
                                        const QDBusMessage &peerMessage,
-                                       const quint32 identityId)
+                                       const quint32 identityId,
+                                       CredentialsDB *db,
+                                       bool &dbError)
 {
-    CredentialsDB *db = CredentialsAccessManager::instance()->credentialsDB();
-    if (db == 0) {
-        TRACE() << "NULL db pointer, secure storage might be unavailable,";
-        return ApplicationIsNotOwner;
-    }
     QStringList ownerSecContexts = db->ownerList(identityId);
 
-    if (db->errorOccurred())
+    if (db->errorOccurred()) {
+        dbError = true;
         return ApplicationIsNotOwner;
+    }
 
     if (ownerSecContexts.isEmpty())
         return IdentityDoesNotHaveOwner;
@@ -124,11 +197,117 @@ AccessControlManagerHelper::isPeerOwnerOfIdentity(
         ApplicationIsOwner : ApplicationIsNotOwner;
 }
 
+QString AccessControlManagerHelper::cacheablePeer(
+                                       const QDBusConnection &peerConnection,
+                                       const QDBusMessage &peerMessage)
+{
+    /* Only the decisions about peers having a unique bus name can be cached:
+     * unique names are never reused, and we get notified when they go away.
+     */
+    QString service = peerMessage.service();
+    if (!service.startsWith(QLatin1Char(':')))
+        return QString();
+
+    return watchPeer(peerConnection, service) ? service : QString();
+}
+
+bool AccessControlManagerHelper::watchPeer(const QDBusConnection &connection,
+                                           const QString &uniqueName)
+{
+    if (m_watchedPeers.contains(uniqueName))
+        return true;
+
+    if (!connection.isConnected()) {
+        BLAME() << "Couldn't watch the peers of" << connection.name();
+        return false;
+    }
+
+    /* Only the cached peers are watched, not every name on the bus */
+    QDBusServiceWatcher *watcher = m_peerWatchers.value(connection.name(), 0);
+    if (watcher == 0) {
+        watcher = new QDBusServiceWatcher(this);
+        watcher->setConnection(connection);
+        watcher->setWatchMode(QDBusServiceWatcher::WatchForUnregistration);
+        connect(watcher, SIGNAL(serviceUnregistered(const QString&)),
+                this, SLOT(onPeerUnregistered(const QString&)));
+        m_peerWatchers.insert(connection.name(), watcher);
+    }
+
+    watcher->addWatchedService(uniqueName);
+    m_watchedPeers.insert(uniqueName);
+    return true;
+}
+
+quint32 AccessControlManagerHelper::generation(quint32 identityId) const
+{
+    /* Both counters only grow, so the sum changes whenever either does */
+    return m_aclGeneration + m_identityGenerations.value(identityId);
+}
+
+AccessControlManagerHelper::Decision
+AccessControlManagerHelper::cachedDecision(const QString &peer,
+                                           quint32 identityId) const
+{
+    Decision decision = m_decisions.value(peer).value(identityId);
+    if (decision.generation != generation(identityId))
+        return Decision();
+    return decision;
+}
+
+AccessControlManagerHelper::Decision &
+AccessControlManagerHelper::decision(const QString &peer, quint32 identityId)
+{
+    Decision &decision = m_decisions[peer][identityId];
+    quint32 currentGeneration = generation(identityId);
+    if (decision.generation != currentGeneration) {
+        decision = Decision();
+        decision.generation = currentGeneration;
+    }
+    return decision;
+}
+
+void AccessControlManagerHelper::watchCredentialsDB(CredentialsDB *db)
+{
+    /* The DB object is recreated when the credentials system is reopened */
+    if (m_db == db) return;
+
+    m_db = db;
+    m_decisions.clear();
+    m_identityGenerations.clear();
+    connect(db, SIGNAL(accessControlChanged(quint32)),
+            this, SLOT(onIdentityChanged(quint32)));
+}
+
+void AccessControlManagerHelper::onIdentityChanged(quint32 identityId)
+{
+    /* 0 means that the whole DB has been cleared */
+    if (identityId == 0)
+        m_aclGeneration++;
+    else
+        m_identityGenerations[identityId]++;
+}
+
+void AccessControlManagerHelper::onPeerUnregistered(const QString &uniqueName)
+{
+    QDBusServiceWatcher *watcher =
+        qobject_cast<QDBusServiceWatcher *>(sender());
+    if (watcher != 0)
+        watcher->removeWatchedService(uniqueName);
+    m_watchedPeers.remove(uniqueName);
+
+    /* A pending PID lookup is left to complete: its result is not cached,
+     * since the peer is not watched anymore */
+    m_decisions.remove(uniqueName);
+    m_peerPids.remove(uniqueName);
+}
+
 bool
 AccessControlManagerHelper::isPeerKeychainWidget(
                                        const QDBusConnection &peerConnection,
                                        const QDBusMessage &peerMessage)
 {
+    SignonMetrics::instance()->aclChecked(SignonMetrics::KeychainWidgetCheck);
+
     static QString keychainWidgetAppId = m_acManager->keychainWidgetAppId();
     QString peerAppId = appIdOfPeer(peerConnection, peerMessage);
     return (peerAppId == keychainWidgetAppId);
@@ -138,8 +317,9 @@ QString AccessControlManagerHelper::appIdOfPeer(
                                        const QDBusConnection &peerConnection,
                                        const QDBusMessage &peerMessage)
 {
-    TRACE() << m_acManager->appIdOfPeer(peerConnection, peerMessage);
-    return m_acManager->appIdOfPeer(peerConnection, peerMessage);
+    QString appId = m_acManager->appIdOfPeer(peerConnection, peerMessage);
+    TRACE() << appId;
+    return appId;
 }
 
 bool
@@ -166,6 +346,7 @@ AccessControlManagerHelper::isPeerAllowedToAccess(
                                        const QString securityContext)
 {
     TRACE() << securityContext;
+    SignonMetrics::instance()->aclChecked(SignonMetrics::SecurityContextCheck);
     return m_acManager->isPeerAllowedToAccess(peerConnection, peerMessage,
                                               securityContext);
 }
@@ -196,11 +377,103 @@ pid_t AccessControlManagerHelper::pidOfPeer(
         BLAME() << "Empty caller name, and no P2P support enabled";
         return 0;
 #endif
+    } else if (m_pInstance != 0 && service.startsWith(QLatin1Char(':'))) {
+        return m_pInstance->cachedPidOfPeer(peerConnection, service);
     } else {
         return peerConnection.interface()->servicePid(service).value();
     }
 }
 
+void AccessControlManagerHelper::prefetchPidOfPeer(
+                                       const QDBusConnection &peerConnection,
+                                       const QDBusMessage &peerMessage)
+{
+    QString service = peerMessage.service();
+    if (!service.startsWith(QLatin1Char(':')) ||
+        m_peerPids.contains(service) ||
+        m_pendingPids.contains(service) ||
+        !watchPeer(peerConnection, service))
+        return;
+
+    QDBusPendingCallWatcher *watcher =
+        new QDBusPendingCallWatcher(requestPeerPid(peerConnection, service),
+                                    this);
+    watcher->setProperty("peer", service);
+    connect(watcher, SIGNAL(finished(QDBusPendingCallWatcher*)),
+            this, SLOT(onPeerPidReply(QDBusPendingCallWatcher*)));
+    m_pendingPids.insert(service, watcher);
+}
+
+pid_t AccessControlManagerHelper::cachedPidOfPeer(
+                                       const QDBusConnection &peerConnection,
+                                       const QString &uniqueName)
+{
+    QHash<QString, pid_t>::const_iterator it = m_peerPids.find(uniqueName);
+    if (it != m_peerPids.constEnd())
+        return it.value();
+
+    /* Callers which can wait should use prefetchPidOfPeer() instead: this
+     * blocks, but costs at most one round trip to the bus daemon */
+    pid_t pid;
+    QDBusPendingCallWatcher *watcher = m_pendingPids.take(uniqueName);
+    if (watcher != 0) {
+        watcher->waitForFinished();
+        pid = pidFromReply(*watcher);
+        watcher->deleteLater();
+        /* Someone might be waiting for the signal */
+        QMetaObject::invokeMethod(this, "peerPidResolved",
+                                  Qt::QueuedConnection,
+                                  Q_ARG(QString, uniqueName));
+    } else {
+        pid = peerConnection.interface()->servicePid(uniqueName).value();
+    }
+
+    /* Unless the peer is watched we would not know when to drop the entry */
+    if (pid != 0 && watchPeer(peerConnection, uniqueName))
+        m_peerPids.insert(uniqueName, pid);
+    return pid;
+}
+
+void AccessControlManagerHelper::onPeerPidReply(
+                                       QDBusPendingCallWatcher *watcher)
+{
+    QString peer = watcher->property("peer").toString();
+    if (m_pendingPids.value(peer) != watcher) return;
+
+    m_pendingPids.remove(peer);
+    watcher->deleteLater();
+
+    pid_t pid = pidFromReply(*watcher);
+    if (pid != 0 && m_watchedPeers.contains(peer))
+        m_peerPids.insert(peer, pid);
+    Q_EMIT peerPidResolved(peer);
+}
+
+QDBusPendingCall AccessControlManagerHelper::requestPeerPid(
+                                       const QDBusConnection &peerConnection,
+                                       const QString &uniqueName)
+{
+    /* Unlike GetConnectionCredentials, this is supported by any bus daemon */
+    QDBusMessage msg = QDBusMessage::createMethodCall(
+                                 QLatin1String("org.freedesktop.DBus"),
+                                 QLatin1String("/org/freedesktop/DBus"),
+                                 QLatin1String("org.freedesktop.DBus"),
+                                 QLatin1String("GetConnectionUnixProcessID"));
+    msg << uniqueName;
+    return peerConnection.asyncCall(msg);
+}
+
+pid_t AccessControlManagerHelper::pidFromReply(const QDBusPendingCall &call)
+{
+    QDBusPendingReply<uint> reply = call;
+    if (reply.isError()) {
+        BLAME() << "Couldn't get PID of caller:" << reply.error().name();
+        return 0;
+    }
+
+    return reply.value();
+}
+
 SignOn::AccessReply *
 AccessControlManagerHelper::requestAccessToIdentity(
                                        const QDBusConnection &peerConnection,
@@ -37,19 +37,32 @@
 #include <QDBusConnection>
 #include <QDBusContext>
 #include <QDBusMessage>
+#include <QDBusPendingCallWatcher>
+#include <QDBusServiceWatcher>
+#include <QHash>
+#include <QObject>
+#include <QPointer>
+#include <QSet>
 
 #include "signonauthsession.h"
 #include "SignOn/abstract-access-control-manager.h"
 
 namespace SignonDaemonNS {
 
+class CredentialsDB;
+
 /*!
  * @class AccessControlManagerHelper
- * Contains helper functions related to Access Control
+ * Contains helper functions related to Access Control.
+ * The decisions taken for peers connected to the bus and their process IDs
+ * are cached until the peer disconnects; the decisions about an identity are
+ * also dropped when that identity is modified.
  * @ingroup Accounts_and_SSO_Framework
  */
-class AccessControlManagerHelper
+class AccessControlManagerHelper: public QObject
 {
+    Q_OBJECT
+
 public:
     /*!
      * @enum IdentityOwnership
@@ -74,6 +87,23 @@ public:
     static pid_t pidOfPeer(const QDBusConnection &peerConnection,
                            const QDBusMessage &peerMessage);
 
+    /*!
+     * Starts resolving the process id of the peer in the background, so that
+     * a later pidOfPeer() call will not block on the bus daemon.
+     * @param peerConnection the connection over which the message was sent.
+     * @param peerMessage, the request message sent over DBUS by the process.
+     */
+    void prefetchPidOfPeer(const QDBusConnection &peerConnection,
+                           const QDBusMessage &peerMessage);
+
+    /*!
+     * @param peerMessage, the request message sent over DBUS by the process.
+     * @returns true if the process id of the peer is being resolved; the
+     * peerPidResolved() signal will be emitted once that is done.
+     */
+    bool isPidOfPeerPending(const QDBusMessage &peerMessage) const
+        { return m_pendingPids.contains(peerMessage.service()); }
+
     /* creating an instance of a class */
     static AccessControlManagerHelper *instance();
 
@@ -187,9 +217,77 @@ public:
                                 const QDBusMessage &peerMessage,
                                 quint32 id);
 
+    /* statistics of the access decisions cache */
+    quint64 cacheHits() const { return m_cacheHits; }
+    quint64 cacheMisses() const { return m_cacheMisses; }
+
+Q_SIGNALS:
+    /*!
+     * Emitted when a lookup started by prefetchPidOfPeer() is over; if it
+     * succeeded, pidOfPeer() will not block for this peer.
+     */
+    void peerPidResolved(const QString &uniqueName);
+
+private Q_SLOTS:
+    void onIdentityChanged(quint32 identityId);
+    void onPeerUnregistered(const QString &uniqueName);
+    void onPeerPidReply(QDBusPendingCallWatcher *watcher);
+
+private:
+    /* Access decisions about an identity; -1 means not known */
+    struct Decision {
+        Decision(): generation(0), isAllowed(-1), ownership(-1) {}
+        quint32 generation;
+        int isAllowed;
+        int ownership;
+    };
+    typedef QHash<quint32, Decision> PeerDecisions;
+
+    bool watchPeer(const QDBusConnection &connection,
+                   const QString &uniqueName);
+    QString cacheablePeer(const QDBusConnection &peerConnection,
+                          const QDBusMessage &peerMessage);
+    pid_t cachedPidOfPeer(const QDBusConnection &peerConnection,
+                          const QString &uniqueName);
+    static QDBusPendingCall requestPeerPid(
+                                       const QDBusConnection &peerConnection,
+                                       const QString &uniqueName);
+    static pid_t pidFromReply(const QDBusPendingCall &call);
+    quint32 generation(quint32 identityId) const;
+    Decision cachedDecision(const QString &peer, quint32 identityId) const;
+    Decision &decision(const QString &peer, quint32 identityId);
+    void watchCredentialsDB(CredentialsDB *db);
+
+    bool checkIdentityAccess(const QDBusConnection &peerConnection,
+                             const QDBusMessage &peerMessage,
+                             const quint32 identityId,
+                             CredentialsDB *db,
+                             bool &dbError);
+    IdentityOwnership checkOwnership(const QDBusConnection &peerConnection,
+                                     const QDBusMessage &peerMessage,
+                                     const quint32 identityId,
+                                     CredentialsDB *db,
+                                     bool &dbError);
+
 private:
     SignOn::AbstractAccessControlManager *m_acManager;
     static AccessControlManagerHelper* m_pInstance;
+
+    /* cached decisions, by unique bus name of the peer */
+    QHash<QString, PeerDecisions> m_decisions;
+    /* incremented whenever an identity changes, to expire the decisions;
+     * m_aclGeneration is for changes affecting all the identities */
+    QHash<quint32, quint32> m_identityGenerations;
+    quint32 m_aclGeneration;
+    QPointer<CredentialsDB> m_db;
+    /* watchers of the cached peers, by connection name */
+    QHash<QString, QDBusServiceWatcher *> m_peerWatchers;
+    QSet<QString> m_watchedPeers;
+    /* process IDs of the peers, by unique bus name */
+    QHash<QString, pid_t> m_peerPids;
+    QHash<QString, QDBusPendingCallWatcher *> m_pendingPids;
+    quint64 m_cacheHits;
+    quint64 m_cacheMisses;
 };
 
 } // namespace SignonDaemonNS
@@ -59,6 +59,8 @@ CAMConfiguration::CAMConfiguration():
     m_encryptionPassphrase(QByteArray())
 {
     setStoragePath(QLatin1String(signonDefaultStoragePath));
+    /* Crypto managers which don't use an image need it for the backup */
+    addSetting(QLatin1String("SecretsDbName"), m_secretsDbName);
 }
 
 void CAMConfiguration::serialize(QIODevice *device)
@@ -109,6 +111,20 @@ QString CAMConfiguration::secretsStorageName() const
     return m_settings.value(QLatin1String("SecretsStorage")).toString();
 }
 
+int CAMConfiguration::metadataReaderThreads() const
+{
+    return m_settings.value(QLatin1String("MetadataReaderThreads")).toInt();
+}
+
+qint64 CAMConfiguration::secretsCacheMaxSize() const
+{
+    QVariant value = m_settings.value(QLatin1String("SecretsCacheMaxSize"));
+    bool ok = false;
+    qint64 kiloBytes = value.toLongLong(&ok);
+    if (!ok) kiloBytes = signonDefaultSecretsCacheMaxSize;
+    return kiloBytes * 1024;
+}
+
 void CAMConfiguration::setStoragePath(const QString &storagePath) {
     m_storagePath = storagePath;
     if (m_storagePath.startsWith(QLatin1Char('~')))
@@ -130,6 +146,7 @@ CredentialsAccessManager::CredentialsAccessManager(
     m_error(NoError),
     keyManagers(),
     m_pCredentialsDB(NULL),
+    m_pCredentialsDBWorker(NULL),
     m_cryptoManager(NULL),
     m_keyHandler(NULL),
     m_keyAuthorizer(NULL),
@@ -445,17 +462,28 @@ bool CredentialsAccessManager::openMetaDataDB()
     QString dbPath = m_CAMConfiguration.metadataDBPath();
 
     m_pCredentialsDB = new CredentialsDB(dbPath, m_secretsStorage);
+    m_pCredentialsDB->setSecretsCacheMaxSize(
+        m_CAMConfiguration.secretsCacheMaxSize());
 
     if (!m_pCredentialsDB->init()) {
         m_error = CredentialsDbConnectionError;
         return false;
     }
 
+    m_pCredentialsDBWorker =
+        new CredentialsDBWorker(dbPath,
+                                m_CAMConfiguration.metadataReaderThreads());
+
     return true;
 }
 
 void CredentialsAccessManager::closeMetaDataDB()
 {
+    if (m_pCredentialsDBWorker) {
+        delete m_pCredentialsDBWorker;
+        m_pCredentialsDBWorker = NULL;
+    }
+
     if (m_pCredentialsDB) {
         delete m_pCredentialsDB;
         m_pCredentialsDB = NULL;
@@ -527,6 +555,13 @@ CredentialsDB *CredentialsAccessManager::credentialsDB() const
     return m_pCredentialsDB;
 }
 
+CredentialsDBWorker *CredentialsAccessManager::credentialsDBWorker() const
+{
+    RETURN_IF_NOT_INITIALIZED(NULL);
+
+    return m_pCredentialsDBWorker;
+}
+
 bool CredentialsAccessManager::isCredentialsSystemReady() const
 {
     return (m_keyHandler != 0) ? m_keyHandler->isReady() : true;
@@ -33,6 +33,7 @@
 
 #include "accesscontrolmanagerhelper.h"
 #include "credentialsdb.h"
+#include "credentialsdbworker.h"
 #include "signonui_interface.h"
 
 #include <QObject>
@@ -137,6 +138,18 @@ struct CAMConfiguration
      */
     QString secretsStorageName() const;
 
+    /*!
+     * Returns the number of threads reading the metadata DB; 0 means that a
+     * default depending on the number of CPU cores is used.
+     */
+    int metadataReaderThreads() const;
+
+    /*!
+     * Returns the maximum memory, in bytes, used to cache the secrets while
+     * the secure storage is not available; 0 means no limit.
+     */
+    qint64 secretsCacheMaxSize() const;
+
     void setStoragePath(const QString &storagePath);
 
     void addSetting(const QString &key, const QVariant &value) {
@@ -340,6 +353,12 @@ public:
      */
     CredentialsDB *credentialsDB() const;
 
+    /*!
+     * @returns the pool of threads running read-only queries on the metadata
+     * DB.
+     */
+    CredentialsDBWorker *credentialsDBWorker() const;
+
     /*!
      * @returns the CAM in use configuration.
      */
@@ -396,6 +415,7 @@ private:
     QList<SignOn::AbstractKeyManager *> keyManagers;
 
     CredentialsDB *m_pCredentialsDB;
+    CredentialsDBWorker *m_pCredentialsDBWorker;
     SignOn::AbstractCryptoManager *m_cryptoManager;
     SignOn::KeyHandler *m_keyHandler;
     SignOn::AbstractKeyAuthorizer *m_keyAuthorizer;
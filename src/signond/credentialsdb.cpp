@@ -23,12 +23,19 @@
  * 02110-1301 USA
  */
 
+#include <QSet>
+#include <QTimer>
+
 #include "credentialsdb.h"
 #include "credentialsdb_p.h"
 #include "signond-common.h"
 #include "signonidentityinfo.h"
+#include "signonmetrics.h"
 #include "signonsessioncoretools.h"
 
+#undef SIGNON_TRACE_CATEGORY
+#define SIGNON_TRACE_CATEGORY SignOn::DatabaseCategory
+
 #define INIT_ERROR() ErrorMonitor errorMonitor(this)
 #define RETURN_IF_NO_SECRETS_DB(retval) \
     if (!isSecretsDBOpen()) { \
@@ -38,10 +45,82 @@
 
 #define S(s) QLatin1String(s)
 
+/* Maximum time spent storing the secrets cache in one go, in ms */
+#define SECRETS_CACHE_FLUSH_SLICE 20
+/* Number of cached entries stored in a single batch */
+#define SECRETS_CACHE_FLUSH_BATCH 32
+
 namespace SignonDaemonNS {
 
 static const QString driver = QLatin1String("QSQLITE");
 
+/* A reply whose secrets are already known: served from the secrets cache,
+ * or empty */
+class CachedSecretsReply: public SignOn::SecretsReply
+{
+public:
+    CachedSecretsReply(quint32 id, quint32 method, QObject *parent):
+        SignOn::SecretsReply(id, method, parent)
+    {
+        QMetaObject::invokeMethod(this, "finish", Qt::QueuedConnection);
+    }
+
+    using SignOn::SecretsReply::setCredentials;
+    using SignOn::SecretsReply::setData;
+};
+
+/* Overwrites the contents of @string before it is released */
+static void wipe(QString &string)
+{
+    if (string.isEmpty()) return;
+    QChar *data = string.data();
+    memset(data, 0, string.size() * sizeof(QChar));
+    string.clear();
+}
+
+static void wipe(QVariantMap &map)
+{
+    QVariantMap::iterator i;
+    for (i = map.begin(); i != map.end(); ++i) {
+        QVariant &value = i.value();
+        if (value.type() == QVariant::String) {
+            QString string = value.toString();
+            value = QVariant();
+            wipe(string);
+        } else if (value.type() == QVariant::ByteArray) {
+            QByteArray array = value.toByteArray();
+            value = QVariant();
+            array.fill('\0');
+        } else if (value.type() == QVariant::Map) {
+            QVariantMap nested = value.toMap();
+            value = QVariant();
+            wipe(nested);
+        }
+    }
+    map.clear();
+}
+
+static int stringSize(const QString &string)
+{
+    return string.size() * sizeof(QChar);
+}
+
+/* An estimate of the memory used by @data: the serialized size, which is
+ * also what limits the size of the data in the secrets DB */
+static int dataSize(const QVariantMap &data)
+{
+    QByteArray array;
+    QDataStream stream(&array, QIODevice::WriteOnly);
+    stream << data;
+    return array.size();
+}
+
+void SecretsCache::setMaxSize(qint64 maxSize)
+{
+    m_maxSize = qMax(maxSize, qint64(0));
+    evict();
+}
+
 bool SecretsCache::lookupCredentials(quint32 id,
                                      QString &username,
                                      QString &password) const
@@ -56,9 +135,14 @@ bool SecretsCache::lookupCredentials(quint32 id,
     return true;
 }
 
-QVariantMap SecretsCache::lookupData(quint32 id, quint32 method) const
+QVariantMap SecretsCache::lookupData(quint32 id, quint32 method)
 {
-    return m_cache.value(id).m_blobData.value(method);
+    QHash<quint32, AuthCache>::iterator i = m_cache.find(id);
+    if (i == m_cache.end() || !i->m_blobData.contains(method))
+        return QVariantMap();
+
+    touch(id, *i, method);
+    return i->m_blobData.value(method);
 }
 
 void SecretsCache::updateCredentials(quint32 id,
@@ -69,9 +153,13 @@ void SecretsCache::updateCredentials(quint32 id,
     if (id == 0) return;
 
     AuthCache &credentials = m_cache[id];
+    dropCredentials(credentials);
     credentials.m_username = username;
     credentials.m_password = password;
     credentials.m_storePassword = storePassword;
+    credentials.m_hasCredentials = true;
+    addSize(stringSize(username) + stringSize(password));
+    evict();
 }
 
 void SecretsCache::updateData(quint32 id, quint32 method,
@@ -80,46 +168,212 @@ void SecretsCache::updateData(quint32 id, quint32 method,
     if (id == 0) return;
 
     AuthCache &credentials = m_cache[id];
+    dropData(credentials, method);
+    int size = dataSize(data);
     credentials.m_blobData[method] = data;
+    credentials.m_blobSize[method] = size;
+    touch(id, credentials, method);
+    addSize(size);
+    evict();
+}
+
+bool SecretsCache::hasCredentials(quint32 id) const
+{
+    QHash<quint32, AuthCache>::const_iterator i = m_cache.find(id);
+    return i != m_cache.constEnd() && i->m_hasCredentials;
+}
+
+bool SecretsCache::hasData(quint32 id, quint32 method) const
+{
+    QHash<quint32, AuthCache>::const_iterator i = m_cache.find(id);
+    return i != m_cache.constEnd() && i->m_blobData.contains(method);
+}
+
+void SecretsCache::removeCredentials(quint32 id)
+{
+    QHash<quint32, AuthCache>::iterator i = m_cache.find(id);
+    if (i == m_cache.end()) return;
+
+    dropCredentials(*i);
+    if (i->m_blobData.isEmpty())
+        m_cache.erase(i);
 }
 
-void
-SecretsCache::storeToDB(SignOn::AbstractSecretsStorage *secretsStorage) const
+void SecretsCache::removeData(quint32 id, quint32 method)
 {
-    if (m_cache.isEmpty()) return;
+    QHash<quint32, AuthCache>::iterator i = m_cache.find(id);
+    if (i == m_cache.end()) return;
+
+    if (method == 0) {
+        foreach (quint32 blobMethod, i->m_blobData.keys())
+            dropData(*i, blobMethod);
+    } else {
+        dropData(*i, method);
+    }
+
+    if (i->m_blobData.isEmpty() && !i->m_hasCredentials)
+        m_cache.erase(i);
+}
+
+void SecretsCache::remove(quint32 id)
+{
+    QHash<quint32, AuthCache>::iterator i = m_cache.find(id);
+    if (i != m_cache.end())
+        dropEntry(i);
+}
+
+int SecretsCache::storeToDB(SignOn::AbstractSecretsStorage *secretsStorage,
+                            int maxTime)
+{
+    if (m_cache.isEmpty()) return 0;
 
     TRACE() << "Storing cached credentials into permanent storage";
 
-    QHash<quint32, AuthCache>::const_iterator i;
-    for (i = m_cache.constBegin();
-         i != m_cache.constEnd();
-         i++) {
-        quint32 id = i.key();
-        const AuthCache &cache = i.value();
-
-        /* Store the credentials */
-        QString password = cache.m_storePassword ?
-            cache.m_password : QString();
-        if (!cache.m_username.isEmpty() || !password.isEmpty()) {
-            secretsStorage->updateCredentials(id,
-                                              cache.m_username,
-                                              password);
+    QElapsedTimer timer;
+    timer.start();
+
+    int stored = 0;
+    while (!m_cache.isEmpty()) {
+        QList<quint32> ids;
+        QList<SignOn::SecretsCredentials> credentials;
+        QList<SignOn::SecretsData> data;
+
+        QHash<quint32, AuthCache>::const_iterator i = m_cache.constBegin();
+        for (; ids.count() < SECRETS_CACHE_FLUSH_BATCH &&
+             i != m_cache.constEnd(); i++) {
+            quint32 id = i.key();
+            ids.append(id);
+            const AuthCache &cache = i.value();
+
+            /* The credentials */
+            QString password = cache.m_storePassword ?
+                cache.m_password : QString();
+            if (!cache.m_username.isEmpty() || !password.isEmpty()) {
+                credentials.append(
+                    SignOn::SecretsCredentials(id, cache.m_username,
+                                               password));
+            }
+
+            /* Any binary blobs */
+            QHash<quint32, QVariantMap>::const_iterator j;
+            for (j = cache.m_blobData.constBegin();
+                 j != cache.m_blobData.constEnd();
+                 j++) {
+                data.append(SignOn::SecretsData(id, j.key(), j.value()));
+            }
         }
 
-        /* Store any binary blobs */
-        QHash<quint32, QVariantMap>::const_iterator j;
-        for (j = cache.m_blobData.constBegin();
-             j != cache.m_blobData.constEnd();
-             j++) {
-            quint32 method = j.key();
-            secretsStorage->storeData(id, method, j.value());
+        /* A failed batch is rolled back as a whole: store its items one by
+         * one, so that only the faulty ones are lost */
+        if (!credentials.isEmpty() &&
+            !secretsStorage->updateCredentialsBatch(credentials)) {
+            BLAME() << "Could not store the cached credentials as a batch";
+            for (int k = 0; k < credentials.count(); k++) {
+                const SignOn::SecretsCredentials &item = credentials[k];
+                if (!secretsStorage->updateCredentials(item.id,
+                                                       item.username,
+                                                       item.password))
+                    BLAME() << "Could not store the cached credentials of" <<
+                        item.id;
+            }
+        }
+        if (!data.isEmpty() && !secretsStorage->storeDataBatch(data)) {
+            BLAME() << "Could not store the cached data as a batch";
+            for (int k = 0; k < data.count(); k++) {
+                const SignOn::SecretsData &item = data[k];
+                if (!secretsStorage->storeData(item.id, item.method,
+                                               item.data))
+                    BLAME() << "Could not store the cached data of" <<
+                        item.id << item.method;
+            }
         }
+
+        for (int k = 0; k < credentials.count(); k++)
+            wipe(credentials[k].password);
+        for (int k = 0; k < data.count(); k++)
+            wipe(data[k].data);
+
+        foreach (quint32 id, ids)
+            dropEntry(m_cache.find(id));
+        stored += ids.count();
+        if (timer.elapsed() >= maxTime) break;
     }
+
+    return stored;
 }
 
 void SecretsCache::clear()
 {
-    m_cache.clear();
+    while (!m_cache.isEmpty())
+        dropEntry(m_cache.begin());
+}
+
+void SecretsCache::dropCredentials(AuthCache &cache)
+{
+    if (!cache.m_hasCredentials) return;
+
+    addSize(-(stringSize(cache.m_username) + stringSize(cache.m_password)));
+    wipe(cache.m_username);
+    wipe(cache.m_password);
+    cache.m_hasCredentials = false;
+}
+
+void SecretsCache::dropData(AuthCache &cache, quint32 method)
+{
+    QHash<quint32, QVariantMap>::iterator i = cache.m_blobData.find(method);
+    if (i == cache.m_blobData.end()) return;
+
+    addSize(-cache.m_blobSize.take(method));
+    m_lru.remove(cache.m_blobUse.take(method));
+    wipe(i.value());
+    cache.m_blobData.erase(i);
+}
+
+void SecretsCache::dropEntry(QHash<quint32, AuthCache>::iterator i)
+{
+    dropCredentials(*i);
+    foreach (quint32 method, i->m_blobData.keys())
+        dropData(*i, method);
+    m_cache.erase(i);
+}
+
+void SecretsCache::touch(quint32 id, AuthCache &cache, quint32 method)
+{
+    QHash<quint32, quint64>::iterator i = cache.m_blobUse.find(method);
+    if (i != cache.m_blobUse.end())
+        m_lru.remove(i.value());
+
+    quint64 use = ++m_useCounter;
+    cache.m_blobUse[method] = use;
+    m_lru.insert(use, BlobKey(id, method));
+}
+
+void SecretsCache::addSize(qint64 size)
+{
+    m_statistics.size += size;
+    if (m_statistics.size > m_statistics.peakSize)
+        m_statistics.peakSize = m_statistics.size;
+}
+
+void SecretsCache::evict()
+{
+    if (m_maxSize == 0) return;
+
+    while (m_statistics.size > m_maxSize && !m_lru.isEmpty()) {
+        BlobKey key = m_lru.begin().value();
+        QHash<quint32, AuthCache>::iterator i = m_cache.find(key.first);
+        Q_ASSERT(i != m_cache.end());
+
+        qint64 size = i->m_blobSize.value(key.second);
+        TRACE() << "Evicting cached data" << key.first << key.second <<
+            "size:" << size;
+        m_statistics.evictions++;
+        m_statistics.evictedSize += size;
+
+        dropData(*i, key.second);
+        if (i->m_blobData.isEmpty() && !i->m_hasCredentials)
+            m_cache.erase(i);
+    }
 }
 
 SqlDatabase::SqlDatabase(const QString &databaseName,
@@ -214,20 +468,18 @@ QSqlQuery SqlDatabase::exec(const QString &queryStr)
     if (!query.prepare(queryStr))
         TRACE() << "Query prepare warning: " << query.lastQuery();
 
-    if (!query.exec()) {
-        TRACE() << "Query exec error: " << query.lastQuery();
-        setLastError(query.lastError());
-        TRACE() << errorInfo(query.lastError());
-    } else
-        m_lastError.clear();
-
-    return query;
+    return exec(query);
 }
 
 QSqlQuery SqlDatabase::exec(QSqlQuery &query)
 {
+    QElapsedTimer timer;
+    timer.start();
 
-    if (!query.exec()) {
+    bool ok = query.exec();
+    SignonMetrics::instance()->statementExecuted(timer.nsecsElapsed() / 1000,
+                                                 ok);
+    if (!ok) {
         TRACE() << "Query exec error: " << query.lastQuery();
         setLastError(query.lastError());
         TRACE() << errorInfo(query.lastError());
@@ -268,6 +520,15 @@ bool SqlDatabase::transactionalExec(const QStringList &queryList)
     return false;
 }
 
+bool SqlDatabase::backup(const QString &fileName)
+{
+    QSqlQuery query = newQuery();
+    query.prepare(QLatin1String("VACUUM INTO :fileName"));
+    query.bindValue(QLatin1String(":fileName"), fileName);
+    exec(query);
+    return !errorOccurred();
+}
+
 SignOn::CredentialsDBError SqlDatabase::lastError() const
 {
     return m_lastError;
@@ -1291,7 +1552,10 @@ CredentialsDB::CredentialsDB(const QString &metaDataDbName,
                              SignOn::AbstractSecretsStorage *secretsStorage):
     secretsStorage(secretsStorage),
     m_secretsCache(new SecretsCache),
-    metaDataDB(new MetaDataDB(metaDataDbName))
+    metaDataDB(new MetaDataDB(metaDataDbName)),
+    m_flushScheduled(false),
+    m_flushTotal(0),
+    m_flushSlice(SECRETS_CACHE_FLUSH_SLICE)
 {
     noSecretsDB = SignOn::CredentialsDBError(
         QLatin1String("Secrets DB not opened"),
@@ -1313,7 +1577,13 @@ CredentialsDB::~CredentialsDB()
 
 bool CredentialsDB::init()
 {
-    return metaDataDB->init();
+    if (!metaDataDB->init())
+        return false;
+
+    /* With write-ahead logging the read-only connections of the
+     * CredentialsDBWorker threads are not blocked by the writes */
+    metaDataDB->exec(S("PRAGMA journal_mode=WAL"));
+    return true;
 }
 
 bool CredentialsDB::openSecretsDB(const QString &secretsDbName)
@@ -1326,11 +1596,45 @@ bool CredentialsDB::openSecretsDB(const QString &secretsDbName)
         return false;
     }
 
-    m_secretsCache->storeToDB(secretsStorage);
-    m_secretsCache->clear();
+    if (!m_secretsCache->isEmpty()) {
+        m_flushTotal = m_secretsCache->count();
+        m_flushTimer.start();
+        /* Small caches are stored right away */
+        flushSecretsCache();
+    }
     return true;
 }
 
+void CredentialsDB::scheduleSecretsCacheFlush()
+{
+    if (m_flushScheduled) return;
+
+    m_flushScheduled = true;
+    QTimer::singleShot(0, this, SLOT(flushSecretsCache()));
+}
+
+void CredentialsDB::flushSecretsCache()
+{
+    m_flushScheduled = false;
+
+    /* If the secrets DB was closed in the meantime, the rest of the cache
+     * will be stored the next time it's opened */
+    if (!isSecretsDBOpen() || m_secretsCache->isEmpty()) return;
+
+    m_secretsCache->storeToDB(secretsStorage, m_flushSlice);
+
+    int stored = m_flushTotal - m_secretsCache->count();
+    if (!m_secretsCache->isEmpty()) {
+        TRACE() << "Stored" << stored << "of" << m_flushTotal <<
+            "cached secrets";
+        scheduleSecretsCacheFlush();
+        return;
+    }
+
+    TRACE() << "Stored" << m_flushTotal << "cached secrets in" <<
+        m_flushTimer.elapsed() << "ms";
+}
+
 bool CredentialsDB::isSecretsDBOpen()
 {
     return secretsStorage != 0 && secretsStorage->isOpen();
@@ -1341,6 +1645,30 @@ void CredentialsDB::closeSecretsDB()
     if (secretsStorage != 0) secretsStorage->close();
 }
 
+void CredentialsDB::setSecretsCacheMaxSize(qint64 maxSize)
+{
+    m_secretsCache->setMaxSize(maxSize);
+}
+
+void CredentialsDB::setSecretsCacheFlushSlice(int msecs)
+{
+    m_flushSlice = qMax(msecs, 0);
+}
+
+QVariantMap CredentialsDB::secretsCacheStatistics() const
+{
+    const SecretsCache::Statistics &stats = m_secretsCache->statistics();
+
+    QVariantMap map;
+    map.insert(QLatin1String("Size"), stats.size);
+    map.insert(QLatin1String("PeakSize"), stats.peakSize);
+    map.insert(QLatin1String("MaxSize"), m_secretsCache->maxSize());
+    map.insert(QLatin1String("Entries"), m_secretsCache->count());
+    map.insert(QLatin1String("Evictions"), stats.evictions);
+    map.insert(QLatin1String("EvictedSize"), stats.evictedSize);
+    return map;
+}
+
 SignOn::CredentialsDBError CredentialsDB::lastError() const
 {
     return _lastError;
@@ -1360,6 +1688,15 @@ bool CredentialsDB::checkPassword(const quint32 id,
     INIT_ERROR();
     RETURN_IF_NO_SECRETS_DB(false);
     SignonIdentityInfo info = metaDataDB->identity(id);
+    if (m_secretsCache->hasCredentials(id)) {
+        /* Not yet moved into the secrets DB */
+        QString cachedUsername, cachedPassword;
+        m_secretsCache->lookupCredentials(id, cachedUsername, cachedPassword);
+        if (info.isUserNameSecret())
+            return username == cachedUsername && password == cachedPassword;
+        return username == info.userName() && password == cachedPassword;
+    }
+
     if (info.isUserNameSecret()) {
         return secretsStorage->checkPassword(id, username, password);
     } else {
@@ -1376,7 +1713,8 @@ SignonIdentityInfo CredentialsDB::credentials(const quint32 id,
     SignonIdentityInfo info = metaDataDB->identity(id);
     if (queryPassword && !info.isNew()) {
         QString username, password;
-        if (info.storePassword() && isSecretsDBOpen()) {
+        if (info.storePassword() && isSecretsDBOpen() &&
+            !m_secretsCache->hasCredentials(id)) {
             TRACE() << "Loading credentials from DB.";
             secretsStorage->loadCredentials(id, username, password);
         } else {
@@ -1414,9 +1752,22 @@ quint32 CredentialsDB::insertCredentials(const SignonIdentityInfo &info)
 quint32 CredentialsDB::updateCredentials(const SignonIdentityInfo &info)
 {
     INIT_ERROR();
+    /* Most updates leave the ACL and the owners untouched: the access
+     * decisions cached by the daemon remain valid then. The stored ACL
+     * also depends on the methods, so compare what the DB returns. */
+    QSet<QString> oldAcl, oldOwners;
+    if (!info.isNew()) {
+        oldAcl = metaDataDB->accessControlList(info.id()).toSet();
+        oldOwners = metaDataDB->ownerList(info.id()).toSet();
+    }
+
     quint32 id = metaDataDB->updateIdentity(info);
     if (id == 0) return id;
 
+    bool accessChanged = info.isNew() ||
+        metaDataDB->accessControlList(id).toSet() != oldAcl ||
+        metaDataDB->ownerList(id).toSet() != oldOwners;
+
     if (info.hasSecrets()) {
         QString password = info.password();
         QString userName;
@@ -1425,6 +1776,8 @@ quint32 CredentialsDB::updateCredentials(const SignonIdentityInfo &info)
 
         if (info.storePassword() && isSecretsDBOpen()) {
             secretsStorage->updateCredentials(id, userName, password);
+            /* Don't let a pending flush overwrite them */
+            m_secretsCache->removeCredentials(id);
         } else {
             /* Cache username and password in memory */
             m_secretsCache->updateCredentials(id, userName, password,
@@ -1433,6 +1786,8 @@ quint32 CredentialsDB::updateCredentials(const SignonIdentityInfo &info)
     }
 
     Q_EMIT credentialsUpdated(id);
+    if (accessChanged)
+        Q_EMIT accessControlChanged(id);
 
     return id;
 }
@@ -1445,8 +1800,12 @@ bool CredentialsDB::removeCredentials(const quint32 id)
      * available */
     RETURN_IF_NO_SECRETS_DB(false);
 
-    return secretsStorage->removeCredentials(id) &&
+    m_secretsCache->remove(id);
+    bool ok = secretsStorage->removeCredentials(id) &&
         metaDataDB->removeIdentity(id);
+    Q_EMIT dataChanged(id);
+    Q_EMIT accessControlChanged(id);
+    return ok;
 }
 
 bool CredentialsDB::clear()
@@ -1458,7 +1817,11 @@ bool CredentialsDB::clear()
     /* We don't allow clearing the DB if the secrets DB is not available */
     RETURN_IF_NO_SECRETS_DB(false);
 
-    return secretsStorage->clear() && metaDataDB->clear();
+    m_secretsCache->clear();
+    bool ok = secretsStorage->clear() && metaDataDB->clear();
+    Q_EMIT dataChanged(0);
+    Q_EMIT accessControlChanged(0);
+    return ok;
 }
 
 QVariantMap CredentialsDB::loadData(const quint32 id, const QString &method)
@@ -1471,7 +1834,7 @@ QVariantMap CredentialsDB::loadData(const quint32 id, const QString &method)
     quint32 methodId = metaDataDB->methodId(method);
     if (methodId == 0) return QVariantMap();
 
-    if (isSecretsDBOpen()) {
+    if (isSecretsDBOpen() && !m_secretsCache->hasData(id, methodId)) {
         return secretsStorage->loadData(id, methodId);
     } else {
         TRACE() << "Looking up data from cache";
@@ -1495,13 +1858,53 @@ bool CredentialsDB::storeData(const quint32 id, const QString &method,
             return false;
     }
 
+    bool ok = true;
     if (isSecretsDBOpen()) {
-        return secretsStorage->storeData(id, methodId, data);
+        ok = secretsStorage->storeData(id, methodId, data);
+        m_secretsCache->removeData(id, methodId);
     } else {
         TRACE() << "Storing data into cache";
         m_secretsCache->updateData(id, methodId, data);
-        return true;
     }
+    Q_EMIT dataChanged(id);
+    return ok;
+}
+
+SignOn::SecretsReply *
+CredentialsDB::loadCredentialsAsync(const SignonIdentityInfo &info)
+{
+    quint32 id = info.id();
+    TRACE() << "Loading asynchronously:" << id;
+
+    if (!info.isNew() && info.storePassword() && isSecretsDBOpen() &&
+        !m_secretsCache->hasCredentials(id)) {
+        return secretsStorage->loadCredentialsAsync(id);
+    }
+
+    CachedSecretsReply *reply = new CachedSecretsReply(id, 0, this);
+    if (!info.isNew()) {
+        QString username, password;
+        m_secretsCache->lookupCredentials(id, username, password);
+        reply->setCredentials(username, password);
+    }
+    return reply;
+}
+
+SignOn::SecretsReply *CredentialsDB::loadDataAsync(const quint32 id,
+                                                   const QString &method)
+{
+    TRACE() << "Loading asynchronously:" << id << "," << method;
+
+    quint32 methodId = (id != 0) ? metaDataDB->methodId(method) : 0;
+    if (methodId != 0 && isSecretsDBOpen() &&
+        !m_secretsCache->hasData(id, methodId)) {
+        return secretsStorage->loadDataAsync(id, methodId);
+    }
+
+    CachedSecretsReply *reply = new CachedSecretsReply(id, methodId, this);
+    if (methodId != 0)
+        reply->setData(m_secretsCache->lookupData(id, methodId));
+    return reply;
 }
 
 bool CredentialsDB::removeData(const quint32 id, const QString &method)
@@ -1520,7 +1923,19 @@ bool CredentialsDB::removeData(const quint32 id, const QString &method)
         methodId = 0;
     }
 
-    return secretsStorage->removeData(id, methodId);
+    m_secretsCache->removeData(id, methodId);
+    bool ok = secretsStorage->removeData(id, methodId);
+    Q_EMIT dataChanged(id);
+    return ok;
+}
+
+bool CredentialsDB::backupMetaDataDB(const QString &fileName)
+{
+    TRACE() << fileName;
+
+    INIT_ERROR();
+
+    return metaDataDB->backup(fileName);
 }
 
 QStringList CredentialsDB::accessControlList(const quint32 identityId)
@@ -32,6 +32,7 @@
 #ifndef CREDENTIALS_DB_H
 #define CREDENTIALS_DB_H
 
+#include <QElapsedTimer>
 #include <QObject>
 #include <QtSql>
 
@@ -94,11 +95,31 @@ public:
      * This method will open the DB file containing the user secrets.
      * If this method is not called, or if it fails, the secrets will not be
      * available.
+     * The secrets cached in memory while the DB was not available are moved
+     * into it in slices, from the event loop.
      */
     bool openSecretsDB(const QString &secretsDbName);
     bool isSecretsDBOpen();
     void closeSecretsDB();
 
+    /*!
+     * Limits the memory used to cache the secrets while the secrets DB is
+     * not available; when the limit is exceeded, the least recently used
+     * session data is discarded. A value of 0 means no limit.
+     */
+    void setSecretsCacheMaxSize(qint64 maxSize);
+    /*!
+     * Sets the maximum time spent storing the secrets cache into the secrets
+     * DB before returning to the main loop; at least one batch of entries is
+     * stored each time.
+     */
+    void setSecretsCacheFlushSlice(int msecs);
+    /*!
+     * @returns the counters of the secrets cache: "Size", "PeakSize",
+     * "MaxSize", "Entries", "Evictions" and "EvictedSize". Sizes are in bytes.
+     */
+    QVariantMap secretsCacheStatistics() const;
+
     SignOn::CredentialsDBError lastError() const;
     bool errorOccurred() const { return lastError().isValid(); };
 
@@ -115,6 +136,12 @@ public:
 
     bool clear();
 
+    /*!
+     * Writes a consistent copy of the metadata DB into @fileName, without
+     * closing it; see SqlDatabase::backup().
+     */
+    bool backupMetaDataDB(const QString &fileName);
+
     QStringList accessControlList(const quint32 identityId);
     QStringList ownerList(const quint32 identityId);
     QString credentialsOwnerSecurityToken(const quint32 identityId);
@@ -125,6 +152,18 @@ public:
                    const QVariantMap &data);
     bool removeData(const quint32 id, const QString &method = QString());
 
+    /*!
+     * Asynchronous variants of credentials() and loadData(), for the secrets
+     * only: they read from the secrets cache, or from the secrets storage
+     * without blocking the main loop, if the storage supports it.
+     * @info is the identity as returned by credentials(id, false).
+     * @returns a SignOn::SecretsReply owned by the caller; its finished()
+     * signal is always emitted after the method has returned.
+     */
+    SignOn::SecretsReply *loadCredentialsAsync(const SignonIdentityInfo &info);
+    SignOn::SecretsReply *loadDataAsync(const quint32 id,
+                                        const QString &method);
+
     bool addReference(const quint32 id,
                       const QString &token,
                       const QString &reference);
@@ -136,13 +175,32 @@ public:
 
 Q_SIGNALS:
     void credentialsUpdated(quint32 id);
+    /*!
+     * Emitted when the stored session data of the identity @id changes, or
+     * when the identity is removed; @id is 0 when the whole DB is cleared.
+     */
+    void dataChanged(quint32 id);
+    /*!
+     * Emitted when the ACL or the owners of the identity @id change, or
+     * when the identity is removed; @id is 0 when the whole DB is cleared.
+     */
+    void accessControlChanged(quint32 id);
+
+private Q_SLOTS:
+    void flushSecretsCache();
 
 private:
+    void scheduleSecretsCacheFlush();
+
     SignOn::AbstractSecretsStorage *secretsStorage;
     SecretsCache *m_secretsCache;
     MetaDataDB *metaDataDB;
     SignOn::CredentialsDBError _lastError;
     SignOn::CredentialsDBError noSecretsDB;
+    bool m_flushScheduled;
+    int m_flushTotal;
+    int m_flushSlice;
+    QElapsedTimer m_flushTimer;
 };
 
 } // namespace SignonDaemonNS
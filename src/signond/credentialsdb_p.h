@@ -41,6 +41,9 @@ namespace SignonDaemonNS {
 /*!
  * @class SecretsCache
  * Caches credentials or BLOB authentication data.
+ * The memory used by the cache is accounted for, and can be limited: when
+ * the limit is exceeded the least recently used BLOBs are evicted, while
+ * usernames and passwords are always kept.
  */
 class SecretsCache
 {
@@ -50,20 +53,43 @@ public:
     {
         friend class SecretsCache;
 
+    public:
+        AuthCache(): m_storePassword(false), m_hasCredentials(false) {}
+
     private:
         QString m_username;
         QString m_password;
         bool m_storePassword;
+        bool m_hasCredentials;
         QHash<quint32,QVariantMap> m_blobData;
+        /* Size in bytes and LRU position of each BLOB */
+        QHash<quint32,int> m_blobSize;
+        QHash<quint32,quint64> m_blobUse;
+    };
+
+    struct Statistics {
+        Statistics(): size(0), peakSize(0), evictions(0), evictedSize(0) {}
+
+        qint64 size;
+        qint64 peakSize;
+        quint64 evictions;
+        qint64 evictedSize;
     };
 
-    SecretsCache() {};
-    ~SecretsCache() {};
+    SecretsCache(): m_maxSize(0), m_useCounter(0) {};
+    ~SecretsCache() { clear(); };
+
+    /*!
+     * Sets the maximum memory used by the cache, in bytes; 0 means no limit.
+     */
+    void setMaxSize(qint64 maxSize);
+    qint64 maxSize() const { return m_maxSize; }
+    const Statistics &statistics() const { return m_statistics; }
 
     bool lookupCredentials(quint32 id,
                            QString &username,
                            QString &password) const;
-    QVariantMap lookupData(quint32 id, quint32 method) const;
+    QVariantMap lookupData(quint32 id, quint32 method);
 
     void updateCredentials(quint32 id,
                            const QString &username,
@@ -71,11 +97,40 @@ public:
                            bool storePassword);
     void updateData(quint32 id, quint32 method, const QVariantMap &data);
 
-    void storeToDB(SignOn::AbstractSecretsStorage *secretsStorage) const;
+    bool hasCredentials(quint32 id) const;
+    bool hasData(quint32 id, quint32 method) const;
+    void removeCredentials(quint32 id);
+    void removeData(quint32 id, quint32 method = 0);
+    void remove(quint32 id);
+
+    bool isEmpty() const { return m_cache.isEmpty(); }
+    int count() const { return m_cache.count(); }
+
+    /*!
+     * Moves the cached entries into @secretsStorage, in batches, until
+     * @maxTime milliseconds have elapsed (at least one batch is moved).
+     * @returns the number of entries moved.
+     */
+    int storeToDB(SignOn::AbstractSecretsStorage *secretsStorage,
+                  int maxTime);
     void clear();
 
 private:
+    typedef QPair<quint32, quint32> BlobKey;
+
+    void dropCredentials(AuthCache &cache);
+    void dropData(AuthCache &cache, quint32 method);
+    void dropEntry(QHash<quint32, AuthCache>::iterator i);
+    void touch(quint32 id, AuthCache &cache, quint32 method);
+    void addSize(qint64 size);
+    void evict();
+
     QHash<quint32, AuthCache> m_cache;
+    /* BLOBs by last use, oldest first */
+    QMap<quint64, BlobKey> m_lru;
+    qint64 m_maxSize;
+    quint64 m_useCounter;
+    Statistics m_statistics;
 };
 
 /*!
@@ -151,6 +206,14 @@ public:
         m_database.setPassword(password);
     }
 
+    /*!
+     * Sets the driver specific connection options.
+     * @param options
+     */
+    void setConnectOptions(const QString &options) {
+        m_database.setConnectOptions(options);
+    }
+
     /*!
      * @returns the database name.
      */
@@ -199,6 +262,14 @@ public:
      */
     bool transactionalExec(const QStringList &queryList);
 
+    /*!
+     * Writes a consistent copy of the database into @fileName, which must
+     * not exist, while the database stays open; this requires SQLite 3.27
+     * or newer ("VACUUM INTO").
+     * @returns true if successful, false otherwise.
+     */
+    bool backup(const QString &fileName);
+
     /*!
      * @returns true, if the database has any tables created, false otherwise.
      */
@@ -247,9 +318,10 @@ class MetaDataDB: public SqlDatabase
 {
     friend class ::TestDatabase;
 public:
-    MetaDataDB(const QString &name):
-        SqlDatabase(name, QLatin1String("SSO-metadata"),
-                    SSO_METADATADB_VERSION) {}
+    MetaDataDB(const QString &name,
+               const QString &connectionName =
+               QLatin1String("SSO-metadata")):
+        SqlDatabase(name, connectionName, SSO_METADATADB_VERSION) {}
 
     bool createTables();
     bool updateDB(int version);
@@ -0,0 +1,253 @@
+/*
+ * This file is part of signon
+ *
+ * Copyright (C) 2013 Canonical Ltd.
+ *
+ * Contact: Alberto Mardegan <alberto.mardegan@canonical.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+
+#include <QDBusArgument>
+#include <QThread>
+
+#include "credentialsdbworker.h"
+#include "credentialsdb_p.h"
+#include "signond-common.h"
+
+#undef SIGNON_TRACE_CATEGORY
+#define SIGNON_TRACE_CATEGORY SignOn::DatabaseCategory
+
+#define MAX_DEFAULT_THREADS 4
+
+using namespace SignonDaemonNS;
+
+namespace SignonDaemonNS {
+
+/* The read-only connection of a thread of the pool. It is deleted by
+ * QThreadStorage when the thread exits, in that same thread. */
+class CredentialsDBWorker::Connection
+{
+public:
+    Connection(const QString &dbName):
+        m_connectionName(QString::fromLatin1("SSO-metadata-reader-%1").
+                         arg(quintptr(QThread::currentThreadId()))),
+        m_db(new MetaDataDB(dbName, m_connectionName))
+    {
+        /* The tables are created and updated by the main connection */
+        m_db->setConnectOptions(
+            QLatin1String("QSQLITE_OPEN_READONLY;QSQLITE_BUSY_TIMEOUT=5000"));
+    }
+
+    ~Connection()
+    {
+        delete m_db;
+        QSqlDatabase::removeDatabase(m_connectionName);
+    }
+
+    MetaDataDB *db()
+    {
+        if (!m_db->connected() && !m_db->connect()) {
+            BLAME() << "Could not open the metadata DB:" <<
+                m_db->lastError().text();
+            return 0;
+        }
+        m_db->clearError();
+        return m_db;
+    }
+
+private:
+    QString m_connectionName;
+    MetaDataDB *m_db;
+};
+
+class WorkerRunnable: public QRunnable
+{
+public:
+    WorkerRunnable(CredentialsDBWorker *worker,
+                   CredentialsDBWorker::Task *task):
+        m_worker(worker),
+        m_task(task)
+    {
+    }
+
+    ~WorkerRunnable()
+    {
+        delete m_task;
+    }
+
+    void run()
+    {
+        m_task->run(m_worker->threadConnection());
+    }
+
+private:
+    CredentialsDBWorker *m_worker;
+    CredentialsDBWorker::Task *m_task;
+};
+
+} // namespace SignonDaemonNS
+
+namespace {
+
+class QueryIdentitiesTask: public CredentialsDBWorker::Task
+{
+public:
+    QueryIdentitiesTask(const QVariantMap &filter,
+                        const QDBusConnection &conn,
+                        const QDBusMessage &msg):
+        m_filter(filter),
+        m_conn(conn),
+        m_msg(msg)
+    {
+    }
+
+    void run(MetaDataDB *db)
+    {
+        TRACE() << "Querying identities";
+
+        QList<SignonIdentityInfo> credentials;
+        if (db != 0) {
+            QMap<QString, QString> filterLocal;
+            QMapIterator<QString, QVariant> it(m_filter);
+            while (it.hasNext()) {
+                it.next();
+                filterLocal.insert(it.key(), it.value().toString());
+            }
+
+            credentials = db->identities(filterLocal);
+        }
+
+        if (db == 0 || db->errorOccurred()) {
+            m_conn.send(m_msg.createErrorReply(
+                SIGNOND_INTERNAL_SERVER_ERR_NAME,
+                SIGNOND_INTERNAL_SERVER_ERR_STR +
+                QLatin1String("Querying database error occurred.")));
+            return;
+        }
+
+        /* Marshalled by hand, to build an "aa{sv}" without depending on
+         * the adaptor's meta types */
+        QDBusArgument identities;
+        identities.beginArray(qMetaTypeId<QVariantMap>());
+        foreach (const SignonIdentityInfo &info, credentials) {
+            identities << info.toMap();
+        }
+        identities.endArray();
+        m_conn.send(m_msg.createReply(QVariant::fromValue(identities)));
+    }
+
+private:
+    QVariantMap m_filter;
+    QDBusConnection m_conn;
+    QDBusMessage m_msg;
+};
+
+class IdentityInfoTask: public CredentialsDBWorker::Task
+{
+public:
+    IdentityInfoTask(quint32 id,
+                     const QDBusConnection &conn,
+                     const QDBusMessage &msg):
+        m_id(id),
+        m_conn(conn),
+        m_msg(msg)
+    {
+    }
+
+    void run(MetaDataDB *db)
+    {
+        TRACE() << "Querying info of identity" << m_id;
+
+        SignonIdentityInfo info;
+        if (db != 0)
+            info = db->identity(m_id);
+
+        if (db == 0 || db->errorOccurred()) {
+            m_conn.send(m_msg.createErrorReply(
+                SIGNOND_CREDENTIALS_NOT_AVAILABLE_ERR_NAME,
+                SIGNOND_CREDENTIALS_NOT_AVAILABLE_ERR_STR +
+                QLatin1String("Database querying error occurred.")));
+            return;
+        }
+
+        if (info.isNew()) {
+            m_conn.send(m_msg.createErrorReply(
+                SIGNOND_IDENTITY_NOT_FOUND_ERR_NAME,
+                SIGNOND_IDENTITY_NOT_FOUND_ERR_STR));
+            return;
+        }
+
+        info.removeSecrets();
+        m_conn.send(m_msg.createReply(QVariant(info.toMap())));
+    }
+
+private:
+    quint32 m_id;
+    QDBusConnection m_conn;
+    QDBusMessage m_msg;
+};
+
+} // namespace
+
+CredentialsDBWorker::CredentialsDBWorker(const QString &metaDataDbName,
+                                         int threadCount):
+    m_dbName(metaDataDbName)
+{
+    if (threadCount <= 0)
+        threadCount = qBound(1, QThread::idealThreadCount(),
+                             MAX_DEFAULT_THREADS);
+    m_pool.setMaxThreadCount(threadCount);
+    /* Keep the threads, and therefore their connections, alive */
+    m_pool.setExpiryTimeout(-1);
+    TRACE() << "Metadata DB readers:" << threadCount;
+}
+
+CredentialsDBWorker::~CredentialsDBWorker()
+{
+    m_pool.waitForDone();
+}
+
+void CredentialsDBWorker::start(Task *task)
+{
+    m_pool.start(new WorkerRunnable(this, task));
+}
+
+void CredentialsDBWorker::waitForDone()
+{
+    m_pool.waitForDone();
+}
+
+void CredentialsDBWorker::queryIdentities(const QVariantMap &filter,
+                                          const QDBusConnection &conn,
+                                          const QDBusMessage &msg)
+{
+    start(new QueryIdentitiesTask(filter, conn, msg));
+}
+
+void CredentialsDBWorker::identityInfo(quint32 id,
+                                       const QDBusConnection &conn,
+                                       const QDBusMessage &msg)
+{
+    start(new IdentityInfoTask(id, conn, msg));
+}
+
+MetaDataDB *CredentialsDBWorker::threadConnection()
+{
+    if (!m_connections.hasLocalData())
+        m_connections.setLocalData(new Connection(m_dbName));
+    return m_connections.localData()->db();
+}
@@ -0,0 +1,116 @@
+/*
+ * This file is part of signon
+ *
+ * Copyright (C) 2013 Canonical Ltd.
+ *
+ * Contact: Alberto Mardegan <alberto.mardegan@canonical.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+
+#ifndef CREDENTIALSDBWORKER_H
+#define CREDENTIALSDBWORKER_H
+
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QString>
+#include <QThreadPool>
+#include <QThreadStorage>
+#include <QVariantMap>
+
+namespace SignonDaemonNS {
+
+class MetaDataDB;
+
+/*!
+ * @class CredentialsDBWorker
+ * Runs read-only queries on the metadata DB in a pool of threads. Each thread
+ * of the pool uses its own read-only connection to the DB, so that the
+ * queries can run concurrently with each other and with the writes done by
+ * the main connection.
+ */
+class CredentialsDBWorker
+{
+public:
+    /*!
+     * @class Task
+     * A read-only operation on the metadata DB.
+     */
+    class Task
+    {
+    public:
+        virtual ~Task() {}
+
+        /*!
+         * Called in one of the threads of the pool; @db is the connection of
+         * that thread, or 0 if the DB could not be opened.
+         */
+        virtual void run(MetaDataDB *db) = 0;
+    };
+
+    /*!
+     * Constructs a pool of @threadCount threads reading from the given DB.
+     * If @threadCount is not positive, a default depending on the number of
+     * CPU cores is used.
+     */
+    CredentialsDBWorker(const QString &metaDataDbName, int threadCount = 0);
+    ~CredentialsDBWorker();
+
+    int threadCount() const { return m_pool.maxThreadCount(); }
+
+    /*!
+     * Runs @task in one of the threads of the pool, and deletes it
+     * afterwards.
+     */
+    void start(Task *task);
+
+    /*!
+     * Waits for all the tasks to complete.
+     */
+    void waitForDone();
+
+    /*!
+     * Replies to @msg with the identities matching @filter. The message
+     * must have been set for a delayed reply.
+     */
+    void queryIdentities(const QVariantMap &filter,
+                         const QDBusConnection &conn,
+                         const QDBusMessage &msg);
+
+    /*!
+     * Replies to @msg with the information about the identity @id, without
+     * its secrets. The message must have been set for a delayed reply.
+     */
+    void identityInfo(quint32 id,
+                      const QDBusConnection &conn,
+                      const QDBusMessage &msg);
+
+private:
+    class Connection;
+    friend class WorkerRunnable;
+
+    MetaDataDB *threadConnection();
+
+    QString m_dbName;
+    /* Destroyed after the pool, as the connections are closed when the
+     * threads of the pool exit */
+    QThreadStorage<Connection *> m_connections;
+    QThreadPool m_pool;
+};
+
+} // namespace SignonDaemonNS
+
+#endif // CREDENTIALSDBWORKER_H
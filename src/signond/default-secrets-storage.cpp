@@ -24,6 +24,9 @@
 #include "default-secrets-storage.h"
 #include "signond-common.h"
 
+#undef SIGNON_TRACE_CATEGORY
+#define SIGNON_TRACE_CATEGORY SignOn::DatabaseCategory
+
 #define RETURN_IF_NOT_OPEN(retval) \
     if (!isOpen()) { \
         TRACE() << "Secrets DB is not available"; \
@@ -85,14 +88,10 @@ bool SecretsDB::clear()
     return transactionalExec(clearCommands);
 }
 
-bool SecretsDB::updateCredentials(const quint32 id,
+bool SecretsDB::insertCredentials(const quint32 id,
                                   const QString &username,
                                   const QString &password)
 {
-    if (!startTransaction()) {
-        TRACE() << "Could not start transaction. Error inserting credentials.";
-        return false;
-    }
     QSqlQuery query = newQuery();
 
     TRACE() << "INSERT:" << id;
@@ -105,8 +104,19 @@ bool SecretsDB::updateCredentials(const quint32 id,
     query.bindValue(S(":password"), password);
 
     exec(query);
+    return !errorOccurred();
+}
 
-    if (errorOccurred()) {
+bool SecretsDB::updateCredentials(const quint32 id,
+                                  const QString &username,
+                                  const QString &password)
+{
+    if (!startTransaction()) {
+        TRACE() << "Could not start transaction. Error inserting credentials.";
+        return false;
+    }
+
+    if (!insertCredentials(id, username, password)) {
         rollback();
         TRACE() << "Error occurred while storing crendentials";
         return false;
@@ -114,6 +124,26 @@ bool SecretsDB::updateCredentials(const quint32 id,
     return commit();
 }
 
+bool SecretsDB::updateCredentialsBatch(
+    const QList<SignOn::SecretsCredentials> &items)
+{
+    TRACE() << "Storing" << items.count() << "credentials";
+
+    if (!startTransaction()) {
+        TRACE() << "Could not start transaction. Error inserting credentials.";
+        return false;
+    }
+
+    foreach (const SignOn::SecretsCredentials &item, items) {
+        if (!insertCredentials(item.id, item.username, item.password)) {
+            rollback();
+            TRACE() << "Error occurred while storing crendentials";
+            return false;
+        }
+    }
+    return commit();
+}
+
 bool SecretsDB::removeCredentials(const quint32 id)
 {
     TRACE();
@@ -172,15 +202,31 @@ QVariantMap SecretsDB::loadData(quint32 id, quint32 method)
     return result;
 }
 
-bool SecretsDB::storeData(quint32 id, quint32 method, const QVariantMap &data)
+bool SecretsDB::loadDataBatch(QList<SignOn::SecretsData> &items)
 {
-    TRACE();
+    TRACE() << "Loading" << items.count() << "data";
 
+    /* A single read transaction: all the items come from the same snapshot
+     * of the DB, and SQLite takes the shared lock only once */
     if (!startTransaction()) {
-        TRACE() << "Could not start transaction. Error inserting data.";
+        TRACE() << "Could not start transaction. Error loading data.";
         return false;
     }
 
+    QList<SignOn::SecretsData>::iterator i;
+    for (i = items.begin(); i != items.end(); ++i) {
+        i->data = loadData(i->id, i->method);
+        if (errorOccurred()) {
+            rollback();
+            return false;
+        }
+    }
+    return commit();
+}
+
+bool SecretsDB::replaceData(quint32 id, quint32 method,
+                            const QVariantMap &data)
+{
     /* first, remove existing data */
     QSqlQuery q = newQuery();
     q.prepare(S("DELETE FROM STORE WHERE identity_id = :id "
@@ -189,12 +235,10 @@ bool SecretsDB::storeData(quint32 id, quint32 method, const QVariantMap &data)
     q.bindValue(S(":method"), method);
     exec(q);
     if (errorOccurred()) {
-        rollback();
         TRACE() << "Data removal failed.";
         return false;
     }
 
-    bool allOk = true;
     qint32 dataCounter = 0;
     if (!(data.keys().empty())) {
         QMapIterator<QString, QVariant> it(data);
@@ -208,8 +252,7 @@ bool SecretsDB::storeData(quint32 id, quint32 method, const QVariantMap &data)
             dataCounter += it.key().size() +array.size();
             if (dataCounter >= SSO_MAX_TOKEN_STORAGE) {
                 BLAME() << "storing data max size exceeded";
-                allOk = false;
-                break;
+                return false;
             }
             /* Key/value insert/replace/delete */
             QSqlQuery query = newQuery();
@@ -226,10 +269,46 @@ bool SecretsDB::storeData(quint32 id, quint32 method, const QVariantMap &data)
             query.bindValue(S(":method"), method);
             query.bindValue(S(":key"), it.key());
             exec(query);
-            if (errorOccurred()) {
-                allOk = false;
-                break;
-            }
+            if (errorOccurred())
+                return false;
+        }
+    }
+
+    return true;
+}
+
+bool SecretsDB::storeData(quint32 id, quint32 method, const QVariantMap &data)
+{
+    TRACE();
+
+    if (!startTransaction()) {
+        TRACE() << "Could not start transaction. Error inserting data.";
+        return false;
+    }
+
+    if (replaceData(id, method, data) && commit()) {
+        TRACE() << "Data insertion ok.";
+        return true;
+    }
+    rollback();
+    TRACE() << "Data insertion failed.";
+    return false;
+}
+
+bool SecretsDB::storeDataBatch(const QList<SignOn::SecretsData> &items)
+{
+    TRACE() << "Storing" << items.count() << "data";
+
+    if (!startTransaction()) {
+        TRACE() << "Could not start transaction. Error inserting data.";
+        return false;
+    }
+
+    bool allOk = true;
+    foreach (const SignOn::SecretsData &item, items) {
+        if (!replaceData(item.id, item.method, item.data)) {
+            allOk = false;
+            break;
         }
     }
 
@@ -369,3 +448,26 @@ bool DefaultSecretsStorage::removeData(quint32 id, quint32 method)
 
     return m_secretsDB->removeData(id, method);
 }
+
+bool DefaultSecretsStorage::updateCredentialsBatch(
+    const QList<SignOn::SecretsCredentials> &items)
+{
+    RETURN_IF_NOT_OPEN(false);
+
+    return m_secretsDB->updateCredentialsBatch(items);
+}
+
+bool DefaultSecretsStorage::loadDataBatch(QList<SignOn::SecretsData> &items)
+{
+    RETURN_IF_NOT_OPEN(false);
+
+    return m_secretsDB->loadDataBatch(items);
+}
+
+bool DefaultSecretsStorage::storeDataBatch(
+    const QList<SignOn::SecretsData> &items)
+{
+    RETURN_IF_NOT_OPEN(false);
+
+    return m_secretsDB->storeDataBatch(items);
+}
@@ -59,6 +59,18 @@ public:
     QVariantMap loadData(quint32 id, quint32 method);
     bool storeData(quint32 id, quint32 method, const QVariantMap &data);
     bool removeData(quint32 id, quint32 method);
+
+    /* Each batch is done in a single transaction */
+    bool updateCredentialsBatch(const QList<SignOn::SecretsCredentials> &items);
+    bool loadDataBatch(QList<SignOn::SecretsData> &items);
+    bool storeDataBatch(const QList<SignOn::SecretsData> &items);
+
+private:
+    /* These must be called inside a transaction */
+    bool insertCredentials(const quint32 id,
+                           const QString &username,
+                           const QString &password);
+    bool replaceData(quint32 id, quint32 method, const QVariantMap &data);
 };
 
 
@@ -92,6 +104,9 @@ public:
     QVariantMap loadData(quint32 id, quint32 method);
     bool storeData(quint32 id, quint32 method, const QVariantMap &data);
     bool removeData(quint32 id, quint32 method);
+    bool updateCredentialsBatch(const QList<SignOn::SecretsCredentials> &items);
+    bool loadDataBatch(QList<SignOn::SecretsData> &items);
+    bool storeDataBatch(const QList<SignOn::SecretsData> &items);
 
 private:
     SecretsDB *m_secretsDB;
@@ -32,6 +32,7 @@
 #include <QDataStream>
 
 #include "signond-common.h"
+#include "signonmetrics.h"
 #include "SignOn/uisessiondata_priv.h"
 #include "SignOn/signonplugincommon.h"
 
@@ -46,6 +47,9 @@
 #include "SignOn/blobiohandler.h"
 #include "SignOn/ipc.h"
 
+#undef SIGNON_TRACE_CATEGORY
+#define SIGNON_TRACE_CATEGORY SignOn::PluginCategory
+
 using namespace SignOn;
 
 #define REMOTEPLUGIN_BIN_PATH QLatin1String("signonpluginprocess")
@@ -82,7 +86,8 @@ PluginProxy::PluginProxy(QString type, QObject *parent):
 
 #ifdef SIGNOND_TRACE
     if (criticalsEnabled()) {
-        const char *level = debugEnabled() ? "2" : "1";
+        const char *level =
+            traceEnabled(SignOn::PluginCategory) ? "2" : "1";
         QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
         env.insert(QLatin1String("SSO_DEBUG"), QLatin1String(level));
         m_process->setProcessEnvironment(env);
@@ -139,6 +144,9 @@ PluginProxy* PluginProxy::createNewPluginProxy(const QString &type)
 {
     PluginProxy *pp = new PluginProxy(type);
 
+    QElapsedTimer timer;
+    timer.start();
+
     QStringList args = QStringList() << pp->m_type;
     pp->m_process->start(REMOTEPLUGIN_BIN_PATH, args);
 
@@ -146,15 +154,18 @@ PluginProxy* PluginProxy::createNewPluginProxy(const QString &type)
 
     if (!pp->waitForStarted(PLUGINPROCESS_START_TIMEOUT)) {
         TRACE() << "The process cannot be started";
+        SignonMetrics::instance()->pluginStartFailed();
         delete pp;
         return NULL;
     }
 
     if (!pp->readOnReady(tmp, PLUGINPROCESS_START_TIMEOUT)) {
         TRACE() << "The process cannot load plugin";
+        SignonMetrics::instance()->pluginStartFailed();
         delete pp;
         return NULL;
     }
+    SignonMetrics::instance()->pluginStarted(timer.nsecsElapsed() / 1000);
 
     if (debugEnabled()) {
         QString pluginType = pp->queryType();
@@ -283,7 +294,8 @@ bool PluginProxy::isResultOperationCodeValid(const int opCode) const
         || opCode == PLUGIN_RESPONSE_ERROR
         || opCode == PLUGIN_RESPONSE_SIGNAL
         || opCode == PLUGIN_RESPONSE_UI
-        || opCode == PLUGIN_RESPONSE_REFRESHED) return true;
+        || opCode == PLUGIN_RESPONSE_REFRESHED
+        || opCode == PLUGIN_RESPONSE_TIMING) return true;
 
     return false;
 }
@@ -317,7 +329,8 @@ void PluginProxy::onReadStandardOutput()
     }
 
     if (m_currentResultOperation != PLUGIN_RESPONSE_SIGNAL &&
-        m_currentResultOperation != PLUGIN_RESPONSE_ERROR) {
+        m_currentResultOperation != PLUGIN_RESPONSE_ERROR &&
+        m_currentResultOperation != PLUGIN_RESPONSE_TIMING) {
 
         connect(m_blobIOHandler, SIGNAL(error()),
                 this, SLOT(blobIOError()));
@@ -433,6 +446,17 @@ void PluginProxy::handlePluginResponse(const quint32 resultOperation,
             emit stateChanged((int)state, message);
         else
             BLAME() << "Unexpected plugin signal: " << state << message;
+    } else if (resultOperation == PLUGIN_RESPONSE_TIMING) {
+        TRACE() << "PLUGIN_RESPONSE_TIMING";
+        qint64 receivedTime;
+        qint64 repliedTime;
+
+        QDataStream stream(m_process);
+        stream >> receivedTime;
+        stream >> repliedTime;
+
+        if (!m_isResultObtained)
+            emit processTimed(receivedTime, repliedTime);
     }
 
     connect(m_process, SIGNAL(readyRead()), this, SLOT(onReadStandardOutput()));
@@ -553,12 +577,17 @@ bool PluginProxy::restartIfRequired()
 {
     if (m_process->state() == QProcess::NotRunning) {
         TRACE() << "RESTART REQUIRED";
+        QElapsedTimer timer;
+        timer.start();
         m_process->start(REMOTEPLUGIN_BIN_PATH, QStringList(m_type));
 
         QByteArray tmp;
         if (!waitForStarted(PLUGINPROCESS_START_TIMEOUT) ||
-            !readOnReady(tmp, PLUGINPROCESS_START_TIMEOUT))
+            !readOnReady(tmp, PLUGINPROCESS_START_TIMEOUT)) {
+            SignonMetrics::instance()->pluginStartFailed();
             return false;
+        }
+        SignonMetrics::instance()->pluginStarted(timer.nsecsElapsed() / 1000);
     }
     return true;
 }
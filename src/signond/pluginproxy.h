@@ -86,6 +86,9 @@ Q_SIGNALS:
                       const QString &message);
     void stateChanged(int state,
                       const QString &message);
+    /* Emitted with the monotonic times at which the plugin process
+     * received the request data and sent its reply */
+    void processTimed(qint64 receivedTime, qint64 repliedTime);
 
 private:
     QString queryType();
@@ -0,0 +1,219 @@
+/*
+ * This file is part of signon
+ *
+ * Copyright (C) 2013 Canonical Ltd.
+ *
+ * Contact: Alberto Mardegan <alberto.mardegan@canonical.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+#include "requesttracer.h"
+
+#include <QVariantMap>
+#include <QtAlgorithms>
+#include <time.h>
+#include <unistd.h>
+
+namespace SignonDaemonNS {
+
+Q_GLOBAL_STATIC(RequestTracer, tracerInstance)
+
+typedef QPair<QString, qint64> Stage;
+
+static bool stageLessThan(const Stage &a, const Stage &b)
+{
+    return a.second < b.second;
+}
+
+static QByteArray jsonString(const QString &string)
+{
+    QByteArray json("\"");
+    QByteArray utf8 = string.toUtf8();
+    for (int i = 0; i < utf8.size(); i++) {
+        char c = utf8[i];
+        if (c == '"' || c == '\\') {
+            json += '\\';
+            json += c;
+        } else if (uchar(c) < 0x20) {
+            json += "\\u00";
+            json += QByteArray::number(uchar(c), 16).rightJustified(2, '0');
+        } else {
+            json += c;
+        }
+    }
+    json += '"';
+    return json;
+}
+
+RequestTracer *RequestTracer::instance()
+{
+    return tracerInstance();
+}
+
+RequestTracer::RequestTracer(int capacity):
+    m_capacity(qMax(capacity, 1)),
+    m_next(0)
+{
+}
+
+RequestTracer::~RequestTracer()
+{
+}
+
+qint64 RequestTracer::timestamp()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return qint64(now.tv_sec) * 1000000 + now.tv_nsec / 1000;
+}
+
+void RequestTracer::setCapacity(int capacity)
+{
+    QList<Record> records = orderedRecords();
+    m_capacity = qMax(capacity, 1);
+    while (records.count() > m_capacity)
+        records.removeFirst();
+
+    m_records = records.toVector();
+    m_next = 0;
+}
+
+void RequestTracer::begin(quint64 id,
+                          const QString &key,
+                          const QString &method,
+                          const QString &mechanism)
+{
+    /* The requests which are dropped without being replied (for instance,
+     * when their session is destroyed) are never completed: don't let them
+     * pile up. */
+    if (m_pending.count() >= m_capacity && !m_pending.contains(id))
+        m_pending.erase(m_pending.begin());
+
+    Record &record = m_pending[id];
+    record.key = key;
+    record.method = method;
+    record.mechanism = mechanism;
+    record.status.clear();
+    record.stages.clear();
+    record.stages.append(Stage(QLatin1String("queued"), timestamp()));
+}
+
+void RequestTracer::mark(quint64 id, const QString &stage, qint64 time)
+{
+    QMap<quint64, Record>::iterator i = m_pending.find(id);
+    if (i == m_pending.end())
+        return;
+
+    i.value().stages.append(Stage(stage, time != 0 ? time : timestamp()));
+}
+
+void RequestTracer::end(quint64 id, const QString &status)
+{
+    QMap<quint64, Record>::iterator i = m_pending.find(id);
+    if (i == m_pending.end())
+        return;
+
+    Record record = i.value();
+    m_pending.erase(i);
+
+    record.status = status;
+    record.stages.append(Stage(QLatin1String("replied"), timestamp()));
+    /* The stages reported by the plugin process arrive after the fact */
+    qStableSort(record.stages.begin(), record.stages.end(), stageLessThan);
+
+    if (m_records.count() < m_capacity) {
+        m_records.append(record);
+    } else {
+        m_records[m_next] = record;
+        m_next = (m_next + 1) % m_capacity;
+    }
+}
+
+QList<RequestTracer::Record> RequestTracer::orderedRecords() const
+{
+    QList<Record> records;
+    for (int i = 0; i < m_records.count(); i++)
+        records.append(m_records[(m_next + i) % m_records.count()]);
+    return records;
+}
+
+QVariantList RequestTracer::records() const
+{
+    QVariantList list;
+    foreach (const Record &record, orderedRecords()) {
+        QVariantList stages;
+        foreach (const Stage &stage, record.stages) {
+            QVariantMap map;
+            map.insert(QLatin1String("Name"), stage.first);
+            map.insert(QLatin1String("Time"), stage.second);
+            stages.append(map);
+        }
+
+        QVariantMap map;
+        map.insert(QLatin1String("Key"), record.key);
+        map.insert(QLatin1String("Method"), record.method);
+        map.insert(QLatin1String("Mechanism"), record.mechanism);
+        map.insert(QLatin1String("Status"), record.status);
+        map.insert(QLatin1String("Stages"), stages);
+        list.append(map);
+    }
+    return list;
+}
+
+QByteArray RequestTracer::toChromeTrace() const
+{
+    QByteArray pid = QByteArray::number(qint64(getpid()));
+    QList<QByteArray> events;
+
+    int row = 0;
+    foreach (const Record &record, orderedRecords()) {
+        row++;
+        QByteArray common = ",\"pid\":" + pid +
+            ",\"tid\":" + QByteArray::number(row);
+
+        qint64 start = record.stages.first().second;
+        qint64 end = record.stages.last().second;
+        events.append("{\"name\":" +
+                      jsonString(record.method + QLatin1Char('/') +
+                                 record.mechanism) +
+                      ",\"cat\":\"request\",\"ph\":\"X\"" +
+                      ",\"ts\":" + QByteArray::number(start) +
+                      ",\"dur\":" + QByteArray::number(end - start) +
+                      common +
+                      ",\"args\":{\"key\":" + jsonString(record.key) +
+                      ",\"status\":" + jsonString(record.status) + "}}");
+
+        for (int i = 0; i + 1 < record.stages.count(); i++) {
+            const Stage &stage = record.stages[i];
+            qint64 duration = record.stages[i + 1].second - stage.second;
+            events.append("{\"name\":" + jsonString(stage.first) +
+                          ",\"cat\":\"stage\",\"ph\":\"X\"" +
+                          ",\"ts\":" + QByteArray::number(stage.second) +
+                          ",\"dur\":" + QByteArray::number(duration) +
+                          common + "}");
+        }
+    }
+
+    QByteArray json("{\"traceEvents\":[");
+    for (int i = 0; i < events.count(); i++) {
+        if (i > 0) json += ",\n";
+        json += events[i];
+    }
+    json += "],\"displayTimeUnit\":\"ms\"}\n";
+    return json;
+}
+
+} //namespace SignonDaemonNS
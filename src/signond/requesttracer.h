@@ -0,0 +1,128 @@
+/*
+ * This file is part of signon
+ *
+ * Copyright (C) 2013 Canonical Ltd.
+ *
+ * Contact: Alberto Mardegan <alberto.mardegan@canonical.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+
+/*!
+ * @file requesttracer.h
+ * Definition of the RequestTracer object.
+ * @ingroup Accounts_and_SSO_Framework
+ */
+
+#ifndef REQUESTTRACER_H_
+#define REQUESTTRACER_H_
+
+#include <QByteArray>
+#include <QList>
+#include <QMap>
+#include <QPair>
+#include <QString>
+#include <QVariantList>
+#include <QVector>
+
+namespace SignonDaemonNS {
+
+/*!
+ * @class RequestTracer
+ * Records the stages which each authentication request goes through, from
+ * the moment it reaches the daemon until the reply is sent. Requests are
+ * identified by their RequestData::m_requestId, which increases with every
+ * request; the stage times are taken from the monotonic clock, which is
+ * shared with the plugin processes.
+ * Completed requests are kept in a ring buffer holding the most recent ones.
+ * This object must be used from the main thread only.
+ */
+class RequestTracer
+{
+public:
+    enum { DefaultCapacity = 256 };
+
+    static RequestTracer *instance();
+
+    RequestTracer(int capacity = DefaultCapacity);
+    ~RequestTracer();
+
+    /*!
+     * @returns the current time of the monotonic clock, in microseconds.
+     */
+    static qint64 timestamp();
+
+    void setCapacity(int capacity);
+    int capacity() const { return m_capacity; }
+
+    /*!
+     * Starts a new record for the request @id, whose cancel key is @key;
+     * its first stage is "queued".
+     */
+    void begin(quint64 id,
+               const QString &key,
+               const QString &method,
+               const QString &mechanism);
+    /*!
+     * Adds a stage to the record of the request @id; if @time is 0, the
+     * current time is used.
+     */
+    void mark(quint64 id, const QString &stage, qint64 time = 0);
+    /*!
+     * Completes the record of the request @id and moves it to the ring
+     * buffer.
+     */
+    void end(quint64 id, const QString &status);
+
+    /*!
+     * @returns the completed records, oldest first. Each record is a map
+     * with the "Key", "Method", "Mechanism" and "Status" of the request,
+     * and the list of its "Stages", each with a "Name" and a "Time".
+     */
+    QVariantList records() const;
+
+    /*!
+     * @returns the completed records in the Chrome trace-event format, as
+     * understood by chrome://tracing: every request is shown on its own row,
+     * and every stage lasts until the next one begins.
+     */
+    QByteArray toChromeTrace() const;
+
+private:
+    /* stage name and time */
+    typedef QPair<QString, qint64> Stage;
+
+    struct Record {
+        QString key;
+        QString method;
+        QString mechanism;
+        QString status;
+        QList<Stage> stages;
+    };
+
+    QList<Record> orderedRecords() const;
+
+private:
+    int m_capacity;
+    /* ordered by request id, that is oldest first */
+    QMap<quint64, Record> m_pending;
+    QVector<Record> m_records;
+    int m_next;
+};
+
+} //namespace SignonDaemonNS
+
+#endif /* REQUESTTRACER_H_ */
@@ -25,6 +25,9 @@
 #include "signonauthsession.h"
 #include "signonauthsessionadaptor.h"
 
+#undef SIGNON_TRACE_CATEGORY
+#define SIGNON_TRACE_CATEGORY SignOn::SessionCategory
+
 using namespace SignonDaemonNS;
 
 SignonAuthSession::SignonAuthSession(quint32 id,
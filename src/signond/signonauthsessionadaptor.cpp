@@ -28,6 +28,9 @@
 #include "credentialsaccessmanager.h"
 #include "credentialsdb.h"
 
+#undef SIGNON_TRACE_CATEGORY
+#define SIGNON_TRACE_CATEGORY SignOn::SessionCategory
+
 namespace SignonDaemonNS {
 
 SignonAuthSessionAdaptor::SignonAuthSessionAdaptor(SignonAuthSession *parent):
@@ -50,6 +50,12 @@
  * */
 #define SIGNOND_MAX_IDLE_TIME 300
 
+/*
+ * In lazy mode, milliseconds after which the storage is opened even if no
+ * request needed it
+ * */
+#define SIGNOND_LAZY_INIT_DELAY 500
+
 /*
  * Signon UI DBUS defs
  * */
@@ -63,5 +69,6 @@ const char signonDefaultDbName[] = "signon.db";
 const char signonDefaultSecretsDbName[] = "signon-secrets.db";
 const bool signonDefaultUseEncryption = true;
 const char signonDefaultStoragePath[] = "~/.config/signond";
+const qint64 signonDefaultSecretsCacheMaxSize = 1024; // kB
 
 #endif // SIGNOND_COMMON_H_
@@ -17,6 +17,7 @@ HEADERS += \
     credentialsaccessmanager.h \
     credentialsdb.h \
     credentialsdb_p.h \
+    credentialsdbworker.h \
     default-crypto-manager.h \
     default-key-authorizer.h \
     default-secrets-storage.h \
@@ -27,6 +28,10 @@ HEADERS += \
     signond-common.h \
     signondaemonadaptor.h \
     signondaemon.h \
+    signonmetrics.h \
+    signonmetricsadaptor.h \
+    signonloggingadaptor.h \
+    requesttracer.h \
     signondisposable.h \
     signontrace.h \
     pluginproxy.h \
@@ -39,6 +44,7 @@ SOURCES += \
     accesscontrolmanagerhelper.cpp \
     credentialsaccessmanager.cpp \
     credentialsdb.cpp \
+    credentialsdbworker.cpp \
     default-crypto-manager.cpp \
     default-key-authorizer.cpp \
     default-secrets-storage.cpp \
@@ -47,6 +53,10 @@ SOURCES += \
     signonauthsession.cpp \
     signonidentity.cpp \
     signondaemonadaptor.cpp \
+    signonmetrics.cpp \
+    signonmetricsadaptor.cpp \
+    signonloggingadaptor.cpp \
+    requesttracer.cpp \
     signondisposable.cpp \
     signonui_interface.cpp \
     pluginproxy.cpp \
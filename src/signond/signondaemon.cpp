@@ -23,9 +23,15 @@
  */
 
 extern "C" {
+    #include <fcntl.h>
+    #include <sys/ioctl.h>
     #include <sys/socket.h>
     #include <sys/stat.h>
+    #include <sys/syscall.h>
     #include <sys/types.h>
+#ifdef __linux__
+    #include <linux/fs.h>
+#endif
 }
 
 #define QT_DISABLE_DEPRECATED_BEFORE QT_VERSION_CHECK(4, 0, 0)
@@ -48,6 +54,8 @@ extern "C" {
 #include "signond-common.h"
 #include "signontrace.h"
 #include "signondaemonadaptor.h"
+#include "signonloggingadaptor.h"
+#include "signonmetricsadaptor.h"
 #include "signonidentity.h"
 #include "signonauthsession.h"
 #include "accesscontrolmanagerhelper.h"
@@ -78,7 +86,10 @@ SignonDaemonConfiguration::SignonDaemonConfiguration():
     m_camConfiguration(),
     m_daemonTimeout(0), // 0 = no timeout
     m_identityTimeout(300),//secs
-    m_authSessionTimeout(300)//secs
+    m_authSessionTimeout(300),//secs
+    m_maxQueuedRequests(0), // 0 = no limit
+    m_maxQueuedRequestsPerPeer(0),
+    m_lazyInit(false)
 {}
 
 SignonDaemonConfiguration::~SignonDaemonConfiguration()
@@ -94,6 +105,9 @@ SignonDaemonConfiguration::~SignonDaemonConfiguration()
     StoragePath=~/.signon/
     ;0 - fatal, 1 - critical(default), 2 - info/debug
     LoggingLevel=1
+    LoggingCategories=general,db,plugin,acl,session
+    MetadataReaderThreads=0
+    LazyInit=false
 
     [SecureStorage]
     FileSystemName=signonfs
@@ -103,6 +117,10 @@ SignonDaemonConfiguration::~SignonDaemonConfiguration()
     [ObjectTimeouts]
     IdentityTimeout=300
     AuthSessionTimeout=300
+
+    [RequestQueue]
+    MaxQueuedRequests=0
+    MaxQueuedRequestsPerPeer=0
  */
 void SignonDaemonConfiguration::load()
 {
@@ -120,6 +138,22 @@ void SignonDaemonConfiguration::load()
         settings.value(QLatin1String("LoggingLevel"), 1).toInt();
     setLoggingLevel(loggingLevel);
 
+    QVariant loggingCategories =
+        settings.value(QLatin1String("LoggingCategories"));
+    if (loggingCategories.isValid()) {
+        setLoggingCategories(
+            loggingCategoriesFromNames(loggingCategories.toStringList()));
+    }
+
+    QVariant readerThreads =
+        settings.value(QLatin1String("MetadataReaderThreads"));
+    if (readerThreads.isValid()) {
+        m_camConfiguration.addSetting(QLatin1String("MetadataReaderThreads"),
+                                      readerThreads);
+    }
+
+    m_lazyInit = settings.value(QLatin1String("LazyInit"), false).toBool();
+
     QString cfgStoragePath =
         settings.value(QLatin1String("StoragePath")).toString();
     if (!cfgStoragePath.isEmpty()) {
@@ -171,6 +205,20 @@ void SignonDaemonConfiguration::load()
 
     settings.endGroup();
 
+    //Request queue limits
+    settings.beginGroup(QLatin1String("RequestQueue"));
+
+    aux = settings.value(QLatin1String("MaxQueuedRequests")).toUInt(&isOk);
+    if (isOk)
+        m_maxQueuedRequests = aux;
+
+    aux = settings.value(QLatin1String("MaxQueuedRequestsPerPeer")).
+        toUInt(&isOk);
+    if (isOk)
+        m_maxQueuedRequestsPerPeer = aux;
+
+    settings.endGroup();
+
     //Environment variables
 
     int value = 0;
@@ -192,6 +240,24 @@ void SignonDaemonConfiguration::load()
         if (value > 0 && isOk) m_authSessionTimeout = value;
     }
 
+    if (environment.contains(QLatin1String("SSO_MAX_QUEUED_REQUESTS"))) {
+        value = environment.value(
+            QLatin1String("SSO_MAX_QUEUED_REQUESTS")).toInt(&isOk);
+        if (value >= 0 && isOk) m_maxQueuedRequests = value;
+    }
+
+    if (environment.contains(
+            QLatin1String("SSO_MAX_QUEUED_REQUESTS_PER_PEER"))) {
+        value = environment.value(
+            QLatin1String("SSO_MAX_QUEUED_REQUESTS_PER_PEER")).toInt(&isOk);
+        if (value >= 0 && isOk) m_maxQueuedRequestsPerPeer = value;
+    }
+
+    if (environment.contains(QLatin1String("SSO_LAZY_INIT"))) {
+        m_lazyInit = environment.value(QLatin1String("SSO_LAZY_INIT")) ==
+            QLatin1String("1");
+    }
+
     if (environment.contains(QLatin1String("SSO_LOGGING_LEVEL"))) {
         value = environment.value(
             QLatin1String("SSO_LOGGING_LEVEL")).toInt(&isOk);
@@ -199,6 +265,13 @@ void SignonDaemonConfiguration::load()
             setLoggingLevel(value);
     }
 
+    if (environment.contains(QLatin1String("SSO_LOGGING_CATEGORIES"))) {
+        QString names =
+            environment.value(QLatin1String("SSO_LOGGING_CATEGORIES"));
+        setLoggingCategories(
+            loggingCategoriesFromNames(names.split(QLatin1Char(','))));
+    }
+
     QString logOutput = environment.value(QLatin1String("SSO_LOGGING_OUTPUT"),
                                           QLatin1String("syslog"));
     SignonTrace::initialize(logOutput == QLatin1String("syslog") ?
@@ -252,8 +325,13 @@ SignonDaemon::SignonDaemon(QObject *parent):
     QObject(parent),
     m_configuration(0),
     m_pCAMManager(0),
+    m_storageInitialized(false),
+    m_startupReport(false),
     m_dbusServer(0)
 {
+    m_startupTimer.start();
+    m_phaseTimer.start();
+
     // Files created by signond must be unreadable by "other"
     umask(S_IROTH | S_IWOTH);
 
@@ -385,6 +463,7 @@ void SignonDaemon::init()
         qWarning("SignonDaemon could not create the configuration object.");
 
     m_configuration->load();
+    addStartupPhase("configuration");
 
     if (getuid() != 0) {
         BLAME() << "Failed to SUID root. Secure storage will not be available.";
@@ -397,6 +476,8 @@ void SignonDaemon::init()
 
     setupSignalHandlers();
     m_backup = app->arguments().contains(QLatin1String("-backup"));
+    m_startupReport =
+        app->arguments().contains(QLatin1String("--startup-report"));
     m_pCAMManager =
         new CredentialsAccessManager(m_configuration->camConfiguration());
 
@@ -434,6 +515,8 @@ void SignonDaemon::init()
         qFatal("SignonDaemon requires to register backup service");
     }
 
+    addStartupPhase("backup service");
+
     if (m_backup) {
         TRACE() << "Signond initialized in backup mode.";
         //skip rest of initialization in backup mode
@@ -456,6 +539,8 @@ void SignonDaemon::init()
         QDBusConnection::ExportAllContents;
 
     (void)new SignonDaemonAdaptor(this);
+    (void)new SignonMetricsAdaptor(this);
+    (void)new SignonLoggingAdaptor(this);
     registerOptions = QDBusConnection::ExportAdaptors;
 
     // p2p connection
@@ -488,11 +573,17 @@ void SignonDaemon::init()
                        QLatin1String("org.freedesktop.DBus.Local"),
                        QLatin1String("Disconnected"),
                        this, SLOT(onDisconnected()));
-
-    initExtensions();
-
-    if (!initStorage())
-        BLAME() << "Signond: Cannot initialize credentials storage.";
+    addStartupPhase("bus registration");
+
+    if (m_configuration->lazyInit()) {
+        /* Requests which don't need the storage (such as queryMethods) are
+         * answered right away; the storage is opened as soon as a request
+         * needs it, or when the daemon is otherwise idle. */
+        QTimer::singleShot(SIGNOND_LAZY_INIT_DELAY,
+                           this, SLOT(ensureStorage()));
+    } else {
+        ensureStorage();
+    }
 
     if (m_configuration->daemonTimeout() > 0) {
         SignonDisposable::invokeOnIdle(m_configuration->daemonTimeout(),
@@ -500,6 +591,30 @@ void SignonDaemon::init()
     }
 
     TRACE() << "Signond SUCCESSFULLY initialized.";
+    if (m_storageInitialized) reportStartup();
+}
+
+void SignonDaemon::addStartupPhase(const char *name)
+{
+    StartupPhase phase;
+    phase.name = name;
+    phase.duration = m_phaseTimer.nsecsElapsed() / 1000;
+    phase.end = m_startupTimer.nsecsElapsed() / 1000;
+    m_startupPhases.append(phase);
+    m_phaseTimer.restart();
+
+    TRACE() << "Startup phase" << name << "took" << phase.duration << "us";
+}
+
+void SignonDaemon::reportStartup()
+{
+    if (!m_startupReport) return;
+
+    foreach (const StartupPhase &phase, m_startupPhases) {
+        fprintf(stderr, "signond startup: %-20s %10lld us (at %lld us)\n",
+                phase.name, (long long)phase.duration, (long long)phase.end);
+    }
+    fflush(stderr);
 }
 
 void SignonDaemon::onNewConnection(const QDBusConnection &connection)
@@ -512,18 +627,68 @@ void SignonDaemon::onNewConnection(const QDBusConnection &connection)
     }
 }
 
+void SignonDaemon::ensureStorage()
+{
+    if (m_storageInitialized || m_backup) return;
+    m_storageInitialized = true;
+
+    m_phaseTimer.restart();
+    initExtensions();
+    addStartupPhase("extensions");
+
+    if (!initStorage())
+        BLAME() << "Signond: Cannot initialize credentials storage.";
+
+    /* In lazy mode, the daemon has already completed its startup */
+    if (m_configuration->lazyInit()) reportStartup();
+}
+
 void SignonDaemon::initExtensions()
 {
     /* Scan the directory containing signond extensions and attempt loading
-     * all of them.
+     * all of them; in lazy mode, only those named in the configuration.
      */
     QDir dir(m_configuration->extensionsDir());
-    QStringList filters(QLatin1String("lib*.so"));
-    QStringList extensionList = dir.entryList(filters, QDir::Files);
+    QStringList extensionList;
+    if (!m_configuration->lazyInit() ||
+        !selectExtensions(dir, extensionList)) {
+        QStringList filters(QLatin1String("lib*.so"));
+        extensionList = dir.entryList(filters, QDir::Files);
+    }
     foreach(const QString &filename, extensionList)
         initExtension(dir.filePath(filename));
 }
 
+bool SignonDaemon::selectExtensions(const QDir &dir,
+                                    QStringList &fileNames) const
+{
+    const CAMConfiguration &config = m_configuration->camConfiguration();
+
+    /* Key managers can come from any extension, and they are needed as soon
+     * as the storage is encrypted */
+    if (config.useEncryption()) return false;
+
+    QStringList names;
+    names << config.accessControlManagerName() <<
+        config.secretsStorageName();
+    foreach (const QString &name, names) {
+        /* Any extension could provide it */
+        if (name.isEmpty()) return false;
+        if (name == QLatin1String("default")) continue;
+
+        QString fileName = QString::fromLatin1("lib%1.so").arg(name);
+        if (!dir.exists(fileName)) {
+            TRACE() << "Extension file not found:" << fileName;
+            return false;
+        }
+        if (!fileNames.contains(fileName))
+            fileNames.append(fileName);
+    }
+
+    TRACE() << "Loading the configured extensions:" << fileNames;
+    return true;
+}
+
 void SignonDaemon::initExtension(const QString &filePath)
 {
     TRACE() << "Loading plugin " << filePath;
@@ -550,12 +715,14 @@ bool SignonDaemon::initStorage()
             BLAME() << "CAM initialization failed";
             return false;
         }
+        addStartupPhase("CAM init");
 
         // If encryption is in use this will just open the metadata DB
         if (!m_pCAMManager->openCredentialsSystem()) {
             qCritical("Signond: Cannot open CAM credentials system...");
             return false;
         }
+        addStartupPhase("credentials system");
     } else {
         TRACE() << "Secure storage already initialized...";
         return false;
@@ -616,6 +783,18 @@ int SignonDaemon::authSessionTimeout() const
                                      m_configuration->authSessionTimeout());
 }
 
+int SignonDaemon::maxQueuedRequests() const
+{
+    return (m_configuration == NULL ?
+            0 : m_configuration->maxQueuedRequests());
+}
+
+int SignonDaemon::maxQueuedRequestsPerPeer() const
+{
+    return (m_configuration == NULL ?
+            0 : m_configuration->maxQueuedRequestsPerPeer());
+}
+
 QObject *SignonDaemon::getIdentity(const quint32 id,
                                    QVariantMap &identityData)
 {
@@ -741,6 +920,14 @@ QList<QVariantMap> SignonDaemon::queryIdentities(const QVariantMap &filter)
     return mapList;
 }
 
+CredentialsDBWorker *SignonDaemon::credentialsDBWorker() const
+{
+    if (m_pCAMManager == 0 || !m_pCAMManager->credentialsSystemOpened())
+        return 0;
+
+    return m_pCAMManager->credentialsDBWorker();
+}
+
 bool SignonDaemon::clear()
 {
     clearLastError();
@@ -780,6 +967,52 @@ QObject *SignonDaemon::getAuthSession(const quint32 id,
     return authSession;
 }
 
+/* Copies a file sharing its blocks with the source, where the file system
+ * supports it (reflink), or else copying them within the kernel; falls back
+ * to a plain copy. */
+static bool copyFile(const QString &source, const QString &destination)
+{
+    int in = ::open(QFile::encodeName(source).constData(),
+                    O_RDONLY | O_CLOEXEC);
+    if (in < 0) return false;
+
+    int out = ::open(QFile::encodeName(destination).constData(),
+                     O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC,
+                     S_IRUSR | S_IWUSR);
+    if (out < 0) {
+        ::close(in);
+        return false;
+    }
+
+    bool ok = false;
+#ifdef FICLONE
+    ok = (::ioctl(out, FICLONE, in) == 0);
+#endif
+#ifdef SYS_copy_file_range
+    struct stat sourceStat;
+    if (!ok && ::fstat(in, &sourceStat) == 0) {
+        off_t remaining = sourceStat.st_size;
+        ok = true;
+        while (ok && remaining > 0) {
+            ssize_t copied = ::syscall(SYS_copy_file_range, in, NULL,
+                                       out, NULL, size_t(remaining), 0);
+            if (copied > 0)
+                remaining -= copied;
+            else
+                ok = false;
+        }
+    }
+#endif
+
+    ::close(in);
+    ::close(out);
+    if (ok) return true;
+
+    TRACE() << "Fast copy not supported for" << source;
+    QFile::remove(destination);
+    return QFile::copy(source, destination);
+}
+
 void SignonDaemon::eraseBackupDir() const
 {
     const CAMConfiguration config = m_configuration->camConfiguration();
@@ -796,6 +1029,33 @@ void SignonDaemon::eraseBackupDir() const
     target.rmdir(backupRoot);
 }
 
+bool SignonDaemon::backupMetaDataDB() const
+{
+    CredentialsDB *db = m_pCAMManager->credentialsDB();
+    if (db == 0) return false;
+
+    const CAMConfiguration config = m_configuration->camConfiguration();
+    QString backupRoot = config.m_storagePath + BACKUP_DIR_NAME();
+
+    QDir target(backupRoot);
+    if (!target.exists() && !target.mkpath(backupRoot)) {
+        qCritical() << "Cannot create target directory";
+        return false;
+    }
+
+    setUserOwnership(backupRoot);
+
+    QString destination = backupRoot + QDir::separator() + config.m_dbName;
+    if (!db->backupMetaDataDB(destination)) {
+        TRACE() << "Online backup failed:" << db->lastError().text();
+        QFile::remove(destination);
+        return false;
+    }
+
+    setUserOwnership(destination);
+    return true;
+}
+
 bool SignonDaemon::copyToBackupDir(const QStringList &fileNames) const
 {
     const CAMConfiguration config = m_configuration->camConfiguration();
@@ -821,7 +1081,7 @@ bool SignonDaemon::copyToBackupDir(const QStringList &fileNames) const
         if (!QFile::exists(source)) continue;
 
         QString destination = backupRoot + QDir::separator() + fileName;
-        ok = QFile::copy(source, destination);
+        ok = copyFile(source, destination);
         if (!ok) {
             BLAME() << "Copying" << source << "to" << destination << "failed";
             break;
@@ -868,7 +1128,7 @@ bool SignonDaemon::copyFromBackupDir(const QStringList &fileNames) const
         QString destination =
             config.m_storagePath + QDir::separator() + fileName;
 
-        ok = QFile::copy(source, destination);
+        ok = copyFile(source, destination);
         if (ok) {
             copiedFiles << fileName;
         } else {
@@ -930,22 +1190,15 @@ bool SignonDaemon::createStorageFileTree(const QStringList &backupFiles) const
 uchar SignonDaemon::backupStarts()
 {
     TRACE() << "backup";
-    if (!m_backup && m_pCAMManager->credentialsSystemOpened())
-    {
-        m_pCAMManager->closeCredentialsSystem();
-        if (m_pCAMManager->credentialsSystemOpened())
-        {
-            qCritical() << "Cannot close credentials database";
-            return 2;
-        }
-    }
+    ensureStorage();
 
     const CAMConfiguration config = m_configuration->camConfiguration();
 
     /* do backup copy: prepare the list of files to be backed up */
+    QStringList storageFiles = m_pCAMManager->backupFiles();
     QStringList backupFiles;
     backupFiles << config.m_dbName;
-    backupFiles << m_pCAMManager->backupFiles();
+    backupFiles << storageFiles;
 
     /* make sure that all the backup files and storage directory exist:
        create storage dir and empty files if not so, as backup/restore
@@ -955,16 +1208,36 @@ uchar SignonDaemon::backupStarts()
         return 2;
     }
 
-    /* perform the copy */
     eraseBackupDir();
-    if (!copyToBackupDir(backupFiles)) {
+
+    /* The metadata DB is copied while open, so that requests keep being
+     * served; the files of the secure storage can only be copied while the
+     * credentials system is closed */
+    QStringList closedFiles = backupFiles;
+    if (!m_backup && m_pCAMManager->credentialsSystemOpened() &&
+        backupMetaDataDB())
+        closedFiles = storageFiles;
+
+    if (!closedFiles.isEmpty() && !m_backup &&
+        m_pCAMManager->credentialsSystemOpened())
+    {
+        m_pCAMManager->closeCredentialsSystem();
+        if (m_pCAMManager->credentialsSystemOpened())
+        {
+            qCritical() << "Cannot close credentials database";
+            return 2;
+        }
+    }
+
+    /* perform the copy */
+    if (!copyToBackupDir(closedFiles)) {
         qCritical() << "Cannot copy database";
-        if (!m_backup)
+        if (!m_backup && !m_pCAMManager->credentialsSystemOpened())
             m_pCAMManager->openCredentialsSystem();
         return 2;
     }
 
-    if (!m_backup)
+    if (!m_backup && !m_pCAMManager->credentialsSystemOpened())
     {
         //mount file system back
         if (!m_pCAMManager->openCredentialsSystem()) {
@@ -1002,6 +1275,7 @@ uchar SignonDaemon::restoreStarts()
 uchar SignonDaemon::restoreFinished()
 {
     TRACE() << "restore";
+    ensureStorage();
     //restore requested
     if (m_pCAMManager->credentialsSystemOpened())
     {
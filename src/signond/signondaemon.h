@@ -80,6 +80,11 @@ public:
     uint daemonTimeout() const { return m_daemonTimeout; }
     uint identityTimeout() const { return m_identityTimeout; }
     uint authSessionTimeout() const { return m_authSessionTimeout; }
+    uint maxQueuedRequests() const { return m_maxQueuedRequests; }
+    uint maxQueuedRequestsPerPeer() const {
+        return m_maxQueuedRequestsPerPeer;
+    }
+    bool lazyInit() const { return m_lazyInit; }
 
 private:
     QString m_pluginsDir;
@@ -93,6 +98,12 @@ private:
     uint m_daemonTimeout;
     uint m_identityTimeout;
     uint m_authSessionTimeout;
+
+    //request queue limits
+    uint m_maxQueuedRequests;
+    uint m_maxQueuedRequestsPerPeer;
+
+    bool m_lazyInit;
 };
 
 class SignonIdentity;
@@ -122,6 +133,17 @@ public:
     int identityTimeout() const;
     int authSessionTimeout() const;
 
+    /*!
+     * Returns the maximum number of requests which can be queued on an
+     * authentication session core (0 means no limit).
+     */
+    int maxQueuedRequests() const;
+    /*!
+     * Returns the maximum number of requests which a single client can have
+     * queued at the same time (0 means no limit).
+     */
+    int maxQueuedRequestsPerPeer() const;
+
 public:
     QObject *registerNewIdentity();
     QObject *getIdentity(const quint32 id, QVariantMap &identityData);
@@ -131,6 +153,7 @@ public:
     QStringList queryMethods();
     QStringList queryMechanisms(const QString &method);
     QList<QVariantMap> queryIdentities(const QVariantMap &filter);
+    CredentialsDBWorker *credentialsDBWorker() const;
     bool clear();
 
     QString lastErrorName() const { return m_lastErrorName; }
@@ -143,6 +166,14 @@ private Q_SLOTS:
     void onIdentityStored(SignonIdentity *identity);
     void onIdentityDestroyed();
 
+public Q_SLOTS:
+    /*!
+     * Loads the extensions and opens the credentials storage, if this has
+     * not been done yet; in lazy mode, this is called when a request first
+     * needs the storage, or shortly after the daemon has started.
+     */
+    void ensureStorage();
+
 public Q_SLOTS: // backup METHODS
     uchar backupStarts();
     uchar backupFinished();
@@ -152,13 +183,18 @@ public Q_SLOTS: // backup METHODS
 private:
     SignonDaemon(QObject *parent);
     void initExtensions();
+    bool selectExtensions(const QDir &dir, QStringList &fileNames) const;
     void initExtension(const QString &filePath);
     bool initStorage();
 
+    void addStartupPhase(const char *name);
+    void reportStartup();
+
     void watchIdentity(SignonIdentity *identity);
     void setupSignalHandlers();
 
     void eraseBackupDir() const;
+    bool backupMetaDataDB() const;
     bool copyToBackupDir(const QStringList &fileNames) const;
     bool copyFromBackupDir(const QStringList &fileNames) const;
     bool createStorageFileTree(const QStringList &fileNames) const;
@@ -180,6 +216,21 @@ private:
     CredentialsAccessManager *m_pCAMManager;
 
     bool m_backup;
+    bool m_storageInitialized;
+
+    /*
+     * Startup timing: durations and end times are in microseconds from the
+     * creation of the daemon object
+     * */
+    struct StartupPhase {
+        const char *name;
+        qint64 duration;
+        qint64 end;
+    };
+    QElapsedTimer m_startupTimer;
+    QElapsedTimer m_phaseTimer;
+    QList<StartupPhase> m_startupPhases;
+    bool m_startupReport;
 
     int m_identityTimeout;
     int m_authSessionTimeout;
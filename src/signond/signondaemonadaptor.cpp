@@ -43,6 +43,8 @@ SignonDaemonAdaptor::~SignonDaemonAdaptor()
 
 void SignonDaemonAdaptor::registerNewIdentity(QDBusObjectPath &objectPath)
 {
+    m_parent->ensureStorage();
+
     QObject *identity = m_parent->registerNewIdentity();
     objectPath = registerObject(parentDBusContext().connection(), identity);
 
@@ -105,6 +107,8 @@ void SignonDaemonAdaptor::getIdentity(const quint32 id,
                                       QDBusObjectPath &objectPath,
                                       QVariantMap &identityData)
 {
+    m_parent->ensureStorage();
+
     AccessControlManagerHelper *acm = AccessControlManagerHelper::instance();
     QDBusMessage msg = parentDBusContext().message();
     QDBusConnection conn = parentDBusContext().connection();
@@ -156,6 +160,55 @@ void SignonDaemonAdaptor::onIdentityAccessReplyFinished()
     SignonDisposable::destroyUnused();
 }
 
+void SignonDaemonAdaptor::getIdentities(const QList<uint> &ids,
+                                        QList<QDBusObjectPath> &objectPaths,
+                                        MapList &identitiesData)
+{
+    QDBusMessage msg = parentDBusContext().message();
+    QDBusConnection conn = parentDBusContext().connection();
+
+    /* Don't let a single call keep the daemon busy */
+    if (ids.count() > SIGNOND_MAX_IDENTITIES_PER_CALL) {
+        TRACE() << "Too many identities requested:" << ids.count();
+        msg.setDelayedReply(true);
+        conn.send(msg.createErrorReply(SIGNOND_INVALID_QUERY_ERR_NAME,
+                                       SIGNOND_INVALID_QUERY_ERR_STR));
+        return;
+    }
+
+    m_parent->ensureStorage();
+
+    AccessControlManagerHelper *acm = AccessControlManagerHelper::instance();
+
+    foreach (uint id, ids) {
+        QObject *identity = 0;
+        QVariantMap identityData;
+
+        /* Identities which the peer is not allowed to use right away are not
+         * returned: the client will need to call getIdentity() on them, which
+         * can ask the access control manager for access. The same is done
+         * for non existing identities, so that the client gets the error. */
+        if (acm->isPeerAllowedToUseIdentity(conn, msg, id)) {
+            identity = m_parent->getIdentity(id, identityData);
+            if (identity == 0 &&
+                m_parent->lastErrorName() !=
+                SIGNOND_IDENTITY_NOT_FOUND_ERR_NAME) {
+                handleLastError(conn, msg);
+                return;
+            }
+        }
+
+        if (identity != 0) {
+            objectPaths.append(registerObject(conn, identity));
+        } else {
+            objectPaths.append(QDBusObjectPath(QLatin1String("/")));
+        }
+        identitiesData.append(identityData);
+    }
+
+    SignonDisposable::destroyUnused();
+}
+
 QStringList SignonDaemonAdaptor::queryMethods()
 {
     return m_parent->queryMethods();
@@ -165,11 +218,15 @@ QString SignonDaemonAdaptor::getAuthSessionObjectPath(const quint32 id,
                                                       const QString &type)
 {
     SignonDisposable::destroyUnused();
+    m_parent->ensureStorage();
 
     AccessControlManagerHelper *acm = AccessControlManagerHelper::instance();
     QDBusMessage msg = parentDBusContext().message();
     QDBusConnection conn = parentDBusContext().connection();
 
+    /* The PID will be needed to create the AuthSession */
+    acm->prefetchPidOfPeer(conn, msg);
+
     /* Access Control */
     if (id != SIGNOND_NEW_IDENTITY) {
         if (!acm->isPeerAllowedToUseIdentity(conn, msg, id)) {
@@ -185,6 +242,8 @@ QString SignonDaemonAdaptor::getAuthSessionObjectPath(const quint32 id,
         }
     }
 
+    if (waitForPidOfPeer(conn, msg, id, type)) return QString();
+
     TRACE() << "ACM passed, creating AuthSession object";
     pid_t ownerPid = acm->pidOfPeer(conn, msg);
     QObject *authSession = m_parent->getAuthSession(id, type, ownerPid);
@@ -194,6 +253,60 @@ QString SignonDaemonAdaptor::getAuthSessionObjectPath(const quint32 id,
     return objectPath.path();
 }
 
+bool SignonDaemonAdaptor::waitForPidOfPeer(const QDBusConnection &conn,
+                                           const QDBusMessage &msg,
+                                           quint32 id, const QString &type)
+{
+    /* Rather than blocking on the bus daemon, the AuthSession is created
+     * once the PID of the peer is known */
+    AccessControlManagerHelper *acm = AccessControlManagerHelper::instance();
+    if (!acm->isPidOfPeerPending(msg)) return false;
+
+    QObject::connect(acm, SIGNAL(peerPidResolved(const QString&)),
+                     this, SLOT(onPeerPidResolved(const QString&)),
+                     Qt::UniqueConnection);
+    msg.setDelayedReply(true);
+    m_pidWaiters.append(AuthSessionRequest(conn, msg, id, type));
+    return true;
+}
+
+void SignonDaemonAdaptor::onPeerPidResolved(const QString &uniqueName)
+{
+    QList<AuthSessionRequest> requests;
+    QList<AuthSessionRequest>::iterator i = m_pidWaiters.begin();
+    while (i != m_pidWaiters.end()) {
+        if (i->message.service() == uniqueName) {
+            requests.append(*i);
+            i = m_pidWaiters.erase(i);
+        } else {
+            ++i;
+        }
+    }
+
+    foreach (const AuthSessionRequest &request, requests) {
+        TRACE() << "PID resolved, creating AuthSession object";
+        authSessionReply(request.connection, request.message,
+                         request.id, request.type);
+    }
+
+    SignonDisposable::destroyUnused();
+}
+
+void SignonDaemonAdaptor::authSessionReply(const QDBusConnection &connection,
+                                           const QDBusMessage &message,
+                                           quint32 id, const QString &type)
+{
+    AccessControlManagerHelper *acm = AccessControlManagerHelper::instance();
+    pid_t ownerPid = acm->pidOfPeer(connection, message);
+    QObject *authSession = m_parent->getAuthSession(id, type, ownerPid);
+    if (handleLastError(connection, message)) return;
+    QDBusObjectPath objectPath = registerObject(connection, authSession);
+
+    QVariantList args;
+    args << QVariant::fromValue(objectPath);
+    connection.send(message.createReply(args));
+}
+
 void SignonDaemonAdaptor::onAuthSessionAccessReplyFinished()
 {
     SignOn::AccessReply *reply = qobject_cast<SignOn::AccessReply*>(sender());
@@ -213,14 +326,9 @@ void SignonDaemonAdaptor::onAuthSessionAccessReplyFinished()
         return;
     }
 
-    pid_t ownerPid = acm->pidOfPeer(connection, message);
-    QObject *authSession = m_parent->getAuthSession(id, type, ownerPid);
-    if (handleLastError(connection, message)) return;
-    QDBusObjectPath objectPath = registerObject(connection, authSession);
+    if (waitForPidOfPeer(connection, message, id, type)) return;
 
-    QVariantList args;
-    args << QVariant::fromValue(objectPath);
-    connection.send(message.createReply(args));
+    authSessionReply(connection, message, id, type);
 
     SignonDisposable::destroyUnused();
 }
@@ -238,6 +346,8 @@ QStringList SignonDaemonAdaptor::queryMechanisms(const QString &method)
 
 void SignonDaemonAdaptor::queryIdentities(const QVariantMap &filter)
 {
+    m_parent->ensureStorage();
+
     /* Access Control */
     QDBusMessage msg = parentDBusContext().message();
     QDBusConnection conn = parentDBusContext().connection();
@@ -248,6 +358,14 @@ void SignonDaemonAdaptor::queryIdentities(const QVariantMap &filter)
     }
 
     msg.setDelayedReply(true);
+
+    /* The query runs in the DB thread, which also sends the reply */
+    CredentialsDBWorker *dbWorker = m_parent->credentialsDBWorker();
+    if (dbWorker != 0) {
+        dbWorker->queryIdentities(filter, conn, msg);
+        return;
+    }
+
     MapList identities = m_parent->queryIdentities(filter);
     if (handleLastError(conn, msg)) return;
 
@@ -257,6 +375,8 @@ void SignonDaemonAdaptor::queryIdentities(const QVariantMap &filter)
 
 bool SignonDaemonAdaptor::clear()
 {
+    m_parent->ensureStorage();
+
     /* Access Control */
     QDBusMessage msg = parentDBusContext().message();
     QDBusConnection conn = parentDBusContext().connection();
@@ -53,6 +53,9 @@ public Q_SLOTS:
     void registerNewIdentity(QDBusObjectPath &objectPath);
     void getIdentity(const quint32 id, QDBusObjectPath &objectPath,
                      QVariantMap &identityData);
+    void getIdentities(const QList<uint> &ids,
+                       QList<QDBusObjectPath> &objectPaths,
+                       MapList &identitiesData);
     QString getAuthSessionObjectPath(const quint32 id, const QString &type);
 
     QStringList queryMethods();
@@ -68,13 +71,33 @@ private:
                          const QDBusMessage &message);
     QDBusObjectPath registerObject(const QDBusConnection &connection,
                                    QObject *object);
+    bool waitForPidOfPeer(const QDBusConnection &connection,
+                          const QDBusMessage &message,
+                          quint32 id, const QString &type);
+    void authSessionReply(const QDBusConnection &connection,
+                          const QDBusMessage &message,
+                          quint32 id, const QString &type);
 
 private Q_SLOTS:
     void onIdentityAccessReplyFinished();
     void onAuthSessionAccessReplyFinished();
+    void onPeerPidResolved(const QString &uniqueName);
 
 private:
+    /* An AuthSession request waiting for the PID of its peer */
+    struct AuthSessionRequest {
+        AuthSessionRequest(const QDBusConnection &connection,
+                           const QDBusMessage &message,
+                           quint32 id, const QString &type):
+            connection(connection), message(message), id(id), type(type) {}
+        QDBusConnection connection;
+        QDBusMessage message;
+        quint32 id;
+        QString type;
+    };
+
     SignonDaemon *m_parent;
+    QList<AuthSessionRequest> m_pidWaiters;
 }; //class SignonDaemonAdaptor
 
 } //namespace SignonDaemonNS
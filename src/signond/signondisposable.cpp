@@ -54,6 +54,17 @@ SignonDisposable::~SignonDisposable()
     disposableObjects.removeOne(this);
 }
 
+QVariantMap SignonDisposable::objectCounts()
+{
+    QVariantMap counts;
+    foreach (SignonDisposable *object, disposableObjects) {
+        QString className =
+            QString::fromLatin1(object->metaObject()->className());
+        counts[className] = counts.value(className).toInt() + 1;
+    }
+    return counts;
+}
+
 void SignonDisposable::keepInUse() const
 {
     struct timespec ts;
@@ -83,6 +83,11 @@ public:
     static void invokeOnIdle(int maxInactivity,
                              QObject *object, const char *member);
 
+    /*!
+     * @returns the number of live disposable objects, by class name.
+     */
+    static QVariantMap objectCounts();
+
 public Q_SLOTS:
     /*!
      * Deletes all disposable object for which the inactivity time has
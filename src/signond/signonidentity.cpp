@@ -256,6 +256,17 @@ QVariantMap SignonIdentity::getInfo()
 
     SIGNON_RETURN_IF_CAM_UNAVAILABLE(QVariantMap());
 
+    /* Unless the info is already loaded, read it in the DB thread, which
+     * also sends the reply */
+    CredentialsDBWorker *dbWorker =
+        CredentialsAccessManager::instance()->credentialsDBWorker();
+    if (m_pInfo == 0 && dbWorker != 0) {
+        keepInUse();
+        setDelayedReply(true);
+        dbWorker->identityInfo(m_id, connection(), message());
+        return QVariantMap();
+    }
+
     bool ok;
     SignonIdentityInfo info = queryInfo(ok, false);
 
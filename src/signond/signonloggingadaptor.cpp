@@ -0,0 +1,88 @@
+/*
+ * This file is part of signon
+ *
+ * Copyright (C) 2013 Canonical Ltd.
+ *
+ * Contact: Alberto Mardegan <alberto.mardegan@canonical.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+#include "signonloggingadaptor.h"
+#include "accesscontrolmanagerhelper.h"
+#include "signond-common.h"
+
+namespace SignonDaemonNS {
+
+SignonLoggingAdaptor::SignonLoggingAdaptor(SignonDaemon *parent):
+    QDBusAbstractAdaptor(parent),
+    m_parent(parent)
+{
+    setAutoRelaySignals(false);
+}
+
+SignonLoggingAdaptor::~SignonLoggingAdaptor()
+{
+}
+
+bool SignonLoggingAdaptor::checkAccess()
+{
+    QDBusMessage msg = parentDBusContext().message();
+    QDBusConnection conn = parentDBusContext().connection();
+
+    AccessControlManagerHelper *acm = AccessControlManagerHelper::instance();
+    if (acm != 0 && acm->isPeerKeychainWidget(conn, msg))
+        return true;
+
+    QString errMsg;
+    QTextStream(&errMsg) << SIGNOND_PERMISSION_DENIED_ERR_STR
+                         << "Method:"
+                         << msg.member();
+
+    msg.setDelayedReply(true);
+    conn.send(msg.createErrorReply(SIGNOND_PERMISSION_DENIED_ERR_NAME,
+                                   errMsg));
+    TRACE() << "Method FAILED Access Control check:" << msg.member();
+    return false;
+}
+
+int SignonLoggingAdaptor::loggingLevel()
+{
+    return SignOn::loggingLevel();
+}
+
+void SignonLoggingAdaptor::setLoggingLevel(int level)
+{
+    if (!checkAccess()) return;
+
+    SignOn::setLoggingLevel(level);
+    TRACE() << "Logging level set to" << level;
+}
+
+QStringList SignonLoggingAdaptor::loggingCategories()
+{
+    return SignOn::loggingCategoryNames(SignOn::loggingCategories());
+}
+
+void SignonLoggingAdaptor::setLoggingCategories(const QStringList &categories)
+{
+    if (!checkAccess()) return;
+
+    SignOn::setLoggingCategories(
+        SignOn::loggingCategoriesFromNames(categories));
+    TRACE() << "Logging categories set to" << loggingCategories();
+}
+
+} //namespace SignonDaemonNS
@@ -0,0 +1,73 @@
+/*
+ * This file is part of signon
+ *
+ * Copyright (C) 2013 Canonical Ltd.
+ *
+ * Contact: Alberto Mardegan <alberto.mardegan@canonical.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+
+#ifndef SIGNONLOGGINGADAPTOR_H_
+#define SIGNONLOGGINGADAPTOR_H_
+
+#include <QtCore>
+#include <QtDBus>
+
+#include "signondaemon.h"
+
+namespace SignonDaemonNS {
+
+/*!
+ * @class SignonLoggingAdaptor
+ * Lets the logging level and categories of the daemon be changed at runtime.
+ * Plugin processes which are already running keep their logging level.
+ * Only the keychain widget can change them, since the debug messages can
+ * contain private data.
+ */
+class SignonLoggingAdaptor: public QDBusAbstractAdaptor
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface",
+                "com.google.code.AccountsSSO.SingleSignOn.Logging")
+
+public:
+    SignonLoggingAdaptor(SignonDaemon *parent);
+    virtual ~SignonLoggingAdaptor();
+
+    inline const QDBusContext &parentDBusContext() const
+        { return *static_cast<QDBusContext *>(m_parent); }
+
+public Q_SLOTS:
+    int loggingLevel();
+    void setLoggingLevel(int level);
+
+    /*!
+     * @returns the names of the categories whose debug messages are enabled.
+     */
+    QStringList loggingCategories();
+    void setLoggingCategories(const QStringList &categories);
+
+private:
+    bool checkAccess();
+
+private:
+    SignonDaemon *m_parent;
+};
+
+} //namespace SignonDaemonNS
+
+#endif /* SIGNONLOGGINGADAPTOR_H_ */
@@ -0,0 +1,199 @@
+/*
+ * This file is part of signon
+ *
+ * Copyright (C) 2013 Canonical Ltd.
+ *
+ * Contact: Alberto Mardegan <alberto.mardegan@canonical.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+#include "signonmetrics.h"
+
+#include <QVariantList>
+#include <climits>
+
+namespace SignonDaemonNS {
+
+/* Upper bounds of the histogram buckets, in microseconds */
+static const int bucketBounds[] = {
+    100, 250, 500,
+    1000, 2500, 5000,
+    10000, 25000, 50000,
+    100000, 250000, 500000,
+    1000000, 2500000, 5000000,
+    10000000
+};
+static const int boundCount = sizeof(bucketBounds) / sizeof(bucketBounds[0]);
+
+Q_GLOBAL_STATIC(SignonMetrics, metricsInstance)
+
+/* QAtomicInt has no load() in Qt 4 */
+static inline int load(const QAtomicInt &value)
+{
+    return const_cast<QAtomicInt &>(value).fetchAndAddRelaxed(0);
+}
+
+MetricsHistogram::MetricsHistogram():
+    m_count(0),
+    m_max(0)
+{
+    Q_ASSERT(BucketCount == boundCount + 1);
+}
+
+int MetricsHistogram::bucketOf(qint64 usecs)
+{
+    int bucket = 0;
+    while (bucket < boundCount && usecs > bucketBounds[bucket])
+        bucket++;
+    return bucket;
+}
+
+void MetricsHistogram::add(qint64 usecs)
+{
+    int value = int(qBound(qint64(0), usecs, qint64(INT_MAX)));
+
+    m_count.fetchAndAddRelaxed(1);
+    m_buckets[bucketOf(value)].fetchAndAddRelaxed(1);
+
+    int max;
+    do {
+        max = load(m_max);
+        if (value <= max) break;
+    } while (!m_max.testAndSetRelaxed(max, value));
+}
+
+int MetricsHistogram::count() const
+{
+    return load(m_count);
+}
+
+int MetricsHistogram::bucketCount(int bucket) const
+{
+    return load(m_buckets[bucket]);
+}
+
+QVariantMap MetricsHistogram::toMap() const
+{
+    QVariantList bounds;
+    for (int i = 0; i < boundCount; i++)
+        bounds.append(bucketBounds[i]);
+
+    QVariantList buckets;
+    for (int i = 0; i < BucketCount; i++)
+        buckets.append(bucketCount(i));
+
+    QVariantMap map;
+    map.insert(QLatin1String("Count"), count());
+    map.insert(QLatin1String("Max"), load(m_max));
+    map.insert(QLatin1String("Bounds"), bounds);
+    map.insert(QLatin1String("Buckets"), buckets);
+    return map;
+}
+
+SignonMetrics *SignonMetrics::instance()
+{
+    return metricsInstance();
+}
+
+SignonMetrics::SignonMetrics():
+    m_pluginStartFailures(0),
+    m_statementFailures(0),
+    m_credentialsLoads(0)
+{
+}
+
+SignonMetrics::~SignonMetrics()
+{
+    qDeleteAll(m_processLatency);
+}
+
+void SignonMetrics::processCompleted(const QString &method, qint64 usecs)
+{
+    MetricsHistogram *&histogram = m_processLatency[method];
+    if (histogram == 0)
+        histogram = new MetricsHistogram;
+    histogram->add(usecs);
+}
+
+void SignonMetrics::pluginStarted(qint64 usecs)
+{
+    m_pluginStartLatency.add(usecs);
+}
+
+void SignonMetrics::pluginStartFailed()
+{
+    m_pluginStartFailures.fetchAndAddRelaxed(1);
+}
+
+void SignonMetrics::statementExecuted(qint64 usecs, bool ok)
+{
+    m_statementLatency.add(usecs);
+    if (!ok)
+        m_statementFailures.fetchAndAddRelaxed(1);
+}
+
+void SignonMetrics::aclChecked(AclCheck check)
+{
+    m_aclChecks[check].fetchAndAddRelaxed(1);
+}
+
+void SignonMetrics::credentialsLoaded()
+{
+    m_credentialsLoads.fetchAndAddRelaxed(1);
+}
+
+QVariantMap SignonMetrics::toMap() const
+{
+    QVariantMap process;
+    QHash<QString, MetricsHistogram *>::const_iterator i;
+    for (i = m_processLatency.constBegin();
+         i != m_processLatency.constEnd();
+         i++) {
+        process.insert(i.key(), i.value()->toMap());
+    }
+
+    QVariantMap plugins;
+    plugins.insert(QLatin1String("Spawns"), m_pluginStartLatency.count());
+    plugins.insert(QLatin1String("SpawnFailures"),
+                   load(m_pluginStartFailures));
+    plugins.insert(QLatin1String("SpawnLatency"),
+                   m_pluginStartLatency.toMap());
+
+    QVariantMap statements;
+    statements.insert(QLatin1String("Count"), m_statementLatency.count());
+    statements.insert(QLatin1String("Failures"), load(m_statementFailures));
+    statements.insert(QLatin1String("Latency"), m_statementLatency.toMap());
+
+    QVariantMap acl;
+    acl.insert(QLatin1String("IdentityAccess"),
+               load(m_aclChecks[IdentityAccessCheck]));
+    acl.insert(QLatin1String("Ownership"),
+               load(m_aclChecks[OwnershipCheck]));
+    acl.insert(QLatin1String("KeychainWidget"),
+               load(m_aclChecks[KeychainWidgetCheck]));
+    acl.insert(QLatin1String("SecurityContext"),
+               load(m_aclChecks[SecurityContextCheck]));
+
+    QVariantMap map;
+    map.insert(QLatin1String("ProcessLatency"), process);
+    map.insert(QLatin1String("Plugins"), plugins);
+    map.insert(QLatin1String("DBStatements"), statements);
+    map.insert(QLatin1String("AclChecks"), acl);
+    map.insert(QLatin1String("CredentialsLoads"), load(m_credentialsLoads));
+    return map;
+}
+
+} //namespace SignonDaemonNS
@@ -0,0 +1,116 @@
+/*
+ * This file is part of signon
+ *
+ * Copyright (C) 2013 Canonical Ltd.
+ *
+ * Contact: Alberto Mardegan <alberto.mardegan@canonical.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+/*!
+ * @file signonmetrics.h
+ * Definition of the SignonMetrics object.
+ * @ingroup Accounts_and_SSO_Framework
+ */
+
+#ifndef SIGNONMETRICS_H_
+#define SIGNONMETRICS_H_
+
+#include <QAtomicInt>
+#include <QHash>
+#include <QString>
+#include <QVariantMap>
+
+namespace SignonDaemonNS {
+
+/*!
+ * @class MetricsHistogram
+ * Distribution of durations, in microseconds. Values can be added from any
+ * thread without locking.
+ */
+class MetricsHistogram
+{
+public:
+    MetricsHistogram();
+
+    void add(qint64 usecs);
+
+    int count() const;
+    int bucketCount(int bucket) const;
+
+    /*!
+     * @returns a map with the "Count", the "Max" value, the upper "Bounds"
+     * of the buckets and the count of values in each of the "Buckets"; the
+     * last bucket holds the values above the last bound.
+     */
+    QVariantMap toMap() const;
+
+    static int bucketOf(qint64 usecs);
+
+private:
+    enum { BucketCount = 17 };
+    QAtomicInt m_count;
+    QAtomicInt m_max;
+    QAtomicInt m_buckets[BucketCount];
+};
+
+/*!
+ * @class SignonMetrics
+ * Counters of the daemon activity, exposed on D-Bus by the
+ * SignonMetricsAdaptor.
+ * All the counters use atomic operations, so that they can be updated from
+ * any thread; the per-method process() histograms are created on first use,
+ * and must be updated from the main thread only.
+ */
+class SignonMetrics
+{
+public:
+    enum AclCheck {
+        IdentityAccessCheck = 0,
+        OwnershipCheck,
+        KeychainWidgetCheck,
+        SecurityContextCheck,
+        AclCheckCount
+    };
+
+    static SignonMetrics *instance();
+
+    SignonMetrics();
+    ~SignonMetrics();
+
+    void processCompleted(const QString &method, qint64 usecs);
+    void pluginStarted(qint64 usecs);
+    void pluginStartFailed();
+    void statementExecuted(qint64 usecs, bool ok);
+    void aclChecked(AclCheck check);
+    /* the stored credentials of an identity were read for a session */
+    void credentialsLoaded();
+
+    QVariantMap toMap() const;
+
+private:
+    QHash<QString, MetricsHistogram *> m_processLatency;
+    MetricsHistogram m_pluginStartLatency;
+    QAtomicInt m_pluginStartFailures;
+    MetricsHistogram m_statementLatency;
+    QAtomicInt m_statementFailures;
+    QAtomicInt m_aclChecks[AclCheckCount];
+    QAtomicInt m_credentialsLoads;
+};
+
+} //namespace SignonDaemonNS
+
+#endif /* SIGNONMETRICS_H_ */
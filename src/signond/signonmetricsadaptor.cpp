@@ -0,0 +1,108 @@
+/*
+ * This file is part of signon
+ *
+ * Copyright (C) 2013 Canonical Ltd.
+ *
+ * Contact: Alberto Mardegan <alberto.mardegan@canonical.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+#include "signonmetricsadaptor.h"
+#include "accesscontrolmanagerhelper.h"
+#include "requesttracer.h"
+#include "signondisposable.h"
+#include "signonmetrics.h"
+#include "signonsessioncore.h"
+
+namespace SignonDaemonNS {
+
+SignonMetricsAdaptor::SignonMetricsAdaptor(SignonDaemon *parent):
+    QDBusAbstractAdaptor(parent),
+    m_parent(parent)
+{
+    setAutoRelaySignals(false);
+}
+
+SignonMetricsAdaptor::~SignonMetricsAdaptor()
+{
+}
+
+bool SignonMetricsAdaptor::checkAccess()
+{
+    QDBusMessage msg = parentDBusContext().message();
+    QDBusConnection conn = parentDBusContext().connection();
+
+    AccessControlManagerHelper *acm = AccessControlManagerHelper::instance();
+    if (acm != 0 && acm->isPeerKeychainWidget(conn, msg))
+        return true;
+
+    QString errMsg;
+    QTextStream(&errMsg) << SIGNOND_PERMISSION_DENIED_ERR_STR
+                         << "Method:"
+                         << msg.member();
+
+    msg.setDelayedReply(true);
+    conn.send(msg.createErrorReply(SIGNOND_PERMISSION_DENIED_ERR_NAME,
+                                   errMsg));
+    TRACE() << "Method FAILED Access Control check:" << msg.member();
+    return false;
+}
+
+QVariantMap SignonMetricsAdaptor::metrics()
+{
+    if (!checkAccess()) return QVariantMap();
+
+    QVariantMap map = SignonMetrics::instance()->toMap();
+
+    map.insert(QLatin1String("Sessions"),
+               SignonSessionCore::queueStatistics());
+    map.insert(QLatin1String("DisposableObjects"),
+               SignonDisposable::objectCounts());
+
+    AccessControlManagerHelper *acm = AccessControlManagerHelper::instance();
+    if (acm != 0) {
+        QVariantMap aclCache;
+        aclCache.insert(QLatin1String("Hits"), acm->cacheHits());
+        aclCache.insert(QLatin1String("Misses"), acm->cacheMisses());
+        map.insert(QLatin1String("AclCache"), aclCache);
+    }
+
+    /* Don't open the storage just for this, in lazy mode */
+    CredentialsAccessManager *cam = CredentialsAccessManager::instance();
+    CredentialsDB *db = (cam != 0) ? cam->credentialsDB() : 0;
+    if (db != 0) {
+        map.insert(QLatin1String("SecretsCache"),
+                   db->secretsCacheStatistics());
+    }
+
+    return map;
+}
+
+QVariantList SignonMetricsAdaptor::requestTraces()
+{
+    if (!checkAccess()) return QVariantList();
+
+    return RequestTracer::instance()->records();
+}
+
+QString SignonMetricsAdaptor::chromeTrace()
+{
+    if (!checkAccess()) return QString();
+
+    return QString::fromUtf8(RequestTracer::instance()->toChromeTrace());
+}
+
+} //namespace SignonDaemonNS
@@ -0,0 +1,80 @@
+/*
+ * This file is part of signon
+ *
+ * Copyright (C) 2013 Canonical Ltd.
+ *
+ * Contact: Alberto Mardegan <alberto.mardegan@canonical.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+#ifndef SIGNONMETRICSADAPTOR_H_
+#define SIGNONMETRICSADAPTOR_H_
+
+#include <QtCore>
+#include <QtDBus>
+
+#include "signondaemon.h"
+
+namespace SignonDaemonNS {
+
+/*!
+ * @class SignonMetricsAdaptor
+ * Exposes the daemon metrics on the daemon object. Since the metrics
+ * reveal the identities being used, only the keychain widget can read them.
+ */
+class SignonMetricsAdaptor: public QDBusAbstractAdaptor
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface",
+                "com.google.code.AccountsSSO.SingleSignOn.Metrics")
+
+public:
+    SignonMetricsAdaptor(SignonDaemon *parent);
+    virtual ~SignonMetricsAdaptor();
+
+    inline const QDBusContext &parentDBusContext() const
+        { return *static_cast<QDBusContext *>(m_parent); }
+
+public Q_SLOTS:
+    /*!
+     * @returns the counters and histograms of SignonMetrics, together with
+     * the current "Sessions" queues, the live "DisposableObjects" and the
+     * statistics of the "AclCache" and of the "SecretsCache".
+     */
+    QVariantMap metrics();
+
+    /*!
+     * @returns the trace records of the most recent requests; see
+     * RequestTracer::records().
+     */
+    QVariantList requestTraces();
+
+    /*!
+     * @returns the trace records of the most recent requests, as a Chrome
+     * trace-event JSON document.
+     */
+    QString chromeTrace();
+
+private:
+    bool checkAccess();
+
+private:
+    SignonDaemon *m_parent;
+};
+
+} //namespace SignonDaemonNS
+
+#endif /* SIGNONMETRICSADAPTOR_H_ */
@@ -28,11 +28,16 @@
 #include "signonidentity.h"
 #include "signonui_interface.h"
 #include "accesscontrolmanagerhelper.h"
+#include "signonmetrics.h"
+#include "requesttracer.h"
 
 #include "SignOn/uisessiondata_priv.h"
 #include "SignOn/authpluginif.h"
 #include "SignOn/signonerror.h"
 
+#undef SIGNON_TRACE_CATEGORY
+#define SIGNON_TRACE_CATEGORY SignOn::SessionCategory
+
 #define MAX_IDLE_TIME SIGNOND_MAX_IDLE_TIME
 /*
  * the watchdog searches for idle sessions with period of half of idle timeout
@@ -58,9 +63,11 @@ static QVariantMap filterVariantMap(const QVariantMap &other)
 {
     QVariantMap result;
 
-    foreach(QString key, other.keys()) {
-        if (!other.value(key).isNull() && other.value(key).isValid())
-            result.insert(key, other.value(key));
+    QVariantMap::const_iterator it;
+    for (it = other.constBegin(); it != other.constEnd(); it++) {
+        const QVariant &value = it.value();
+        if (!value.isNull() && value.isValid())
+            result.insert(it.key(), value);
     }
 
     return result;
@@ -82,8 +89,13 @@ SignonSessionCore::SignonSessionCore(quint32 id,
     m_canceled(false),
     m_id(id),
     m_method(method),
+    m_isStoring(false),
     m_queryCredsUiDisplayed(false)
 {
+    m_snapshot.isValid = false;
+    m_snapshot.secretsDBOpen = false;
+    m_snapshot.isStale = false;
+
     m_signonui = new SignonUiAdaptor(SIGNON_UI_SERVICE,
                                      SIGNON_UI_DAEMON_OBJECTPATH,
                                      QDBusConnection::sessionBus());
@@ -99,6 +111,7 @@ SignonSessionCore::~SignonSessionCore()
     delete m_plugin;
     delete m_watcher;
     delete m_signonui;
+    discardSecretsReplies();
 
     m_plugin = NULL;
     m_signonui = NULL;
@@ -120,6 +133,8 @@ SignonSessionCore *SignonSessionCore::sessionCore(const quint32 id,
     SignonSessionCore *ssc = new SignonSessionCore(id, method,
                                                    parent->authSessionTimeout(),
                                                    parent);
+    ssc->m_listOfRequests.setLimits(parent->maxQueuedRequests(),
+                                    parent->maxQueuedRequestsPerPeer());
 
     if (ssc->setupPlugin() == false) {
         TRACE() << "The resulted object is corrupted and has to be deleted";
@@ -195,6 +210,12 @@ bool SignonSessionCore::setupPlugin()
             SLOT(stateChangedSlot(int, const QString&)),
             Qt::DirectConnection);
 
+    connect(m_plugin,
+            SIGNAL(processTimed(qint64, qint64)),
+            this,
+            SLOT(processTimed(qint64, qint64)),
+            Qt::DirectConnection);
+
     return true;
 }
 
@@ -222,6 +243,27 @@ QStringList SignonSessionCore::loadedPluginMethods(const QString &method)
     return QStringList();
 }
 
+QVariantList SignonSessionCore::queueStatistics()
+{
+    QList<SignonSessionCore *> cores = sessionsOfStoredCredentials.values();
+    cores += sessionsOfNonStoredCredentials;
+
+    QVariantList list;
+    foreach (SignonSessionCore *core, cores) {
+        const RequestQueue &queue = core->m_listOfRequests;
+        QVariantMap map;
+        /* Not id() and method(): they would keep the core in use */
+        map.insert(QLatin1String("Id"), core->m_id);
+        map.insert(QLatin1String("Method"), core->m_method);
+        map.insert(QLatin1String("QueueSize"), queue.size());
+        map.insert(QLatin1String("Served"), queue.servedCount());
+        map.insert(QLatin1String("TotalWaitTime"), queue.totalWaitTime());
+        map.insert(QLatin1String("MaxWaitTime"), queue.maxWaitTime());
+        list.append(map);
+    }
+    return list;
+}
+
 QStringList
 SignonSessionCore::queryAvailableMechanisms(const QStringList &wantedMechanisms)
 {
@@ -241,11 +283,19 @@ void SignonSessionCore::process(const QDBusConnection &connection,
                                 const QString &cancelKey)
 {
     keepInUse();
-    m_listOfRequests.enqueue(RequestData(connection,
-                                         message,
-                                         sessionDataVa,
-                                         mechanism,
-                                         cancelKey));
+
+    RequestData request(connection, message, sessionDataVa,
+                        mechanism, cancelKey);
+    if (m_listOfRequests.isFull(request.m_peer)) {
+        BLAME() << "Too many pending requests from" << request.m_peer;
+        replyError(connection, message, Error::WrongState,
+                   QLatin1String("Too many pending requests"));
+        return;
+    }
+
+    m_listOfRequests.enqueue(request);
+    RequestTracer::instance()->begin(request.m_requestId, cancelKey,
+                                     m_method, mechanism);
 
     if (CredentialsAccessManager::instance()->isCredentialsSystemReady())
         QMetaObject::invokeMethod(this, "startNewRequest", Qt::QueuedConnection);
@@ -255,47 +305,49 @@ void SignonSessionCore::cancel(const QString &cancelKey)
 {
     TRACE();
 
-    int requestIndex;
-    for (requestIndex = 0;
-         requestIndex < m_listOfRequests.size();
-         requestIndex++) {
-        if (m_listOfRequests.at(requestIndex).m_cancelKey == cancelKey)
-            break;
-    }
-
-    TRACE() << "The request is found with index " << requestIndex;
-
-    if (requestIndex < m_listOfRequests.size()) {
-        /* If the request being cancelled is active, we need to keep
-         * in the queue until the plugin has replied. */
-        bool isActive = (requestIndex == 0) && m_requestIsActive;
-        if (isActive) {
-            m_canceled = true;
+    /* If the request being cancelled is active, we need to keep
+     * in the queue until the plugin has replied. A client with several
+     * requests in the queue sends one cancel for each of them: once the
+     * active one is canceled, the next ones apply to the queued requests. */
+    bool isActive = m_requestIsActive && !m_canceled &&
+        m_listOfRequests.isHead(cancelKey);
+    QScopedPointer<RequestData> canceledRequest;
+    if (isActive) {
+        m_canceled = true;
+        /* If the secrets are still being loaded, the plugin has not been
+         * called yet: onSecretsLoaded() will complete the request */
+        if (!isLoadingSecrets())
             m_plugin->cancel();
 
-            if (m_watcher && !m_watcher->isFinished()) {
-                m_signonui->cancelUiRequest(cancelKey);
-                delete m_watcher;
-                m_watcher = 0;
-            }
+        if (m_watcher && !m_watcher->isFinished()) {
+            m_signonui->cancelUiRequest(cancelKey);
+            delete m_watcher;
+            m_watcher = 0;
         }
-
-        /*
-         * We must let to the m_listOfRequests to have the canceled request data
-         * in order to delay the next request execution until the actual cancelation
-         * will happen. We will know about that precisely: plugin must reply via
-         * resultSlot or via errorSlot.
-         * */
-        RequestData rd(isActive ?
-                       m_listOfRequests.head() :
-                       m_listOfRequests.takeAt(requestIndex));
-
-        QDBusMessage errReply =
-            rd.m_msg.createErrorReply(SIGNOND_SESSION_CANCELED_ERR_NAME,
-                                      SIGNOND_SESSION_CANCELED_ERR_STR);
-        rd.m_conn.send(errReply);
-        TRACE() << "Size of the queue is" << m_listOfRequests.size();
+    } else {
+        canceledRequest.reset(m_listOfRequests.take(cancelKey));
+        if (canceledRequest.isNull()) {
+            TRACE() << "The request is not in the queue";
+            return;
+        }
+        RequestTracer::instance()->end(canceledRequest->m_requestId,
+                                       QLatin1String("canceled"));
     }
+
+    /*
+     * We must let to the m_listOfRequests to have the canceled request data
+     * in order to delay the next request execution until the actual cancelation
+     * will happen. We will know about that precisely: plugin must reply via
+     * resultSlot or via errorSlot.
+     * */
+    const RequestData &rd = isActive ?
+        m_listOfRequests.head() : *canceledRequest;
+
+    QDBusMessage errReply =
+        rd.m_msg.createErrorReply(SIGNOND_SESSION_CANCELED_ERR_NAME,
+                                  SIGNOND_SESSION_CANCELED_ERR_STR);
+    rd.m_conn.send(errReply);
+    TRACE() << "Size of the queue is" << m_listOfRequests.size();
 }
 
 void SignonSessionCore::setId(quint32 id)
@@ -322,27 +374,192 @@ void SignonSessionCore::setId(quint32 id)
         sessionsOfStoredCredentials[key] = this;
     }
     m_id = id;
+    m_snapshot.isValid = false;
+}
+
+bool SignonSessionCore::isSnapshotValid(CredentialsDB *db)
+{
+    /* The DB object is recreated when the credentials system is reopened
+     * (for instance, after a restore) */
+    if (m_snapshot.db != db) {
+        m_snapshot.db = db;
+        m_snapshot.isValid = false;
+        connect(db, SIGNAL(credentialsUpdated(quint32)),
+                SLOT(onCredentialsChanged(quint32)));
+        connect(db, SIGNAL(dataChanged(quint32)),
+                SLOT(onCredentialsChanged(quint32)));
+    }
+
+    /* The stored password and data are read from the secrets cache while the
+     * secrets DB is closed: reload them when that changes */
+    return m_snapshot.isValid &&
+        m_snapshot.secretsDBOpen == db->isSecretsDBOpen();
+}
+
+const SignonSessionCore::CredentialsSnapshot &
+SignonSessionCore::credentialsSnapshot(CredentialsDB *db)
+{
+    if (isSnapshotValid(db))
+        return m_snapshot;
+
+    TRACE() << "Loading credentials of" << m_id;
+    SignonMetrics::instance()->credentialsLoaded();
+    m_snapshot.info = db->credentials(m_id);
+    m_snapshot.storedData = db->loadData(m_id, m_method);
+    m_snapshot.secretsDBOpen = db->isSecretsDBOpen();
+    /* Don't keep a failed read */
+    m_snapshot.isValid = (m_snapshot.info.id() != SIGNOND_NEW_IDENTITY);
+    return m_snapshot;
+}
+
+void SignonSessionCore::loadCredentialsSnapshot(CredentialsDB *db)
+{
+    TRACE() << "Loading credentials of" << m_id << "asynchronously";
+    SignonMetrics::instance()->credentialsLoaded();
+    m_snapshot.info = db->credentials(m_id, false);
+    m_snapshot.storedData.clear();
+    m_snapshot.secretsDBOpen = db->isSecretsDBOpen();
+    m_snapshot.isStale = false;
+
+    /* The replies are owned by the DB or by the secrets storage, which
+     * can be destroyed while loading (for instance, by a restore) */
+    m_credentialsReply = db->loadCredentialsAsync(m_snapshot.info);
+    connect(m_credentialsReply, SIGNAL(finished()),
+            SLOT(onSecretsLoaded()));
+    connect(m_credentialsReply, SIGNAL(destroyed()),
+            SLOT(onSecretsReplyDestroyed()));
+    m_dataReply = db->loadDataAsync(m_id, m_method);
+    connect(m_dataReply, SIGNAL(finished()),
+            SLOT(onSecretsLoaded()));
+    connect(m_dataReply, SIGNAL(destroyed()),
+            SLOT(onSecretsReplyDestroyed()));
+}
+
+SignonIdentityInfo SignonSessionCore::storedInfo(CredentialsDB *db)
+{
+    if (isSnapshotValid(db))
+        return m_snapshot.info;
+
+    /* Reading the secrets might block on the secrets storage */
+    return db->credentials(m_id, false);
+}
+
+bool SignonSessionCore::isLoadingSecrets() const
+{
+    return m_credentialsReply != 0 || m_dataReply != 0;
+}
+
+void SignonSessionCore::discardSecretsReplies()
+{
+    if (m_credentialsReply != 0) {
+        m_credentialsReply->disconnect(this);
+        m_credentialsReply->deleteLater();
+        m_credentialsReply = 0;
+    }
+    if (m_dataReply != 0) {
+        m_dataReply->disconnect(this);
+        m_dataReply->deleteLater();
+        m_dataReply = 0;
+    }
+}
+
+void SignonSessionCore::onSecretsReplyDestroyed()
+{
+    /* The QPointer of the destroyed reply is already null */
+    BLAME() << "Credentials storage closed while loading the secrets of" <<
+        m_id;
+    discardSecretsReplies();
+    m_snapshot.isValid = false;
+
+    if (!m_canceled && !m_listOfRequests.isEmpty()) {
+        const RequestData &rd = m_listOfRequests.head();
+        replyError(rd.m_conn, rd.m_msg, Error::Runtime,
+                   QLatin1String("The credentials storage was closed"));
+    }
+    requestDone(QLatin1String("error"));
+}
+
+void SignonSessionCore::onSecretsLoaded()
+{
+    if ((m_credentialsReply != 0 && !m_credentialsReply->isFinished()) ||
+        (m_dataReply != 0 && !m_dataReply->isFinished()))
+        return;
+
+    SignonIdentityInfo &info = m_snapshot.info;
+    if (m_credentialsReply != 0) {
+        if (info.isUserNameSecret())
+            info.setUserName(m_credentialsReply->username());
+        info.setPassword(m_credentialsReply->password());
+    }
+    if (m_dataReply != 0)
+        m_snapshot.storedData = m_dataReply->data();
+    discardSecretsReplies();
+    /* Don't keep a failed or outdated read */
+    m_snapshot.isValid = !m_snapshot.isStale &&
+        info.id() != SIGNOND_NEW_IDENTITY;
+
+    if (m_canceled) {
+        /* The client has already been replied to, in cancel() */
+        requestDone(QLatin1String("canceled"));
+        return;
+    }
+
+    callPlugin();
+}
+
+void SignonSessionCore::onCredentialsChanged(quint32 id)
+{
+    if (id != m_id && id != 0) return;
+    if (m_isStoring && id == m_id) return;
+
+    m_snapshot.isValid = false;
+    if (isLoadingSecrets())
+        m_snapshot.isStale = true;
 }
 
 void SignonSessionCore::startProcess()
 {
 
-    TRACE() << "the number of requests is" << m_listOfRequests.length();
+    TRACE() << "the number of requests is" << m_listOfRequests.size();
 
+    /* Only now: a request queued while the active one is being canceled
+     * must not clear the flag before the plugin has replied */
+    m_canceled = false;
     m_requestIsActive = true;
-    RequestData data = m_listOfRequests.head();
-    QVariantMap parameters = data.m_params;
+    const RequestData &data = m_listOfRequests.head();
+
+    RequestTracer::instance()->mark(data.m_requestId,
+                                    QLatin1String("started"));
 
     /* save the client data; this should not be modified during the processing
      * of this request */
-    m_clientData = parameters;
+    m_clientData = data.m_params;
 
     if (m_id) {
         CredentialsDB *db =
             CredentialsAccessManager::instance()->credentialsDB();
         Q_ASSERT(db != 0);
 
-        SignonIdentityInfo info = db->credentials(m_id);
+        /* Slow secrets storages would block all the other sessions */
+        if (!isSnapshotValid(db)) {
+            loadCredentialsSnapshot(db);
+            return;
+        }
+    }
+
+    callPlugin();
+}
+
+void SignonSessionCore::callPlugin()
+{
+    RequestData data = m_listOfRequests.head();
+    QVariantMap parameters = m_clientData;
+
+    RequestTracer *tracer = RequestTracer::instance();
+
+    if (m_id) {
+        const CredentialsSnapshot &snapshot = m_snapshot;
+        const SignonIdentityInfo &info = snapshot.info;
         if (info.id() != SIGNOND_NEW_IDENTITY) {
             if (!parameters.contains(SSO_KEY_PASSWORD)) {
                 parameters[SSO_KEY_PASSWORD] = info.password();
@@ -354,9 +571,7 @@ void SignonSessionCore::startProcess()
             }
 
             QStringList paramsTokenList;
-            QStringList identityAclList = info.accessControlList();
-
-            foreach(QString acl, identityAclList) {
+            foreach(const QString &acl, info.accessControlList()) {
                 if (AccessControlManagerHelper::instance()->
                     isPeerAllowedToAccess(data.m_conn, data.m_msg, acl))
                     paramsTokenList.append(acl);
@@ -370,10 +585,9 @@ void SignonSessionCore::startProcess()
                 "database.";
         }
 
-        QVariantMap storedParams = db->loadData(m_id, m_method);
-
         //parameters will overwrite any common keys on stored params
-        parameters = mergeVariantMaps(storedParams, parameters);
+        parameters = mergeVariantMaps(snapshot.storedData, parameters);
+        tracer->mark(data.m_requestId, QLatin1String("credentials-loaded"));
     }
 
     if (parameters.contains(SSOUI_KEY_UIPOLICY)
@@ -391,10 +605,12 @@ void SignonSessionCore::startProcess()
             data.m_msg.createErrorReply(SIGNOND_RUNTIME_ERR_NAME,
                                         SIGNOND_RUNTIME_ERR_STR);
         data.m_conn.send(errReply);
-        requestDone();
-    } else
+        requestDone(QLatin1String("error"));
+    } else {
+        tracer->mark(data.m_requestId, QLatin1String("plugin-called"));
         stateChangedSlot(SignOn::SessionStarted,
                          QLatin1String("The request is started successfully"));
+    }
 }
 
 void SignonSessionCore::replyError(const QDBusConnection &conn,
@@ -517,23 +733,46 @@ void SignonSessionCore::processStoreOperation(const StoreOperation &operation)
     CredentialsDB *db = CredentialsAccessManager::instance()->credentialsDB();
     Q_ASSERT(db != 0);
 
+    /* The snapshot is updated with what we write, instead of being reloaded
+     * for the next request */
+    bool snapshotIsValid = isSnapshotValid(db);
+    bool ok;
+    m_isStoring = true;
     if (operation.m_storeType != StoreOperation::Blob) {
-        if (!(db->updateCredentials(operation.m_info))) {
+        ok = db->updateCredentials(operation.m_info) != 0;
+        if (!ok) {
             BLAME() << "Error occured while updating credentials.";
+        } else if (snapshotIsValid) {
+            m_snapshot.info = operation.m_info;
         }
     } else {
         TRACE() << "Processing --- StoreOperation::Blob";
 
-        if (!db->storeData(m_id,
+        ok = db->storeData(m_id,
                            operation.m_authMethod,
-                           operation.m_blobData)) {
+                           operation.m_blobData);
+        if (!ok) {
             BLAME() << "Error occured while storing data.";
+        } else if (snapshotIsValid && operation.m_authMethod == m_method) {
+            m_snapshot.storedData = operation.m_blobData;
         }
     }
+    m_isStoring = false;
+
+    if (!ok)
+        m_snapshot.isValid = false;
 }
 
-void SignonSessionCore::requestDone()
+void SignonSessionCore::requestDone(const QString &status)
 {
+    if (!m_listOfRequests.isEmpty()) {
+        const RequestData &rd = m_listOfRequests.head();
+        qint64 latency = rd.m_queuedTime.nsecsElapsed() / 1000;
+        SignonMetrics::instance()->processCompleted(m_method, latency);
+        RequestTracer::instance()->end(rd.m_requestId,
+                                       m_canceled ?
+                                       QLatin1String("canceled") : status);
+    }
     m_listOfRequests.removeFirst();
     m_requestIsActive = false;
     QMetaObject::invokeMethod(this, "startNewRequest", Qt::QueuedConnection);
@@ -549,6 +788,8 @@ void SignonSessionCore::processResultReply(const QVariantMap &data)
         return;
 
     RequestData rd = m_listOfRequests.head();
+    RequestTracer *tracer = RequestTracer::instance();
+    tracer->mark(rd.m_requestId, QLatin1String("result-received"));
 
     if (!m_canceled) {
         QVariantList arguments;
@@ -561,22 +802,29 @@ void SignonSessionCore::processResultReply(const QVariantMap &data)
 
         //update database entry
         if (m_id != SIGNOND_NEW_IDENTITY) {
-            SignonIdentityInfo info = db->credentials(m_id);
+            SignonIdentityInfo info = credentialsSnapshot(db).info;
             bool identityWasValidated = info.validated();
+            bool changed = !identityWasValidated;
 
             /* update username and password from ui interaction; do not allow
              * updating the username if the identity is validated */
             if (!info.validated() && !m_tmpUsername.isEmpty()) {
                 info.setUserName(m_tmpUsername);
             }
-            if (!m_tmpPassword.isEmpty()) {
+            if (!m_tmpPassword.isEmpty() && m_tmpPassword != info.password()) {
                 info.setPassword(m_tmpPassword);
+                changed = true;
             }
             info.setValidated(true);
 
-            StoreOperation storeOp(StoreOperation::Credentials);
-            storeOp.m_info = info;
-            processStoreOperation(storeOp);
+            /* Most requests just use the stored credentials: nothing to
+             * write then */
+            if (changed) {
+                StoreOperation storeOp(StoreOperation::Credentials);
+                storeOp.m_info = info;
+                processStoreOperation(storeOp);
+                tracer->mark(rd.m_requestId, QLatin1String("stored"));
+            }
 
             /* If the credentials are validated, the secrets db is not
              * available and not authorized keys are available, then
@@ -621,7 +869,7 @@ void SignonSessionCore::processResultReply(const QVariantMap &data)
         m_queryCredsUiDisplayed = false;
     }
 
-    requestDone();
+    requestDone(QLatin1String("done"));
 }
 
 void SignonSessionCore::processStore(const QVariantMap &data)
@@ -647,10 +895,14 @@ void SignonSessionCore::processStore(const QVariantMap &data)
     storeOp.m_blobData = filteredData;
     storeOp.m_authMethod = m_method;
     processStoreOperation(storeOp);
+    if (!m_listOfRequests.isEmpty()) {
+        RequestTracer::instance()->mark(m_listOfRequests.head().m_requestId,
+                                        QLatin1String("data-stored"));
+    }
 
     /* If the credentials are validated, the secrets db is not available and
      * not authorized keys are available inform the CAM about the situation. */
-    SignonIdentityInfo info = db->credentials(m_id);
+    SignonIdentityInfo info = storedInfo(db);
     if (info.validated() && !db->isSecretsDBOpen()) {
         /* Send the storage not available event only if the curent store
          * processing is following a previous signon UI query. This is to avoid
@@ -722,7 +974,7 @@ void SignonSessionCore::processUiRequest(const QVariantMap &data)
         if (!data.contains(SSO_KEY_CAPTION)) {
             TRACE() << "Caption missing";
             if (m_id != SIGNOND_NEW_IDENTITY) {
-                SignonIdentityInfo info = db->credentials(m_id);
+                SignonIdentityInfo info = storedInfo(db);
                 request.m_params.insert(SSO_KEY_CAPTION, info.caption());
                 TRACE() << "Got caption: " << info.caption();
             }
@@ -742,6 +994,8 @@ void SignonSessionCore::processUiRequest(const QVariantMap &data)
             }
         }
 
+        RequestTracer::instance()->mark(request.m_requestId,
+                                        QLatin1String("ui-queried"));
         m_watcher = new QDBusPendingCallWatcher(
                      m_signonui->queryDialog(request.m_params),
                      this);
@@ -768,6 +1022,8 @@ void SignonSessionCore::processRefreshRequest(const QVariantMap &data)
         }
 
         m_listOfRequests.head().m_params = filterVariantMap(data);
+        RequestTracer::instance()->mark(m_listOfRequests.head().m_requestId,
+                                        QLatin1String("ui-refreshed"));
         m_watcher = new QDBusPendingCallWatcher(
                      m_signonui->refreshDialog(m_listOfRequests.head().m_params),
                      this);
@@ -787,6 +1043,8 @@ void SignonSessionCore::processError(int err, const QString &message)
         return;
 
     RequestData rd = m_listOfRequests.head();
+    RequestTracer::instance()->mark(rd.m_requestId,
+                                    QLatin1String("error-received"));
 
     if (!m_canceled) {
         replyError(rd.m_conn, rd.m_msg, err, message);
@@ -798,7 +1056,7 @@ void SignonSessionCore::processError(int err, const QString &message)
         }
     }
 
-    requestDone();
+    requestDone(QLatin1String("error"));
 }
 
 void SignonSessionCore::stateChangedSlot(int state, const QString &message)
@@ -811,6 +1069,17 @@ void SignonSessionCore::stateChangedSlot(int state, const QString &message)
     keepInUse();
 }
 
+void SignonSessionCore::processTimed(qint64 receivedTime, qint64 repliedTime)
+{
+    if (m_listOfRequests.isEmpty())
+        return;
+
+    quint64 requestId = m_listOfRequests.head().m_requestId;
+    RequestTracer *tracer = RequestTracer::instance();
+    tracer->mark(requestId, QLatin1String("plugin-received"), receivedTime);
+    tracer->mark(requestId, QLatin1String("plugin-replied"), repliedTime);
+}
+
 void SignonSessionCore::childEvent(QChildEvent *ce)
 {
     if (ce->added())
@@ -847,6 +1116,8 @@ void SignonSessionCore::queryUiSlot(QDBusPendingCallWatcher *call)
                "queue of requests is empty");
 
     RequestData &rd = m_listOfRequests.head();
+    RequestTracer::instance()->mark(rd.m_requestId,
+                                    QLatin1String("ui-replied"));
     if (!reply.isError() && reply.count()) {
         QVariantMap resultParameters = reply.argumentAt<0>();
         if (resultParameters.contains(SSOUI_KEY_REFRESH)) {
@@ -896,8 +1167,6 @@ void SignonSessionCore::startNewRequest()
 {
     keepInUse();
 
-    m_canceled = false;
-
     if (m_listOfRequests.isEmpty()) {
         TRACE() << "No more requests to process";
         setAutoDestruct(true);
@@ -943,5 +1212,6 @@ void SignonSessionCore::destroy()
 
 void SignonSessionCore::credentialsSystemReady()
 {
+    m_snapshot.isValid = false;
     QMetaObject::invokeMethod(this, "startNewRequest", Qt::QueuedConnection);
 }
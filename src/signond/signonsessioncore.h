@@ -38,8 +38,13 @@ using namespace SignOn;
 
 class SignonUiAdaptor;
 
+namespace SignOn {
+class SecretsReply;
+}
+
 namespace SignonDaemonNS {
 
+class CredentialsDB;
 class SignonDaemon;
 
 /*!
@@ -65,6 +70,12 @@ public:
     static void stopAllAuthSessions();
     static QStringList loadedPluginMethods(const QString &method);
 
+    /*!
+     * @returns the queue size and wait time statistics of every session
+     * core, each as a map.
+     */
+    static QVariantList queueStatistics();
+
     void destroy();
 
 public Q_SLOTS:
@@ -102,8 +113,12 @@ private Q_SLOTS:
     void processError(int err, const QString &message);
     void stateChangedSlot(int state,
                           const QString &message);
+    void processTimed(qint64 receivedTime, qint64 repliedTime);
 
     void queryUiSlot(QDBusPendingCallWatcher *call);
+    void onCredentialsChanged(quint32 id);
+    void onSecretsLoaded();
+    void onSecretsReplyDestroyed();
 
 protected:
     SignonSessionCore(quint32 id,
@@ -115,17 +130,40 @@ protected:
     void customEvent(QEvent *event);
 
 private:
+    /* The stored credentials and session data of the identity, as read from
+     * the DB when the first queued request was started; it is reloaded only
+     * when the identity gets modified. */
+    struct CredentialsSnapshot {
+        QPointer<CredentialsDB> db;
+        bool isValid;
+        bool secretsDBOpen;
+        /* the identity was modified while its secrets were being loaded */
+        bool isStale;
+        SignonIdentityInfo info;
+        QVariantMap storedData;
+    };
+
+    bool isSnapshotValid(CredentialsDB *db);
+    const CredentialsSnapshot &credentialsSnapshot(CredentialsDB *db);
+    /* Like credentialsSnapshot(), but the secrets are loaded without
+     * blocking; startProcess() is resumed by onSecretsLoaded() */
+    void loadCredentialsSnapshot(CredentialsDB *db);
+    /* The stored info of the identity, without the secrets */
+    SignonIdentityInfo storedInfo(CredentialsDB *db);
+    bool isLoadingSecrets() const;
+    void discardSecretsReplies();
     void startProcess();
+    void callPlugin();
     void replyError(const QDBusConnection &conn,
                     const QDBusMessage &msg,
                     int err,
                     const QString &message);
     void processStoreOperation(const StoreOperation &operation);
-    void requestDone();
+    void requestDone(const QString &status);
 
 private:
     PluginProxy *m_plugin;
-    QQueue<RequestData> m_listOfRequests;
+    RequestQueue m_listOfRequests;
     SignonUiAdaptor *m_signonui;
 
     QDBusPendingCallWatcher *m_watcher;
@@ -138,6 +176,12 @@ private:
     /* the original request parameters, for the request currently being
      * processed */
     QVariantMap m_clientData;
+    CredentialsSnapshot m_snapshot;
+    /* set while this object writes to the DB, whose change notifications
+     * must not invalidate the snapshot: it is updated in place instead */
+    bool m_isStoring;
+    QPointer<SignOn::SecretsReply> m_credentialsReply;
+    QPointer<SignOn::SecretsReply> m_dataReply;
 
     //Temporary caching
     QString m_tmpUsername;
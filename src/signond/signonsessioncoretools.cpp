@@ -26,6 +26,12 @@
 #include <QDebug>
 #include "signond-common.h"
 
+#include "SignOn/uisessiondata_priv.h"
+#include "SignOn/authpluginif.h"
+
+#undef SIGNON_TRACE_CATEGORY
+#define SIGNON_TRACE_CATEGORY SignOn::SessionCategory
+
 using namespace SignonDaemonNS;
 
 QVariantMap SignonDaemonNS::mergeVariantMaps(const QVariantMap &map1,
@@ -36,13 +42,10 @@ QVariantMap SignonDaemonNS::mergeVariantMaps(const QVariantMap &map1,
 
     QVariantMap map = map1;
     //map2 values will overwrite map1 values for the same keys.
-    QMapIterator<QString, QVariant> it(map2);
-    while (it.hasNext()) {
-        it.next();
-        if (map.contains(it.key()))
-            map.remove(it.key());
-    }
-    return map.unite(map2);
+    QVariantMap::const_iterator it;
+    for (it = map2.constBegin(); it != map2.constEnd(); it++)
+        map.insert(it.key(), it.value());
+    return map;
 }
 
 /* --------------------- StoreOperation ---------------------- */
@@ -66,6 +69,8 @@ StoreOperation::~StoreOperation()
 
 /* --------------------- RequestData ---------------------- */
 
+static quint64 lastRequestId = 0;
+
 RequestData::RequestData(const QDBusConnection &conn,
                          const QDBusMessage &msg,
                          const QVariantMap &params,
@@ -75,8 +80,11 @@ RequestData::RequestData(const QDBusConnection &conn,
     m_msg(msg),
     m_params(params),
     m_mechanism(mechanism),
-    m_cancelKey(cancelKey)
+    m_cancelKey(cancelKey),
+    m_requestId(++lastRequestId),
+    m_peer(msg.service().isEmpty() ? conn.name() : msg.service())
 {
+    m_queuedTime.start();
 }
 
 RequestData::RequestData(const RequestData &other):
@@ -84,10 +92,258 @@ RequestData::RequestData(const RequestData &other):
     m_msg(other.m_msg),
     m_params(other.m_params),
     m_mechanism(other.m_mechanism),
-    m_cancelKey(other.m_cancelKey)
+    m_cancelKey(other.m_cancelKey),
+    m_requestId(other.m_requestId),
+    m_peer(other.m_peer),
+    m_queuedTime(other.m_queuedTime)
 {
 }
 
 RequestData::~RequestData()
 {
 }
+
+/* --------------------- RequestQueue ---------------------- */
+
+/* Helpers for the intrusive doubly linked lists: a list has "first" and
+ * "last" members, its items have "prev" and "next" members. */
+template <class List, class Item>
+static void listAppend(List *list, Item *item)
+{
+    item->prev = list->last;
+    item->next = 0;
+    if (list->last != 0)
+        list->last->next = item;
+    else
+        list->first = item;
+    list->last = item;
+}
+
+template <class List, class Item>
+static void listRemove(List *list, Item *item)
+{
+    if (item->prev != 0)
+        item->prev->next = item->next;
+    else
+        list->first = item->next;
+    if (item->next != 0)
+        item->next->prev = item->prev;
+    else
+        list->last = item->prev;
+    item->prev = 0;
+    item->next = 0;
+}
+
+QHash<QString, int> RequestQueue::m_queuedPerPeer;
+
+RequestQueue::RequestQueue():
+    m_head(0),
+    m_size(0),
+    m_maxSize(0),
+    m_maxSizePerPeer(0),
+    m_servedCount(0),
+    m_totalWaitTime(0),
+    m_maxWaitTime(0)
+{
+}
+
+RequestQueue::~RequestQueue()
+{
+    if (m_head != 0) {
+        releasePeer(m_head->m_peer);
+        delete m_head;
+    }
+
+    for (int i = 0; i < PriorityCount; i++) {
+        PeerEntry *entry = m_lanes[i].first;
+        while (entry != 0) {
+            Node *node = entry->first;
+            while (node != 0) {
+                Node *next = node->next;
+                releasePeer(entry->name);
+                delete node;
+                node = next;
+            }
+            PeerEntry *next = entry->next;
+            delete entry;
+            entry = next;
+        }
+    }
+}
+
+RequestQueue::Priority RequestQueue::priority(const QVariantMap &params)
+{
+    int policy =
+        params.value(SSOUI_KEY_UIPOLICY, SignOn::DefaultPolicy).toInt();
+    return policy == SignOn::NoUserInteractionPolicy ?
+        BatchPriority : InteractivePriority;
+}
+
+void RequestQueue::setLimits(int maxSize, int maxSizePerPeer)
+{
+    m_maxSize = maxSize;
+    m_maxSizePerPeer = maxSizePerPeer;
+}
+
+bool RequestQueue::isFull(const QString &peer) const
+{
+    if (m_maxSize > 0 && m_size >= m_maxSize)
+        return true;
+
+    if (m_maxSizePerPeer > 0 &&
+        m_queuedPerPeer.value(peer, 0) >= m_maxSizePerPeer)
+        return true;
+
+    return false;
+}
+
+void RequestQueue::enqueue(const RequestData &request)
+{
+    Priority lanePriority = priority(request.m_params);
+    Lane &lane = m_lanes[lanePriority];
+
+    PeerEntry *&entry = lane.peers[request.m_peer];
+    if (entry == 0) {
+        entry = new PeerEntry(request.m_peer, lanePriority);
+        listAppend(&lane, entry);
+    }
+
+    Node *node = new Node(request);
+    node->owner = entry;
+    listAppend(entry, node);
+
+    KeyList &keyList = m_index[request.m_cancelKey];
+    node->keyPrev = keyList.last;
+    if (keyList.last != 0)
+        keyList.last->keyNext = node;
+    else
+        keyList.first = node;
+    keyList.last = node;
+
+    m_queuedPerPeer[request.m_peer]++;
+    m_size++;
+}
+
+RequestData &RequestQueue::head()
+{
+    if (m_head == 0)
+        scheduleHead();
+
+    Q_ASSERT(m_head != 0);
+    return *m_head;
+}
+
+void RequestQueue::removeFirst()
+{
+    if (m_head == 0)
+        scheduleHead();
+
+    if (m_head == 0)
+        return;
+
+    releasePeer(m_head->m_peer);
+    delete m_head;
+    m_head = 0;
+    m_size--;
+}
+
+bool RequestQueue::isHead(const QString &cancelKey) const
+{
+    return m_head != 0 && m_head->m_cancelKey == cancelKey;
+}
+
+RequestData *RequestQueue::take(const QString &cancelKey)
+{
+    /* The head is never taken: it's removed by removeFirst() once the
+     * plugin has replied */
+    QHash<QString, KeyList>::const_iterator it = m_index.constFind(cancelKey);
+    if (it == m_index.constEnd())
+        return 0;
+
+    Node *node = it.value().first;
+    unindex(node);
+    unlink(node);
+    RequestData *request = new RequestData(node->data);
+    delete node;
+
+    releasePeer(request->m_peer);
+    m_size--;
+    return request;
+}
+
+void RequestQueue::scheduleHead()
+{
+    for (int i = 0; i < PriorityCount; i++) {
+        Lane &lane = m_lanes[i];
+        if (lane.first == 0) continue;
+
+        /* Pick the first request of the next peer, and move the peer at the
+         * end of the round (unlink() drops it if it has no more requests) */
+        PeerEntry *entry = lane.first;
+        Node *node = entry->first;
+        if (entry->next != 0) {
+            listRemove(&lane, entry);
+            listAppend(&lane, entry);
+        }
+
+        unindex(node);
+        unlink(node);
+        m_head = new RequestData(node->data);
+        delete node;
+
+        qint64 waitTime = m_head->m_queuedTime.elapsed();
+        m_servedCount++;
+        m_totalWaitTime += waitTime;
+        if (waitTime > m_maxWaitTime)
+            m_maxWaitTime = waitTime;
+
+        TRACE() << "Scheduled request from" << m_head->m_peer <<
+            "priority" << i << "waited" << waitTime << "ms";
+        return;
+    }
+}
+
+void RequestQueue::unlink(Node *node)
+{
+    PeerEntry *entry = node->owner;
+    listRemove(entry, node);
+    node->owner = 0;
+
+    if (entry->first == 0) {
+        Lane &lane = m_lanes[entry->lane];
+        listRemove(&lane, entry);
+        lane.peers.remove(entry->name);
+        delete entry;
+    }
+}
+
+void RequestQueue::unindex(Node *node)
+{
+    QHash<QString, KeyList>::iterator it =
+        m_index.find(node->data.m_cancelKey);
+    Q_ASSERT(it != m_index.end());
+    KeyList &keyList = it.value();
+
+    if (node->keyPrev != 0)
+        node->keyPrev->keyNext = node->keyNext;
+    else
+        keyList.first = node->keyNext;
+    if (node->keyNext != 0)
+        node->keyNext->keyPrev = node->keyPrev;
+    else
+        keyList.last = node->keyPrev;
+    node->keyPrev = 0;
+    node->keyNext = 0;
+
+    if (keyList.first == 0)
+        m_index.erase(it);
+}
+
+void RequestQueue::releasePeer(const QString &peer)
+{
+    QHash<QString, int>::iterator it = m_queuedPerPeer.find(peer);
+    if (it == m_queuedPerPeer.end()) return;
+
+    if (--it.value() <= 0)
+        m_queuedPerPeer.erase(it);
+}
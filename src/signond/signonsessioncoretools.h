@@ -24,6 +24,9 @@
 #ifndef SIGNONSESSIONCORETOOLS_H
 #define SIGNONSESSIONCORETOOLS_H
 
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
 #include <QObject>
 #include <QVariantMap>
 #include <QDBusMessage>
@@ -85,6 +88,144 @@ public:
     QVariantMap m_params;
     QString m_mechanism;
     QString m_cancelKey;
+    /* unique among the requests received by the daemon, increasing */
+    quint64 m_requestId;
+    /* the unique bus name (or the p2p connection name) of the client */
+    QString m_peer;
+    /* started when the request is queued */
+    QElapsedTimer m_queuedTime;
+};
+
+/*!
+ * @class RequestQueue
+ * Queue of the requests pending on a session core.
+ * Requests which allow user interaction are served before the ones which
+ * don't (see SignOn::NoUserInteractionPolicy); requests with the same
+ * priority are served round-robin among the requesting peers, so that a
+ * client flooding a session cannot starve the other ones.
+ * Once head() has been called, the returned request stays at the head of the
+ * queue until removeFirst() is called.
+ * Requests are kept in intrusive linked lists indexed by their cancel key, so
+ * that enqueuing, scheduling and cancelling a request take constant time.
+ */
+class RequestQueue
+{
+public:
+    enum Priority {
+        InteractivePriority = 0,
+        BatchPriority,
+        PriorityCount
+    };
+
+    RequestQueue();
+    ~RequestQueue();
+
+    static Priority priority(const QVariantMap &params);
+
+    /*!
+     * Limits the number of requests which can be queued; 0 means no limit.
+     * @param maxSize the maximum number of requests in this queue.
+     * @param maxSizePerPeer the maximum number of requests which a single
+     * peer can have queued, in all the queues of the daemon.
+     */
+    void setLimits(int maxSize, int maxSizePerPeer);
+
+    /*!
+     * @returns true if a new request from @peer would exceed the limits.
+     */
+    bool isFull(const QString &peer) const;
+
+    void enqueue(const RequestData &request);
+    bool isEmpty() const { return m_size == 0; }
+    int size() const { return m_size; }
+
+    RequestData &head();
+    void removeFirst();
+
+    /*!
+     * @returns true if the request identified by @cancelKey is the one
+     * returned by head().
+     */
+    bool isHead(const QString &cancelKey) const;
+
+    /*!
+     * Removes the oldest queued request identified by @cancelKey from the
+     * queue; the request returned by head() is never removed.
+     * @returns the removed request, which must be deleted by the caller, or
+     * 0 if the request was not found.
+     */
+    RequestData *take(const QString &cancelKey);
+
+    /* queue wait time statistics, in milliseconds */
+    quint64 servedCount() const { return m_servedCount; }
+    qint64 totalWaitTime() const { return m_totalWaitTime; }
+    qint64 maxWaitTime() const { return m_maxWaitTime; }
+
+private:
+    struct PeerEntry;
+
+    /* A queued request, linked in the list of its peer and in the list of
+     * the requests sharing its cancel key */
+    struct Node {
+        Node(const RequestData &request):
+            data(request), prev(0), next(0), owner(0),
+            keyPrev(0), keyNext(0) {}
+        RequestData data;
+        Node *prev;
+        Node *next;
+        PeerEntry *owner;
+        Node *keyPrev;
+        Node *keyNext;
+    };
+
+    /* The requests sharing a cancel key, oldest first */
+    struct KeyList {
+        KeyList(): first(0), last(0) {}
+        Node *first;
+        Node *last;
+    };
+
+    /* The requests of a peer in a lane, linked in the round-robin list of
+     * the lane */
+    struct PeerEntry {
+        PeerEntry(const QString &name, int lane):
+            name(name), lane(lane), first(0), last(0), prev(0), next(0) {}
+        QString name;
+        int lane;
+        Node *first;
+        Node *last;
+        PeerEntry *prev;
+        PeerEntry *next;
+    };
+
+    struct Lane {
+        Lane(): first(0), last(0) {}
+        QHash<QString, PeerEntry *> peers;
+        PeerEntry *first;
+        PeerEntry *last;
+    };
+
+    void scheduleHead();
+    void unlink(Node *node);
+    void unindex(Node *node);
+    void releasePeer(const QString &peer);
+
+private:
+    Lane m_lanes[PriorityCount];
+    /* queued requests (excluding the head) by cancel key, oldest first */
+    QHash<QString, KeyList> m_index;
+    RequestData *m_head;
+    int m_size;
+    int m_maxSize;
+    int m_maxSizePerPeer;
+    quint64 m_servedCount;
+    qint64 m_totalWaitTime;
+    qint64 m_maxWaitTime;
+
+    /* number of queued requests per peer, across all queues */
+    static QHash<QString, int> m_queuedPerPeer;
+
+    Q_DISABLE_COPY(RequestQueue)
 };
 
 } //SignonDaemonNS
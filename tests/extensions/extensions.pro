@@ -1,3 +1,4 @@
 TEMPLATE = subdirs
 SUBDIRS = \
-    tst_access_control_manager.pro
+    tst_access_control_manager.pro \
+    tst_aead.pro
@@ -0,0 +1,362 @@
+/*
+ * This file is part of signon
+ *
+ * Copyright (C) 2013 Canonical Ltd.
+ *
+ * Contact: Alberto Mardegan <alberto.mardegan@canonical.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QSqlDatabase>
+#include <QTest>
+
+#include <unistd.h>
+
+#include "aead-cipher.h"
+#include "aead-crypto-manager.h"
+#include "aead-keyring.h"
+#include "aead-secrets-storage.h"
+#ifdef HAVE_CRYPTSETUP
+#include "crypto-manager.h"
+#endif
+
+using namespace SignOn;
+
+class AeadTest: public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void init();
+    void cleanup();
+    void cipherTest();
+    void keyringTest();
+    void storageTest();
+    void backupTest();
+    void unlockBenchmark_data();
+    void unlockBenchmark();
+
+private:
+    QVariantMap configuration(const QString &name) const;
+
+    QString m_dirPath;
+};
+
+void AeadTest::init()
+{
+    m_dirPath = QDir::temp().filePath(
+        QString("tst_aead-%1").arg(QCoreApplication::applicationPid()));
+    QDir().mkpath(m_dirPath);
+}
+
+static void removeDir(const QString &dirPath)
+{
+    QDir dir(dirPath);
+    foreach (const QString &entry,
+             dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot))
+        removeDir(dir.filePath(entry));
+    foreach (const QString &file, dir.entryList(QDir::Files))
+        dir.remove(file);
+    QDir().rmdir(dirPath);
+}
+
+void AeadTest::cleanup()
+{
+    removeDir(m_dirPath);
+}
+
+/* The cryptsetup extension mounts asynchronously */
+static bool waitForMounted(AbstractCryptoManager *manager)
+{
+    for (int i = 0; i < 600 && !manager->fileSystemIsMounted(); i++)
+        QTest::qWait(100);
+    return manager->fileSystemIsMounted();
+}
+
+QVariantMap AeadTest::configuration(const QString &name) const
+{
+    QVariantMap configuration;
+    configuration.insert("StoragePath", m_dirPath + "/" + name);
+    configuration.insert("FileSystemType", "ext2");
+    configuration.insert("Size", 4);
+    return configuration;
+}
+
+void AeadTest::cipherTest()
+{
+    QByteArray key = AeadCipher::deriveKey("secret", "salt", "test");
+    QCOMPARE(key.size(), int(AeadCipher::KeySize));
+    QCOMPARE(AeadCipher::deriveKey("secret", "salt", "test"), key);
+    QVERIFY(AeadCipher::deriveKey("secret", "salt", "other") != key);
+
+    QByteArray sealed = AeadCipher::seal(key, "plaintext", "ad");
+    QCOMPARE(sealed.size(), int(AeadCipher::NonceSize + 9 +
+                                AeadCipher::TagSize));
+    /* A new nonce is used each time */
+    QVERIFY(AeadCipher::seal(key, "plaintext", "ad") != sealed);
+
+    QByteArray plaintext;
+    QVERIFY(AeadCipher::open(key, sealed, "ad", plaintext));
+    QCOMPARE(plaintext, QByteArray("plaintext"));
+
+    /* Wrong additional data, key or tampered ciphertext */
+    QVERIFY(!AeadCipher::open(key, sealed, "other", plaintext));
+    QVERIFY(!AeadCipher::open(AeadCipher::deriveKey("other", "salt", "test"),
+                              sealed, "ad", plaintext));
+    QByteArray tampered = sealed;
+    tampered[AeadCipher::NonceSize] = tampered[AeadCipher::NonceSize] ^ 1;
+    QVERIFY(!AeadCipher::open(key, tampered, "ad", plaintext));
+    QVERIFY(!AeadCipher::open(key, sealed.left(8), "ad", plaintext));
+
+    AeadCipher::wipe(key);
+    QVERIFY(key.isEmpty());
+}
+
+void AeadTest::keyringTest()
+{
+    AeadKeyring keyring;
+    keyring.setFilePath(m_dirPath + "/keyring");
+    QVERIFY(!keyring.exists());
+    QVERIFY(!keyring.unlock("first"));
+
+    QVERIFY(keyring.create("first"));
+    QVERIFY(keyring.exists());
+    QVERIFY(keyring.isUnlocked());
+    QByteArray dataKey = keyring.dataKey();
+    QCOMPARE(dataKey.size(), int(AeadCipher::KeySize));
+
+    QVERIFY(keyring.addKey("second"));
+    QVERIFY(keyring.hasKey("first"));
+    QVERIFY(keyring.hasKey("second"));
+    QVERIFY(!keyring.hasKey("third"));
+
+    keyring.lock();
+    QVERIFY(!keyring.isUnlocked());
+    QVERIFY(!keyring.addKey("third"));
+    QVERIFY(!keyring.unlock("third"));
+    QVERIFY(keyring.unlock("second"));
+    QCOMPARE(keyring.dataKey(), dataKey);
+
+    QVERIFY(keyring.removeKey("first"));
+    QVERIFY(!keyring.hasKey("first"));
+    /* The last key cannot be removed */
+    QVERIFY(!keyring.removeKey("second"));
+
+    keyring.lock();
+    QVERIFY(!keyring.unlock("first"));
+    QVERIFY(keyring.unlock("second"));
+    QCOMPARE(keyring.dataKey(), dataKey);
+
+    QVERIFY(keyring.remove());
+    QVERIFY(!keyring.exists());
+    QVERIFY(!keyring.isUnlocked());
+}
+
+void AeadTest::storageTest()
+{
+    AeadKeyring keyring;
+    AeadCryptoManager manager(&keyring);
+    QVERIFY(manager.initialize(configuration("storage")));
+    QVERIFY(!manager.fileSystemIsSetup());
+    manager.setEncryptionKey("key");
+    QVERIFY(manager.setupFileSystem());
+    QVERIFY(manager.fileSystemIsMounted());
+
+    QVariantMap dbConfiguration;
+    dbConfiguration.insert("name",
+                           manager.fileSystemMountPath() + "/secrets.db");
+
+    AeadSecretsStorage storage(&keyring);
+    QVERIFY(storage.initialize(dbConfiguration));
+    QVERIFY(storage.isOpen());
+
+    QVariantMap data;
+    data.insert("token", QByteArray("xyz"));
+    data.insert("expiry", 3600);
+    QVERIFY(storage.updateCredentials(1, "user", "pass"));
+    QVERIFY(storage.storeData(1, 2, data));
+
+    QList<SecretsCredentials> credentials;
+    credentials << SecretsCredentials(2, "user2", "pass2")
+        << SecretsCredentials(3, "user3", "pass3");
+    QVERIFY(storage.updateCredentialsBatch(credentials));
+    QList<SecretsData> items;
+    items << SecretsData(2, 2, data) << SecretsData(3, 4, data);
+    QVERIFY(storage.storeDataBatch(items));
+
+    QString username, password;
+    QVERIFY(storage.loadCredentials(1, username, password));
+    QCOMPARE(username, QString("user"));
+    QCOMPARE(password, QString("pass"));
+    QVERIFY(storage.loadCredentials(3, username, password));
+    QCOMPARE(username, QString("user3"));
+    QCOMPARE(password, QString("pass3"));
+    QCOMPARE(storage.loadData(1, 2), data);
+    QCOMPARE(storage.loadData(3, 4), data);
+    QVERIFY(storage.loadData(1, 4).isEmpty());
+
+    /* The same size limit as the default storage applies */
+    QVariantMap tooBig;
+    tooBig.insert("token", QString(4 * 1024, 'x'));
+    QVERIFY(!storage.storeData(1, 5, tooBig));
+    QVERIFY(storage.loadData(1, 5).isEmpty());
+
+    /* The secrets are not stored in clear */
+    QFile file(manager.fileSystemMountPath() + "/secrets.db");
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QByteArray contents = file.readAll();
+    QVERIFY(!contents.contains("pass3"));
+    QVERIFY(!contents.contains("xyz"));
+    file.close();
+
+    QVERIFY(storage.removeData(1, 2));
+    QVERIFY(storage.loadData(1, 2).isEmpty());
+    QVERIFY(storage.removeCredentials(2));
+    QVERIFY(!storage.loadCredentials(2, username, password));
+    QVERIFY(storage.loadData(2, 2).isEmpty());
+    storage.close();
+
+    /* After a remount with another key, the secrets are still there */
+    QVERIFY(manager.addEncryptionKey("other", "key"));
+    QVERIFY(manager.unmountFileSystem());
+    QVERIFY(!keyring.isUnlocked());
+    QVERIFY(!storage.initialize(dbConfiguration));
+    manager.setEncryptionKey("wrong");
+    QVERIFY(!manager.mountFileSystem());
+    manager.setEncryptionKey("other");
+    QVERIFY(manager.mountFileSystem());
+    QVERIFY(storage.initialize(dbConfiguration));
+    QVERIFY(storage.loadCredentials(1, username, password));
+    QCOMPARE(password, QString("pass"));
+    QCOMPARE(storage.loadData(3, 4), data);
+
+    QVERIFY(storage.clear());
+    QVERIFY(!storage.loadCredentials(1, username, password));
+    storage.close();
+    QVERIFY(manager.deleteFileSystem());
+}
+
+void AeadTest::backupTest()
+{
+    QString storagePath = m_dirPath + "/backup";
+    QString backupPath = m_dirPath + "/backup-copy";
+    QStringList files;
+
+    {
+        AeadKeyring keyring;
+        AeadCryptoManager manager(&keyring);
+        QVERIFY(manager.initialize(configuration("backup")));
+        manager.setEncryptionKey("key");
+        QVERIFY(manager.setupFileSystem());
+
+        AeadSecretsStorage storage(&keyring);
+        QVariantMap dbConfiguration;
+        dbConfiguration.insert("name",
+                               manager.fileSystemMountPath() +
+                               "/signon-secrets.db");
+        QVERIFY(storage.initialize(dbConfiguration));
+        QVERIFY(storage.updateCredentials(1, "user", "pass"));
+        storage.close();
+
+        /* The names are relative to the storage path */
+        files = manager.backupFiles();
+        QCOMPARE(files, QStringList() << "signon-keyring" <<
+                 "signon-secrets.db");
+
+        /* Copy the files as SignonDaemon::copyToBackupDir() does */
+        QVERIFY(QDir().mkpath(backupPath));
+        foreach (const QString &file, files) {
+            QVERIFY(QFile::copy(storagePath + "/" + file,
+                                backupPath + "/" + file));
+        }
+
+        QVERIFY(manager.unmountFileSystem());
+        QVERIFY(manager.deleteFileSystem());
+        QVERIFY(QFile::remove(storagePath + "/signon-secrets.db"));
+    }
+
+    /* Restore */
+    foreach (const QString &file, files) {
+        QVERIFY(QFile::copy(backupPath + "/" + file,
+                            storagePath + "/" + file));
+    }
+
+    AeadKeyring keyring;
+    AeadCryptoManager manager(&keyring);
+    QVERIFY(manager.initialize(configuration("backup")));
+    QVERIFY(manager.fileSystemIsSetup());
+    manager.setEncryptionKey("key");
+    QVERIFY(manager.mountFileSystem());
+
+    AeadSecretsStorage storage(&keyring);
+    QVariantMap dbConfiguration;
+    dbConfiguration.insert("name", storagePath + "/signon-secrets.db");
+    QVERIFY(storage.initialize(dbConfiguration));
+    QString username, password;
+    QVERIFY(storage.loadCredentials(1, username, password));
+    QCOMPARE(username, QString("user"));
+    QCOMPARE(password, QString("pass"));
+    storage.close();
+}
+
+void AeadTest::unlockBenchmark_data()
+{
+    QTest::addColumn<QString>("extension");
+
+    QTest::newRow("aead") << "aead";
+#ifdef HAVE_CRYPTSETUP
+    QTest::newRow("cryptsetup") << "cryptsetup";
+#endif
+}
+
+void AeadTest::unlockBenchmark()
+{
+    QFETCH(QString, extension);
+
+    AeadKeyring keyring;
+    AbstractCryptoManager *manager = 0;
+    if (extension == "aead") {
+        manager = new AeadCryptoManager(&keyring, this);
+    } else {
+#ifdef HAVE_CRYPTSETUP
+        if (::geteuid() != 0)
+            QSKIP("cryptsetup requires root privileges", SkipSingle);
+        manager = new CryptoManager(this);
+#endif
+    }
+
+    QVERIFY(manager->initialize(configuration("benchmark")));
+    manager->setEncryptionKey("key");
+    QVERIFY(manager->setupFileSystem());
+    QVERIFY(waitForMounted(manager));
+    QVERIFY(manager->unmountFileSystem());
+
+    QBENCHMARK {
+        manager->mountFileSystem();
+        waitForMounted(manager);
+        manager->unmountFileSystem();
+    }
+
+    QVERIFY(manager->deleteFileSystem());
+    delete manager;
+}
+
+QTEST_MAIN(AeadTest)
+#include "tst_aead.moc"
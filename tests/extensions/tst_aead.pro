@@ -0,0 +1,38 @@
+include(extensions.pri)
+
+TARGET = tst_aead
+
+AEAD_SRC_DIR = $${TOP_SRC_DIR}/src/extensions/aead
+
+INCLUDEPATH += \
+    $${AEAD_SRC_DIR}
+
+HEADERS += \
+    $${AEAD_SRC_DIR}/aead-crypto-manager.h \
+    $${AEAD_SRC_DIR}/aead-secrets-storage.h
+
+SOURCES += \
+    tst_aead.cpp \
+    $${AEAD_SRC_DIR}/aead-cipher.cpp \
+    $${AEAD_SRC_DIR}/aead-crypto-manager.cpp \
+    $${AEAD_SRC_DIR}/aead-keyring.cpp \
+    $${AEAD_SRC_DIR}/aead-secrets-storage.cpp
+
+PKGCONFIG += \
+    libcrypto
+
+# Compare the unlock latency with the cryptsetup extension, when built
+CONFIG(cryptsetup) {
+    CRYPTSETUP_SRC_DIR = $${TOP_SRC_DIR}/src/extensions/cryptsetup
+    INCLUDEPATH += $${CRYPTSETUP_SRC_DIR}
+    HEADERS += $${CRYPTSETUP_SRC_DIR}/crypto-manager.h
+    SOURCES += \
+        $${CRYPTSETUP_SRC_DIR}/crypto-handlers.cpp \
+        $${CRYPTSETUP_SRC_DIR}/crypto-manager.cpp \
+        $${CRYPTSETUP_SRC_DIR}/misc.cpp
+    LIBS += -lcryptsetup
+    DEFINES += HAVE_CRYPTSETUP
+}
+
+check.depends = $$TARGET
+check.commands = "./$$TARGET"
@@ -25,7 +25,10 @@
 #include "signon-ui.h"
 #include "ssotestclient.h"
 
+#include <QDBusArgument>
+#include <QDBusMessage>
 #include <QEventLoop>
+#include <QSignalSpy>
 #include <QTimer>
 #include <QTest>
 #include <QThread>
@@ -753,6 +756,109 @@ void SsoTestClient::queryInfo()
     TEST_DONE
 }
 
+void SsoTestClient::queryInfoShared()
+{
+    TEST_START
+    m_identityResult.reset();
+
+    IdentityInfo info("SHARED_CAPTION", "SHARED_USERNAME",
+                      QMap<MethodName, MechanismsList>());
+    info.setAccessControlList(QStringList() << "*");
+    QVERIFY(storeCredentialsPrivate(info));
+
+    Identity *first = Identity::existingIdentity(m_storedIdentityId, this);
+    QVERIFY(first != NULL);
+
+    QEventLoop loop;
+    connect(first, SIGNAL(info(const SignOn::IdentityInfo &)),
+            &m_identityResult, SLOT(info(const SignOn::IdentityInfo &)));
+    connect(first, SIGNAL(error(const SignOn::Error &)),
+            &m_identityResult, SLOT(error(const SignOn::Error &)));
+    connect(&m_identityResult, SIGNAL(testCompleted()), &loop, SLOT(quit()));
+
+    first->queryInfo();
+
+    QTimer::singleShot(test_timeout, &loop, SLOT(quit()));
+    loop.exec();
+    QCOMPARE(m_identityResult.m_responseReceived,
+             TestIdentityResult::NormalResp);
+
+    /* A second object for the same identity is answered from the data
+     * received by the first one, without waiting for signond */
+    m_identityResult.reset();
+    Identity *second = Identity::existingIdentity(m_storedIdentityId, this);
+    QVERIFY(second != NULL);
+    connect(second, SIGNAL(info(const SignOn::IdentityInfo &)),
+            &m_identityResult, SLOT(info(const SignOn::IdentityInfo &)));
+
+    second->queryInfo();
+    QCOMPARE(m_identityResult.m_responseReceived,
+             TestIdentityResult::NormalResp);
+    QCOMPARE(m_identityResult.m_idInfo.caption(),
+             QString("SHARED_CAPTION"));
+
+    delete second;
+    delete first;
+    TEST_DONE
+}
+
+void SsoTestClient::queryInfoSharedUpdated()
+{
+    TEST_START
+    m_identityResult.reset();
+
+    IdentityInfo info("OLD_CAPTION", "SHARED_USERNAME",
+                      QMap<MethodName, MechanismsList>());
+    info.setAccessControlList(QStringList() << "*");
+    QVERIFY(storeCredentialsPrivate(info));
+
+    Identity *reader = Identity::existingIdentity(m_storedIdentityId, this);
+    Identity *writer = Identity::existingIdentity(m_storedIdentityId, this);
+    QVERIFY(reader != NULL);
+    QVERIFY(writer != NULL);
+    QSignalSpy infoReceived(reader, SIGNAL(info(const SignOn::IdentityInfo &)));
+    QSignalSpy stored(writer, SIGNAL(credentialsStored(const quint32)));
+
+    /* The info is read while the identity is being updated */
+    info.setCaption("NEW_CAPTION");
+    writer->storeCredentials(info);
+    reader->queryInfo();
+    for (int i = 0; i < test_timeout / 100; i++) {
+        if (infoReceived.count() > 0 && stored.count() > 0) break;
+        QTest::qWait(100);
+    }
+    QCOMPARE(stored.count(), 1);
+    QCOMPARE(infoReceived.count(), 1);
+
+    /* Let the change notification arrive */
+    QTest::qWait(500);
+
+    /* A reply sent before the notification must not be kept as valid */
+    QEventLoop loop;
+    Identity *late = Identity::existingIdentity(m_storedIdentityId, this);
+    QVERIFY(late != NULL);
+    connect(late, SIGNAL(info(const SignOn::IdentityInfo &)),
+            &m_identityResult, SLOT(info(const SignOn::IdentityInfo &)));
+    connect(late, SIGNAL(error(const SignOn::Error &)),
+            &m_identityResult, SLOT(error(const SignOn::Error &)));
+    connect(&m_identityResult, SIGNAL(testCompleted()), &loop, SLOT(quit()));
+
+    late->queryInfo();
+    if (m_identityResult.m_responseReceived ==
+        TestIdentityResult::InexistentResp) {
+        QTimer::singleShot(test_timeout, &loop, SLOT(quit()));
+        loop.exec();
+    }
+    QCOMPARE(m_identityResult.m_responseReceived,
+             TestIdentityResult::NormalResp);
+    QCOMPARE(m_identityResult.m_idInfo.caption(), QString("NEW_CAPTION"));
+
+    delete late;
+    delete writer;
+    delete reader;
+    TEST_DONE
+}
+
 void SsoTestClient::addReference()
 {
     TEST_START
@@ -1339,6 +1445,120 @@ void SsoTestClient::queryIdentities()
     TEST_DONE
 }
 
+void SsoTestClient::existingIdentities()
+{
+    TEST_START
+
+    QList<quint32> ids;
+    QStringList captions;
+    captions << "BATCH_CAPTION_1" << "BATCH_CAPTION_2";
+    foreach (const QString &caption, captions) {
+        m_identityResult.reset();
+        IdentityInfo info(caption, "BATCH_USERNAME",
+                          QMap<MethodName, MechanismsList>());
+        info.setAccessControlList(QStringList() << "*");
+        QVERIFY(storeCredentialsPrivate(info));
+        ids.append(m_storedIdentityId);
+    }
+
+    AuthService service;
+    QList<Identity *> identities =
+        service.existingIdentities(QList<quint32>() << 0 << ids, this);
+    QCOMPARE(identities.count(), ids.count());
+
+    for (int i = 0; i < identities.count(); i++) {
+        Identity *identity = identities[i];
+        QCOMPARE(identity->id(), ids[i]);
+
+        m_identityResult.reset();
+        QEventLoop loop;
+
+        connect(identity, SIGNAL(info(const SignOn::IdentityInfo &)),
+                &m_identityResult, SLOT(info(const SignOn::IdentityInfo &)));
+        connect(identity, SIGNAL(error(const SignOn::Error &)),
+                &m_identityResult, SLOT(error(const SignOn::Error &)));
+        connect(&m_identityResult, SIGNAL(testCompleted()),
+                &loop, SLOT(quit()));
+
+        identity->queryInfo();
+
+        QTimer::singleShot(test_timeout, &loop, SLOT(quit()));
+        loop.exec();
+
+        QCOMPARE(m_identityResult.m_responseReceived,
+                 TestIdentityResult::NormalResp);
+        QCOMPARE(m_identityResult.m_idInfo.caption(), captions[i]);
+    }
+
+    qDeleteAll(identities);
+    TEST_DONE
+}
+
+void SsoTestClient::existingIdentitiesLimit()
+{
+    TEST_START
+
+    m_identityResult.reset();
+    IdentityInfo info("BATCH_LIMIT_CAPTION", "BATCH_USERNAME",
+                      QMap<MethodName, MechanismsList>());
+    info.setAccessControlList(QStringList() << "*");
+    QVERIFY(storeCredentialsPrivate(info));
+    quint32 storedId = m_storedIdentityId;
+
+    /* Non existing identities, followed by the stored one */
+    QList<quint32> ids;
+    for (int i = 0; i < SIGNOND_MAX_IDENTITIES_PER_CALL; i++)
+        ids.append(storedId + 1000 + i);
+    ids.append(storedId);
+
+    /* The service rejects a list over the limit... */
+    QList<uint> idList;
+    foreach (quint32 id, ids)
+        idList.append(id);
+    QDBusArgument idsArg;
+    idsArg << idList;
+    QDBusMessage msg =
+        QDBusMessage::createMethodCall(SIGNOND_SERVICE,
+                                       SIGNOND_DAEMON_OBJECTPATH,
+                                       SIGNOND_DAEMON_INTERFACE,
+                                       "getIdentities");
+    msg << QVariant::fromValue(idsArg);
+    QDBusMessage reply = SIGNOND_BUS.call(msg);
+    QCOMPARE(reply.type(), QDBusMessage::ErrorMessage);
+    QCOMPARE(reply.errorName(), QString(SIGNOND_INVALID_QUERY_ERR_NAME));
+
+    /* ...which the client splits */
+    AuthService service;
+    QList<Identity *> identities = service.existingIdentities(ids, this);
+    QCOMPARE(identities.count(), ids.count());
+
+    Identity *identity = identities.last();
+    QCOMPARE(identity->id(), storedId);
+
+    m_identityResult.reset();
+    QEventLoop loop;
+
+    connect(identity, SIGNAL(info(const SignOn::IdentityInfo &)),
+            &m_identityResult, SLOT(info(const SignOn::IdentityInfo &)));
+    connect(identity, SIGNAL(error(const SignOn::Error &)),
+            &m_identityResult, SLOT(error(const SignOn::Error &)));
+    connect(&m_identityResult, SIGNAL(testCompleted()),
+            &loop, SLOT(quit()));
+
+    identity->queryInfo();
+
+    QTimer::singleShot(test_timeout, &loop, SLOT(quit()));
+    loop.exec();
+
+    QCOMPARE(m_identityResult.m_responseReceived,
+             TestIdentityResult::NormalResp);
+    QCOMPARE(m_identityResult.m_idInfo.caption(),
+             QString("BATCH_LIMIT_CAPTION"));
+
+    qDeleteAll(identities);
+    TEST_DONE
+}
+
 void SsoTestClient::queryIdentitiesWithFilter()
 {
     QSKIP("Test requires the implementation of the filtering feature.",
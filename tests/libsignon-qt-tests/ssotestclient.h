@@ -50,6 +50,8 @@ private Q_SLOTS:
     void queryIdentities();
     void queryMethods();
     void queryMechanisms();
+    void existingIdentities();
+    void existingIdentitiesLimit();
     void clear();
 
     /*
@@ -60,6 +62,8 @@ private Q_SLOTS:
     void storeCredentials();
     void requestCredentialsUpdate();
     void queryInfo();
+    void queryInfoShared();
+    void queryInfoSharedUpdated();
     void addReference();
     void removeReference();
     void verifyUser();
@@ -592,6 +592,48 @@ void TestAuthSession::process_many_times_before_auth()
     QCOMPARE(spyResponse.count(), 1);
 }
 
+void TestAuthSession::process_pipelined()
+{
+    AuthSession *as;
+    SSO_TEST_CREATE_AUTH_SESSION(as, "ssotest");
+
+    as->setMaxPendingRequests(3);
+    QCOMPARE(as->maxPendingRequests(), 3);
+
+    QSignalSpy spyResponse(as, SIGNAL(processResponse(int,
+                                      const SignOn::SessionData&)));
+    QSignalSpy spyError(as, SIGNAL(error(const SignOn::Error &)));
+    QEventLoop loop;
+
+    SessionData inData;
+
+    inData.setSecret("testSecret");
+    inData.setUserName("testUsername");
+
+    QList<int> requestIds;
+    for (int i = 0; i < 4; i++)
+        requestIds.append(as->process(inData, "mech1"));
+
+    /* The fourth request exceeds the limit */
+    QCOMPARE(requestIds[3], 0);
+    QCOMPARE(spyError.count(), 1);
+
+    QObject::connect(as, SIGNAL(processResponse(int,
+                                const SignOn::SessionData&)),
+                     &loop, SLOT(quit()));
+    for (int i = 0; i < 3 && spyResponse.count() < 3; i++) {
+        QTimer::singleShot(10*1000, &loop, SLOT(quit()));
+        loop.exec();
+    }
+
+    QCOMPARE(spyResponse.count(), 3);
+    QCOMPARE(spyError.count(), 1);
+    for (int i = 0; i < 3; i++) {
+        QVERIFY(requestIds[i] != 0);
+        QCOMPARE(spyResponse.at(i).at(0).toInt(), requestIds[i]);
+    }
+}
+
 void TestAuthSession::process_with_big_session_data()
 {
     //TODO once bug Bug#222200 is fixed, this test case can be enabled
@@ -89,6 +89,7 @@ private Q_SLOTS:
     void process_from_other_process();
     void process_many_times_after_auth();
     void process_many_times_before_auth();
+    void process_pipelined();
     void process_with_big_session_data();
     void process_after_timeout();
 
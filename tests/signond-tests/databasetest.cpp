@@ -628,6 +628,265 @@ void TestDatabase::cacheTest()
     QVERIFY(!ok);
 }
 
+void TestDatabase::cacheEvictionTest()
+{
+    SignonIdentityInfo info;
+    info.setUserName(QLatin1String("User"));
+    info.setPassword(QLatin1String("Pass"));
+    info.setStorePassword(true);
+    quint32 id = m_db->insertCredentials(info);
+    QVERIFY(id != 0);
+
+    QVariantMap data;
+    data.insert(QLatin1String("token"), QString(200, QLatin1Char('x')));
+
+    /* no secrets DB: data will be cached in memory, up to the limit */
+    m_db->setSecretsCacheMaxSize(1000);
+    QVERIFY(m_db->storeData(id, QLatin1String("Method1"), data));
+    QVERIFY(m_db->storeData(id, QLatin1String("Method2"), data));
+    QVariantMap stats = m_db->secretsCacheStatistics();
+    QCOMPARE(stats.value("Evictions").toInt(), 0);
+    qint64 size = stats.value("Size").toLongLong();
+    QVERIFY(size > 0);
+    QVERIFY(size <= 1000);
+
+    /* use Method1, so that Method2 is the least recently used */
+    QCOMPARE(m_db->loadData(id, QLatin1String("Method1")), data);
+    QVERIFY(m_db->storeData(id, QLatin1String("Method3"), data));
+
+    stats = m_db->secretsCacheStatistics();
+    QCOMPARE(stats.value("Evictions").toInt(), 1);
+    QVERIFY(stats.value("Size").toLongLong() <= 1000);
+    QVERIFY(stats.value("EvictedSize").toLongLong() > 0);
+    QCOMPARE(m_db->loadData(id, QLatin1String("Method1")), data);
+    QVERIFY(m_db->loadData(id, QLatin1String("Method2")).isEmpty());
+    QCOMPARE(m_db->loadData(id, QLatin1String("Method3")), data);
+
+    /* the password is never evicted */
+    m_db->setSecretsCacheMaxSize(1);
+    stats = m_db->secretsCacheStatistics();
+    QCOMPARE(stats.value("Evictions").toInt(), 3);
+    QCOMPARE(m_db->credentials(id, true).password(), QLatin1String("Pass"));
+
+    /* storing the cache into the secrets DB releases all the memory */
+    QVERIFY(m_db->openSecretsDB(secretsDbFile));
+    stats = m_db->secretsCacheStatistics();
+    QCOMPARE(stats.value("Size").toLongLong(), qint64(0));
+    QCOMPARE(stats.value("Entries").toInt(), 0);
+}
+
+void TestDatabase::batchTest()
+{
+    QVERIFY(m_db->openSecretsDB(secretsDbFile));
+
+    QList<SecretsCredentials> credentials;
+    credentials << SecretsCredentials(1001, "User1", "Pass1") <<
+        SecretsCredentials(1002, QString(), "Pass2");
+    QVERIFY(m_secretsStorage->updateCredentialsBatch(credentials));
+
+    QString username, password;
+    QVERIFY(m_secretsStorage->loadCredentials(1001, username, password));
+    QCOMPARE(username, QString("User1"));
+    QCOMPARE(password, QString("Pass1"));
+    QVERIFY(m_secretsStorage->loadCredentials(1002, username, password));
+    QCOMPARE(password, QString("Pass2"));
+
+    QVariantMap data1;
+    data1.insert("token", "tokenval1");
+    QVariantMap data2;
+    data2.insert("token", "tokenval2");
+    QList<SecretsData> data;
+    data << SecretsData(1001, 1, data1) << SecretsData(1002, 2, data2);
+    QVERIFY(m_secretsStorage->storeDataBatch(data));
+
+    QList<SecretsData> loaded;
+    loaded << SecretsData(1002, 2) << SecretsData(1001, 1) <<
+        SecretsData(1001, 2);
+    QVERIFY(m_secretsStorage->loadDataBatch(loaded));
+    QCOMPARE(loaded[0].data, data2);
+    QCOMPARE(loaded[1].data, data1);
+    QVERIFY(loaded[2].data.isEmpty());
+
+    /* If one item fails, none of the batch is stored */
+    QVariantMap tooBig;
+    tooBig.insert("token", QString(SSO_MAX_TOKEN_STORAGE, 'x'));
+    data.clear();
+    data << SecretsData(1001, 1, data2) << SecretsData(1002, 2, tooBig);
+    QVERIFY(!m_secretsStorage->storeDataBatch(data));
+    QCOMPARE(m_secretsStorage->loadData(1001, 1), data1);
+    QCOMPARE(m_secretsStorage->loadData(1002, 2), data2);
+}
+
+void TestDatabase::cacheFlushFailureTest()
+{
+    m_db->setSecretsCacheMaxSize(0);
+
+    SignonIdentityInfo info;
+    info.setUserName(QLatin1String("User"));
+    info.setPassword(QLatin1String("Pass"));
+    info.setStorePassword(true);
+
+    QVariantMap data;
+    data.insert("token", "tokenval");
+    QVariantMap tooBig;
+    tooBig.insert("token", QString(SSO_MAX_TOKEN_STORAGE, 'x'));
+
+    /* no secrets DB: the data is cached, even if it's too big to be stored */
+    QList<quint32> ids;
+    for (int i = 0; i < 3; i++) {
+        quint32 id = m_db->insertCredentials(info);
+        QVERIFY(id != 0);
+        QVERIFY(m_db->storeData(id, QLatin1String("Method1"),
+                                i == 1 ? tooBig : data));
+        ids.append(id);
+    }
+
+    /* the batch fails, but only the faulty item is lost */
+    QVERIFY(m_db->openSecretsDB(secretsDbFile));
+    QCOMPARE(m_db->secretsCacheStatistics().value("Entries").toInt(), 0);
+    QCOMPARE(m_db->loadData(ids[0], QLatin1String("Method1")), data);
+    QVERIFY(m_db->loadData(ids[1], QLatin1String("Method1")).isEmpty());
+    QCOMPARE(m_db->loadData(ids[2], QLatin1String("Method1")), data);
+    for (int i = 0; i < 3; i++)
+        QCOMPARE(m_db->credentials(ids[i], true).password(),
+                 QLatin1String("Pass"));
+}
+
+void TestDatabase::cacheFlushSliceTest()
+{
+    m_db->setSecretsCacheMaxSize(0);
+    /* one batch of 32 entries per slice */
+    m_db->setSecretsCacheFlushSlice(0);
+
+    SignonIdentityInfo info;
+    info.setUserName(QLatin1String("User"));
+    info.setStorePassword(true);
+
+    /* no secrets DB: the passwords are cached */
+    QList<quint32> ids;
+    for (int i = 0; i < 70; i++) {
+        info.setPassword(QString("Pass%1").arg(i));
+        quint32 id = m_db->insertCredentials(info);
+        QVERIFY(id != 0);
+        ids.append(id);
+    }
+
+    /* only the first slice is stored right away */
+    QVERIFY(m_db->openSecretsDB(secretsDbFile));
+    QCOMPARE(m_db->secretsCacheStatistics().value("Entries").toInt(), 38);
+
+    /* the DB has an outdated password for an entry which is still cached:
+     * the cache takes precedence, and overwrites it when stored */
+    QString username, password;
+    int cached = -1;
+    for (int i = 0; i < ids.count() && cached < 0; i++) {
+        if (!m_secretsStorage->loadCredentials(ids[i], username, password))
+            cached = i;
+    }
+    QVERIFY(cached >= 0);
+    QVERIFY(m_secretsStorage->updateCredentials(ids[cached], "User",
+                                                "Outdated"));
+    QCOMPARE(m_db->credentials(ids[cached], true).password(),
+             QString("Pass%1").arg(cached));
+
+    /* closing the secrets DB suspends the flush, without losing anything */
+    m_db->closeSecretsDB();
+    QTest::qWait(50);
+    QCOMPARE(m_db->secretsCacheStatistics().value("Entries").toInt(), 38);
+    QCOMPARE(m_db->credentials(ids[cached], true).password(),
+             QString("Pass%1").arg(cached));
+
+    /* the next slices are stored from the main loop */
+    QVERIFY(m_db->openSecretsDB(secretsDbFile));
+    QCOMPARE(m_db->secretsCacheStatistics().value("Entries").toInt(), 6);
+    QTest::qWait(50);
+    QCOMPARE(m_db->secretsCacheStatistics().value("Entries").toInt(), 0);
+
+    for (int i = 0; i < ids.count(); i++) {
+        QVERIFY(m_secretsStorage->loadCredentials(ids[i], username,
+                                                  password));
+        QCOMPARE(password, QString("Pass%1").arg(i));
+    }
+
+    m_db->setSecretsCacheFlushSlice(20);
+}
+
+void TestDatabase::asyncLoadTest()
+{
+    SignonIdentityInfo info;
+    info.setUserName(QLatin1String("User"));
+    info.setPassword(QLatin1String("Pass"));
+    info.setStorePassword(true);
+    info.setUserNameSecret(true);
+    quint32 id = m_db->insertCredentials(info);
+    QVERIFY(id != 0);
+
+    QVariantMap data;
+    data.insert("token", "tokenval");
+    QVERIFY(m_db->storeData(id, QLatin1String("Method1"), data));
+    info = m_db->credentials(id, false);
+    QVERIFY(info.password().isEmpty());
+
+    /* no secrets DB: the secrets come from the cache; in both cases, the
+     * reply is finished only after returning to the main loop */
+    for (int pass = 0; pass < 2; pass++) {
+        SecretsReply *reply = m_db->loadCredentialsAsync(info);
+        QSignalSpy credentialsFinished(reply, SIGNAL(finished()));
+        QVERIFY(!reply->isFinished());
+        QTest::qWait(10);
+        QCOMPARE(credentialsFinished.count(), 1);
+        QCOMPARE(reply->username(), QString("User"));
+        QCOMPARE(reply->password(), QString("Pass"));
+        delete reply;
+
+        reply = m_db->loadDataAsync(id, QLatin1String("Method1"));
+        QSignalSpy dataFinished(reply, SIGNAL(finished()));
+        QVERIFY(!reply->isFinished());
+        QTest::qWait(10);
+        QCOMPARE(dataFinished.count(), 1);
+        QCOMPARE(reply->data(), data);
+        delete reply;
+
+        /* now from the secrets DB */
+        QVERIFY(m_db->openSecretsDB(secretsDbFile));
+    }
+}
+
+void TestDatabase::backupTest()
+{
+    const QString backupFile = QLatin1String("/tmp/signon_test_backup.db");
+    QFile::remove(backupFile);
+
+    SignonIdentityInfo info;
+    info.setUserName(QLatin1String("BackupUser"));
+    info.setCaption(QLatin1String("Backup"));
+    info.setMethods(testMethods);
+    quint32 id = m_db->insertCredentials(info);
+    QVERIFY(id != 0);
+
+    if (!m_db->backupMetaDataDB(backupFile))
+        QSKIP("VACUUM INTO requires SQLite 3.27", SkipSingle);
+
+    /* The DB is still usable while and after being backed up */
+    QCOMPARE(m_db->credentials(id, false).userName(),
+             QLatin1String("BackupUser"));
+
+    {
+        MetaDataDB backup(backupFile, QLatin1String("SSO-backup-test"));
+        QVERIFY(backup.connect());
+        SignonIdentityInfo copy = backup.identity(id);
+        QCOMPARE(copy.userName(), QLatin1String("BackupUser"));
+        QCOMPARE(copy.caption(), QLatin1String("Backup"));
+        QCOMPARE(copy.methods().keys().toSet(), testMethods.keys().toSet());
+        backup.disconnect();
+    }
+    QSqlDatabase::removeDatabase(QLatin1String("SSO-backup-test"));
+
+    /* The target must not exist */
+    QVERIFY(!m_db->backupMetaDataDB(backupFile));
+    QFile::remove(backupFile);
+}
+
 void TestDatabase::accessControlListTest()
 {
     quint32 id;
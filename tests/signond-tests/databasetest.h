@@ -59,6 +59,12 @@ private Q_SLOTS:
     void dataTest();
     void referenceTest();
     void cacheTest();
+    void cacheEvictionTest();
+    void batchTest();
+    void cacheFlushFailureTest();
+    void cacheFlushSliceTest();
+    void asyncLoadTest();
+    void backupTest();
 
     void accessControlListTest();
     void credentialsOwnerSecurityTokenTest();
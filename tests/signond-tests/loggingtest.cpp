@@ -0,0 +1,159 @@
+/*
+ * This file is part of signon
+ *
+ * Copyright (C) 2013 Canonical Ltd.
+ *
+ * Contact: Alberto Mardegan <alberto.mardegan@canonical.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+#include "loggingtest.h"
+#include "signond-common.h"
+
+using namespace SignOn;
+
+static int traceCategory = GeneralCategory;
+static int evaluations = 0;
+
+#undef SIGNON_TRACE_CATEGORY
+#define SIGNON_TRACE_CATEGORY traceCategory
+
+static QString expensiveArgument()
+{
+    evaluations++;
+    return QStringList(QString(100, 'x')).join(", ");
+}
+
+void TestLogging::init()
+{
+    setLoggingLevel(2);
+    setLoggingCategories(AllCategories);
+    traceCategory = GeneralCategory;
+    evaluations = 0;
+}
+
+void TestLogging::cleanupTestCase()
+{
+    setLoggingLevel(1);
+}
+
+void TestLogging::categoryNames()
+{
+    QCOMPARE(loggingCategoryNames(AllCategories),
+             QStringList() << "general" << "db" << "plugin" << "acl" <<
+             "session");
+    QCOMPARE(loggingCategoriesFromNames(QStringList() << "db" << " acl" <<
+                                        "unknown"),
+             int(DatabaseCategory | AccessControlCategory));
+    QCOMPARE(loggingCategoriesFromNames(QStringList()), 0);
+    QCOMPARE(loggingCategoriesFromNames(loggingCategoryNames(AllCategories)),
+             int(AllCategories));
+}
+
+void TestLogging::categories()
+{
+    setLoggingCategories(DatabaseCategory | SessionCategory);
+    QCOMPARE(loggingCategories(), int(DatabaseCategory | SessionCategory));
+
+    traceCategory = DatabaseCategory;
+    TRACE() << expensiveArgument();
+    QCOMPARE(evaluations, 1);
+
+    traceCategory = PluginCategory;
+    TRACE() << expensiveArgument();
+    QCOMPARE(evaluations, 1);
+    QVERIFY(!traceEnabled(PluginCategory));
+    QVERIFY(traceEnabled(SessionCategory));
+
+    /* The logging level hides all the categories */
+    setLoggingLevel(1);
+    traceCategory = DatabaseCategory;
+    TRACE() << expensiveArgument();
+    QCOMPARE(evaluations, 1);
+    QVERIFY(!traceEnabled(DatabaseCategory));
+
+    setLoggingLevel(2);
+    TRACE() << expensiveArgument();
+    QCOMPARE(evaluations, 2);
+
+    /* Criticals don't depend on the categories */
+    setLoggingCategories(0);
+    BLAME() << expensiveArgument();
+    QCOMPARE(evaluations, 3);
+
+    setLoggingLevel(0);
+    BLAME() << expensiveArgument();
+    QCOMPARE(evaluations, 3);
+}
+
+void TestLogging::ifElse()
+{
+    setLoggingLevel(1);
+
+    bool elseTaken = false;
+    bool condition = false;
+    if (condition)
+        TRACE() << expensiveArgument();
+    else
+        elseTaken = true;
+    QVERIFY(elseTaken);
+
+    elseTaken = false;
+    condition = true;
+    if (condition)
+        TRACE() << expensiveArgument();
+    else
+        elseTaken = true;
+    QVERIFY(!elseTaken);
+    QCOMPARE(evaluations, 0);
+}
+
+void TestLogging::disabledTraceBenchmark_data()
+{
+    QTest::addColumn<bool>("traced");
+
+    QTest::newRow("no trace") << false;
+    QTest::newRow("disabled trace") << true;
+}
+
+void TestLogging::disabledTraceBenchmark()
+{
+    QFETCH(bool, traced);
+
+    /* Debug messages enabled, but not for this category */
+    setLoggingCategories(AllCategories & ~GeneralCategory);
+
+    int loops = 0;
+    if (traced) {
+        QBENCHMARK {
+            for (int i = 0; i < 10000; i++) {
+                TRACE() << expensiveArgument() << i;
+                loops++;
+            }
+        }
+    } else {
+        QBENCHMARK {
+            for (int i = 0; i < 10000; i++) {
+                loops++;
+            }
+        }
+    }
+
+    QVERIFY(loops > 0);
+    QCOMPARE(evaluations, 0);
+}
+
+QTEST_MAIN(TestLogging)
@@ -0,0 +1,128 @@
+/*
+ * This file is part of signon
+ *
+ * Copyright (C) 2013 Canonical Ltd.
+ *
+ * Contact: Alberto Mardegan <alberto.mardegan@canonical.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+#include "metadatareaderstest.h"
+#include "credentialsdb_p.h"
+#include "credentialsdbworker.h"
+#include "signonidentityinfo.cpp"
+
+#define IDENTITIES_COUNT 200
+#define READS_PER_ITERATION 2000
+
+const QString dbFile = QLatin1String("/tmp/signon_test_readers.db");
+
+namespace {
+
+class ReadTask: public CredentialsDBWorker::Task
+{
+public:
+    ReadTask(quint32 id, QAtomicInt *errors):
+        m_id(id),
+        m_errors(errors)
+    {
+    }
+
+    void run(MetaDataDB *db)
+    {
+        if (db == 0) {
+            m_errors->ref();
+            return;
+        }
+
+        SignonIdentityInfo info = db->identity(m_id);
+        db->accessControlList(m_id);
+        db->ownerList(m_id);
+        db->references(m_id);
+        if (info.id() != m_id || db->errorOccurred())
+            m_errors->ref();
+    }
+
+private:
+    quint32 m_id;
+    QAtomicInt *m_errors;
+};
+
+} // namespace
+
+void TestMetadataReaders::initTestCase()
+{
+    QFile::remove(dbFile);
+    m_db = new CredentialsDB(dbFile, 0);
+    QVERIFY(m_db->init());
+
+    QMap<QString, QStringList> methods;
+    methods.insert(QLatin1String("Method1"),
+                   QStringList() << QLatin1String("Mech1"));
+
+    for (int i = 0; i < IDENTITIES_COUNT; i++) {
+        SignonIdentityInfo info;
+        info.setUserName(QString::fromLatin1("User%1").arg(i));
+        info.setCaption(QString::fromLatin1("Caption%1").arg(i));
+        info.setMethods(methods);
+        info.setAccessControlList(QStringList() <<
+                                  QLatin1String("AID::12345678"));
+        info.setOwnerList(QStringList() << QLatin1String("AID::12345678"));
+        quint32 id = m_db->insertCredentials(info);
+        QVERIFY(id != 0);
+        m_ids.append(id);
+    }
+}
+
+void TestMetadataReaders::cleanupTestCase()
+{
+    delete m_db;
+    m_db = 0;
+    QFile::remove(dbFile);
+}
+
+void TestMetadataReaders::readThroughput_data()
+{
+    QTest::addColumn<int>("threadCount");
+
+    QList<int> counts;
+    counts << 1 << 2 << 4;
+    if (!counts.contains(QThread::idealThreadCount()))
+        counts << QThread::idealThreadCount();
+
+    foreach (int count, counts) {
+        QTest::newRow(QByteArray::number(count).constData()) << count;
+    }
+}
+
+void TestMetadataReaders::readThroughput()
+{
+    QFETCH(int, threadCount);
+
+    CredentialsDBWorker worker(dbFile, threadCount);
+    QCOMPARE(worker.threadCount(), threadCount);
+
+    QAtomicInt errors(0);
+    QBENCHMARK {
+        for (int i = 0; i < READS_PER_ITERATION; i++)
+            worker.start(new ReadTask(m_ids[i % m_ids.count()], &errors));
+        worker.waitForDone();
+    }
+
+    QCOMPARE(int(errors.fetchAndAddOrdered(0)), 0);
+}
+
+QTEST_MAIN(TestMetadataReaders)
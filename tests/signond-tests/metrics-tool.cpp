@@ -0,0 +1,162 @@
+/*
+ * This file is part of signon
+ *
+ * Copyright (C) 2013 Canonical Ltd.
+ *
+ * Contact: Alberto Mardegan <alberto.mardegan@canonical.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+/*
+ * Dumps the metrics of the running signond.
+ * With --traces, dumps the trace records of the recent requests instead;
+ * with --chrome-trace, prints them as a Chrome trace-event JSON document,
+ * which can be loaded in chrome://tracing.
+ */
+
+#include <QCoreApplication>
+#include <QDBusArgument>
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDBusVariant>
+#include <QStringList>
+#include <QTextStream>
+
+#include "signoncommon.h"
+
+#define SIGNOND_METRICS_INTERFACE \
+    SIGNOND_STRING(SIGNOND_SERVICE_PREFIX ".Metrics")
+
+static void dump(QTextStream &out, const QVariant &value, int indent);
+
+static QVariant demarshall(const QDBusArgument &argument)
+{
+    switch (argument.currentType()) {
+    case QDBusArgument::MapType: {
+        QVariantMap map;
+        argument.beginMap();
+        while (!argument.atEnd()) {
+            QString key;
+            QDBusVariant value;
+            argument.beginMapEntry();
+            argument >> key >> value;
+            argument.endMapEntry();
+            map.insert(key, value.variant());
+        }
+        argument.endMap();
+        return map;
+    }
+    case QDBusArgument::ArrayType: {
+        QVariantList list;
+        argument.beginArray();
+        while (!argument.atEnd()) {
+            QDBusVariant value;
+            argument >> value;
+            list.append(value.variant());
+        }
+        argument.endArray();
+        return list;
+    }
+    default:
+        return argument.asVariant();
+    }
+}
+
+static void dumpList(QTextStream &out, const QVariantList &list, int indent)
+{
+    bool isFlat = true;
+    foreach (const QVariant &item, list) {
+        if (item.userType() == qMetaTypeId<QDBusArgument>() ||
+            item.type() == QVariant::Map) {
+            isFlat = false;
+            break;
+        }
+    }
+
+    if (isFlat) {
+        QStringList items;
+        foreach (const QVariant &item, list)
+            items.append(item.toString());
+        out << "[" << items.join(", ") << "]\n";
+        return;
+    }
+
+    out << "\n";
+    for (int i = 0; i < list.count(); i++) {
+        out << QString(indent, ' ') << "- " << i << ":";
+        dump(out, list[i], indent + 4);
+    }
+}
+
+static void dump(QTextStream &out, const QVariant &value, int indent)
+{
+    QVariant v = value;
+    if (v.userType() == qMetaTypeId<QDBusArgument>())
+        v = demarshall(v.value<QDBusArgument>());
+
+    if (v.type() == QVariant::Map) {
+        QVariantMap map = v.toMap();
+        out << "\n";
+        QVariantMap::const_iterator i;
+        for (i = map.constBegin(); i != map.constEnd(); i++) {
+            out << QString(indent, ' ') << i.key() << ":";
+            dump(out, i.value(), indent + 2);
+        }
+    } else if (v.type() == QVariant::List) {
+        dumpList(out, v.toList(), indent);
+    } else {
+        out << " " << v.toString() << "\n";
+    }
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+
+    QString method("metrics");
+    QString title("signond metrics:");
+    QStringList args = app.arguments();
+    if (args.contains("--traces")) {
+        method = "requestTraces";
+        title = "signond request traces:";
+    } else if (args.contains("--chrome-trace")) {
+        method = "chromeTrace";
+        title.clear();
+    }
+
+    QDBusMessage msg =
+        QDBusMessage::createMethodCall(SIGNOND_SERVICE,
+                                       SIGNOND_DAEMON_OBJECTPATH,
+                                       SIGNOND_METRICS_INTERFACE,
+                                       method);
+    QDBusMessage reply = QDBusConnection::sessionBus().call(msg);
+    if (reply.type() != QDBusMessage::ReplyMessage ||
+        reply.arguments().isEmpty()) {
+        out << "Call failed: " << reply.errorName() << " " <<
+            reply.errorMessage() << "\n";
+        return 1;
+    }
+
+    if (title.isEmpty()) {
+        out << reply.arguments().first().toString();
+        return 0;
+    }
+
+    out << title;
+    dump(out, reply.arguments().first(), 2);
+    return 0;
+}
@@ -0,0 +1,13 @@
+include(../../common-project-config.pri)
+
+TEMPLATE = app
+TARGET = metrics-tool
+
+QT += core dbus
+QT -= gui
+
+INCLUDEPATH += \
+    $${TOP_SRC_DIR}/lib/signond
+
+SOURCES = \
+    metrics-tool.cpp
@@ -0,0 +1,266 @@
+/*
+ * This file is part of signon
+ *
+ * Copyright (C) 2013 Canonical Ltd.
+ *
+ * Contact: Alberto Mardegan <alberto.mardegan@canonical.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+
+#include "metricstest.h"
+#include "requesttracer.h"
+#include "signonmetrics.h"
+
+#include <QThreadPool>
+#include <climits>
+
+using namespace SignonDaemonNS;
+
+void TestMetrics::histogramBuckets_data()
+{
+    QTest::addColumn<qint64>("usecs");
+    QTest::addColumn<int>("bucket");
+
+    QTest::newRow("negative") << qint64(-5) << 0;
+    QTest::newRow("zero") << qint64(0) << 0;
+    QTest::newRow("bound") << qint64(100) << 0;
+    QTest::newRow("above bound") << qint64(101) << 1;
+    QTest::newRow("1 ms") << qint64(1000) << 3;
+    QTest::newRow("10 s") << qint64(10000000) << 15;
+    QTest::newRow("overflow") << qint64(10000001) << 16;
+    QTest::newRow("huge") << (qint64(1) << 40) << 16;
+}
+
+void TestMetrics::histogramBuckets()
+{
+    QFETCH(qint64, usecs);
+    QFETCH(int, bucket);
+
+    QCOMPARE(MetricsHistogram::bucketOf(usecs), bucket);
+
+    MetricsHistogram histogram;
+    histogram.add(usecs);
+    QCOMPARE(histogram.count(), 1);
+    QCOMPARE(histogram.bucketCount(bucket), 1);
+
+    QVariantMap map = histogram.toMap();
+    QCOMPARE(map.value("Count").toInt(), 1);
+    QCOMPARE(map.value("Max").toLongLong(),
+             qBound(qint64(0), usecs, qint64(INT_MAX)));
+    QCOMPARE(map.value("Buckets").toList().count(),
+             map.value("Bounds").toList().count() + 1);
+}
+
+class AddTask: public QRunnable
+{
+public:
+    AddTask(MetricsHistogram *histogram): m_histogram(histogram) {}
+    void run() {
+        for (int i = 0; i < 1000; i++)
+            m_histogram->add(i);
+    }
+
+private:
+    MetricsHistogram *m_histogram;
+};
+
+void TestMetrics::histogramConcurrency()
+{
+    MetricsHistogram histogram;
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(4);
+    for (int i = 0; i < 8; i++)
+        pool.start(new AddTask(&histogram));
+    pool.waitForDone();
+
+    QCOMPARE(histogram.count(), 8000);
+    QCOMPARE(histogram.toMap().value("Max").toInt(), 999);
+
+    int total = 0;
+    QVariantList buckets = histogram.toMap().value("Buckets").toList();
+    foreach (const QVariant &bucket, buckets)
+        total += bucket.toInt();
+    QCOMPARE(total, 8000);
+}
+
+void TestMetrics::counters()
+{
+    SignonMetrics metrics;
+
+    metrics.processCompleted("password", 2000);
+    metrics.processCompleted("password", 3000);
+    metrics.processCompleted("oauth2", 500);
+    metrics.pluginStarted(40000);
+    metrics.pluginStartFailed();
+    metrics.statementExecuted(50, true);
+    metrics.statementExecuted(70, false);
+    metrics.aclChecked(SignonMetrics::IdentityAccessCheck);
+    metrics.aclChecked(SignonMetrics::IdentityAccessCheck);
+    metrics.aclChecked(SignonMetrics::KeychainWidgetCheck);
+    metrics.credentialsLoaded();
+
+    QVariantMap map = metrics.toMap();
+
+    QVariantMap process = map.value("ProcessLatency").toMap();
+    QCOMPARE(process.count(), 2);
+    QCOMPARE(process.value("password").toMap().value("Count").toInt(), 2);
+    QCOMPARE(process.value("password").toMap().value("Max").toInt(), 3000);
+    QCOMPARE(process.value("oauth2").toMap().value("Count").toInt(), 1);
+
+    QVariantMap plugins = map.value("Plugins").toMap();
+    QCOMPARE(plugins.value("Spawns").toInt(), 1);
+    QCOMPARE(plugins.value("SpawnFailures").toInt(), 1);
+
+    QVariantMap statements = map.value("DBStatements").toMap();
+    QCOMPARE(statements.value("Count").toInt(), 2);
+    QCOMPARE(statements.value("Failures").toInt(), 1);
+
+    QVariantMap acl = map.value("AclChecks").toMap();
+    QCOMPARE(acl.value("IdentityAccess").toInt(), 2);
+    QCOMPARE(acl.value("Ownership").toInt(), 0);
+    QCOMPARE(acl.value("KeychainWidget").toInt(), 1);
+
+    QCOMPARE(map.value("CredentialsLoads").toInt(), 1);
+}
+
+void TestMetrics::traceRecords()
+{
+    RequestTracer tracer;
+
+    tracer.begin(1, "key1", "password", "password");
+    tracer.begin(2, "key2", "oauth2", "user_agent");
+    qint64 started = RequestTracer::timestamp();
+    tracer.mark(1, "started", started);
+    /* stages reported by the plugin are sorted by time */
+    tracer.mark(1, "plugin-received", started + 2);
+    tracer.mark(1, "plugin-called", started + 1);
+    tracer.mark(100, "started");
+    QVERIFY(tracer.records().isEmpty());
+    QTest::qSleep(1);
+
+    tracer.end(1, "done");
+    tracer.end(1, "done");
+
+    QVariantList records = tracer.records();
+    QCOMPARE(records.count(), 1);
+
+    QVariantMap record = records.first().toMap();
+    QCOMPARE(record.value("Key").toString(), QString("key1"));
+    QCOMPARE(record.value("Method").toString(), QString("password"));
+    QCOMPARE(record.value("Mechanism").toString(), QString("password"));
+    QCOMPARE(record.value("Status").toString(), QString("done"));
+
+    QStringList names;
+    qint64 lastTime = 0;
+    foreach (const QVariant &stage, record.value("Stages").toList()) {
+        QVariantMap map = stage.toMap();
+        names.append(map.value("Name").toString());
+        QVERIFY(map.value("Time").toLongLong() >= lastTime);
+        lastTime = map.value("Time").toLongLong();
+    }
+    QCOMPARE(names, QStringList() << "queued" << "started" <<
+             "plugin-called" << "plugin-received" << "replied");
+
+    tracer.end(2, "canceled");
+    QCOMPARE(tracer.records().count(), 2);
+    QCOMPARE(tracer.records().last().toMap().value("Status").toString(),
+             QString("canceled"));
+}
+
+void TestMetrics::tracePipelined()
+{
+    RequestTracer tracer;
+
+    /* The requests of one AuthSession share the same cancel key */
+    tracer.begin(1, "session", "password", "password");
+    tracer.mark(1, "started");
+    tracer.begin(2, "session", "password", "password");
+    tracer.end(1, "done");
+    tracer.mark(2, "started");
+    tracer.end(2, "canceled");
+
+    QVariantList records = tracer.records();
+    QCOMPARE(records.count(), 2);
+
+    QVariantMap first = records[0].toMap();
+    QCOMPARE(first.value("Key").toString(), QString("session"));
+    QCOMPARE(first.value("Status").toString(), QString("done"));
+    QCOMPARE(first.value("Stages").toList().count(), 3);
+
+    QVariantMap second = records[1].toMap();
+    QCOMPARE(second.value("Status").toString(), QString("canceled"));
+    QCOMPARE(second.value("Stages").toList().count(), 3);
+}
+
+void TestMetrics::traceRingBuffer()
+{
+    RequestTracer tracer(3);
+
+    for (int i = 0; i < 5; i++) {
+        tracer.begin(i, QString::number(i), "password", "password");
+        tracer.end(i, "done");
+    }
+
+    QVariantList records = tracer.records();
+    QCOMPARE(records.count(), 3);
+    QCOMPARE(records[0].toMap().value("Key").toString(), QString("2"));
+    QCOMPARE(records[2].toMap().value("Key").toString(), QString("4"));
+
+    tracer.setCapacity(2);
+    records = tracer.records();
+    QCOMPARE(records.count(), 2);
+    QCOMPARE(records[0].toMap().value("Key").toString(), QString("3"));
+    QCOMPARE(records[1].toMap().value("Key").toString(), QString("4"));
+
+    /* requests which are never completed don't pile up: the oldest ones
+     * are dropped */
+    for (int i = 10; i < 20; i++)
+        tracer.begin(i, QString("pending%1").arg(i), "password", "password");
+    tracer.end(17, "done");
+    QCOMPARE(tracer.records().last().toMap().value("Key").toString(),
+             QString("pending4"));
+    tracer.end(19, "done");
+    QCOMPARE(tracer.records().last().toMap().value("Key").toString(),
+             QString("pending19"));
+    tracer.end(18, "done");
+    QCOMPARE(tracer.records().last().toMap().value("Key").toString(),
+             QString("pending18"));
+}
+
+void TestMetrics::chromeTrace()
+{
+    RequestTracer tracer;
+    QCOMPARE(tracer.toChromeTrace(),
+             QByteArray("{\"traceEvents\":[],\"displayTimeUnit\":\"ms\"}\n"));
+
+    tracer.begin(1, "key\"1", "password", "pass\\word");
+    tracer.mark(1, "started");
+    tracer.end(1, "done");
+
+    QByteArray json = tracer.toChromeTrace();
+    QVERIFY(json.startsWith("{\"traceEvents\":[{"));
+    QVERIFY(json.contains("\"name\":\"password/pass\\\\word\""));
+    QVERIFY(json.contains("\"key\":\"key\\\"1\""));
+    QVERIFY(json.contains("\"name\":\"queued\",\"cat\":\"stage\""));
+    QVERIFY(json.contains("\"name\":\"started\",\"cat\":\"stage\""));
+    /* the last stage has no duration */
+    QVERIFY(!json.contains("\"name\":\"replied\""));
+    QCOMPARE(json.count("\"ph\":\"X\""), 3);
+}
+
+QTEST_MAIN(TestMetrics)
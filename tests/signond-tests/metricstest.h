@@ -0,0 +1,45 @@
+/*
+ * This file is part of signon
+ *
+ * Copyright (C) 2013 Canonical Ltd.
+ *
+ * Contact: Alberto Mardegan <alberto.mardegan@canonical.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+
+#ifndef METRICSTEST_H
+#define METRICSTEST_H
+
+#include <QtTest/QtTest>
+#include <QtCore>
+
+class TestMetrics: public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void histogramBuckets_data();
+    void histogramBuckets();
+    void histogramConcurrency();
+    void counters();
+    void traceRecords();
+    void tracePipelined();
+    void traceRingBuffer();
+    void chromeTrace();
+};
+
+#endif // METRICSTEST_H
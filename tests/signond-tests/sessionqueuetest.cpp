@@ -0,0 +1,259 @@
+/*
+ * This file is part of signon
+ *
+ * Copyright (C) 2012 Canonical Ltd.
+ *
+ * Contact: Alberto Mardegan <alberto.mardegan@canonical.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+#include "sessionqueuetest.h"
+
+#include <QDBusArgument>
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDBusObjectPath>
+#include <QDBusPendingCall>
+#include <QDebug>
+
+#include "signond/signoncommon.h"
+
+/* The ssotest plugin takes about one second to process a request */
+#define PIPELINED_REQUESTS 3
+
+#define SIGNOND_METRICS_INTERFACE \
+    QLatin1String("com.google.code.AccountsSSO.SingleSignOn.Metrics")
+
+QString SessionQueueTest::authSessionPath(quint32 id, const QString &method)
+{
+    QDBusConnection conn = SIGNOND_BUS;
+
+    QDBusMessage msg = QDBusMessage::createMethodCall(SIGNOND_SERVICE,
+                                                      SIGNOND_DAEMON_OBJECTPATH,
+                                                      SIGNOND_DAEMON_INTERFACE,
+                                                      "getAuthSessionObjectPath");
+    msg << id << method;
+
+    QDBusMessage reply = conn.call(msg);
+    if (reply.type() != QDBusMessage::ReplyMessage)
+        return QString();
+
+    return reply.arguments()[0].value<QDBusObjectPath>().path();
+}
+
+quint32 SessionQueueTest::storeIdentity()
+{
+    QDBusConnection conn = SIGNOND_BUS;
+
+    QDBusMessage msg = QDBusMessage::createMethodCall(SIGNOND_SERVICE,
+                                                      SIGNOND_DAEMON_OBJECTPATH,
+                                                      SIGNOND_DAEMON_INTERFACE,
+                                                      "registerNewIdentity");
+    QDBusMessage reply = conn.call(msg);
+    if (reply.type() != QDBusMessage::ReplyMessage)
+        return 0;
+    QString path = reply.arguments()[0].value<QDBusObjectPath>().path();
+
+    QVariantMap info;
+    info.insert(SIGNOND_IDENTITY_INFO_CAPTION, QString("queue test"));
+    info.insert(SIGNOND_IDENTITY_INFO_USERNAME, QString("user"));
+    info.insert(SIGNOND_IDENTITY_INFO_SECRET, QString("secret"));
+    info.insert(SIGNOND_IDENTITY_INFO_STORESECRET, true);
+    info.insert(SIGNOND_IDENTITY_INFO_ACL, QStringList() << "*");
+
+    msg = QDBusMessage::createMethodCall(SIGNOND_SERVICE, path,
+                                         SIGNOND_IDENTITY_INTERFACE,
+                                         "store");
+    msg << info;
+    reply = conn.call(msg);
+    if (reply.type() != QDBusMessage::ReplyMessage)
+        return 0;
+
+    return reply.arguments()[0].toUInt();
+}
+
+QVariantMap SessionQueueTest::metrics()
+{
+    QDBusMessage msg =
+        QDBusMessage::createMethodCall(SIGNOND_SERVICE,
+                                       SIGNOND_DAEMON_OBJECTPATH,
+                                       SIGNOND_METRICS_INTERFACE,
+                                       "metrics");
+    QDBusMessage reply = SIGNOND_BUS.call(msg);
+    if (reply.type() != QDBusMessage::ReplyMessage)
+        return QVariantMap();
+
+    return qdbus_cast<QVariantMap>(reply.arguments()[0]);
+}
+
+void SessionQueueTest::cancelPipelined()
+{
+    QDBusConnection conn = SIGNOND_BUS;
+
+    QString path = authSessionPath(0, "ssotest");
+    QVERIFY(!path.isEmpty());
+
+    QDBusMessage process =
+        QDBusMessage::createMethodCall(SIGNOND_SERVICE, path,
+                                       SIGNOND_AUTH_SESSION_INTERFACE,
+                                       "process");
+    process << QVariantMap() << QString("mech1");
+
+    QList<QDBusPendingCall> calls;
+    for (int i = 0; i < PIPELINED_REQUESTS; i++)
+        calls.append(conn.asyncCall(process));
+
+    /* Let the first request reach the plugin */
+    QTest::qWait(300);
+
+    /* Like AuthSessionImpl::cancel(), send one cancel per request: all of
+     * them share the same cancel key */
+    QDBusMessage cancel =
+        QDBusMessage::createMethodCall(SIGNOND_SERVICE, path,
+                                       SIGNOND_AUTH_SESSION_INTERFACE,
+                                       "cancel");
+    for (int i = 0; i < PIPELINED_REQUESTS; i++)
+        QVERIFY(conn.send(cancel));
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < PIPELINED_REQUESTS; i++) {
+        QDBusPendingCall call = calls[i];
+        call.waitForFinished();
+        QVERIFY(call.isError());
+        QCOMPARE(call.error().name(),
+                 QString(SIGNOND_SESSION_CANCELED_ERR_NAME));
+    }
+    /* None of them must have waited for the D-Bus timeout */
+    QVERIFY(timer.elapsed() < 5000);
+
+    /* The session must still serve new requests */
+    QDBusMessage reply = conn.call(process);
+    QCOMPARE(reply.type(), QDBusMessage::ReplyMessage);
+}
+
+void SessionQueueTest::cancelThenQueue()
+{
+    QDBusConnection conn = SIGNOND_BUS;
+
+    QString path = authSessionPath(0, "ssotest");
+    QVERIFY(!path.isEmpty());
+
+    QDBusMessage process =
+        QDBusMessage::createMethodCall(SIGNOND_SERVICE, path,
+                                       SIGNOND_AUTH_SESSION_INTERFACE,
+                                       "process");
+    process << QVariantMap() << QString("mech1");
+
+    QDBusPendingCall first = conn.asyncCall(process);
+    QDBusPendingCall second = conn.asyncCall(process);
+
+    /* Let the first request reach the plugin */
+    QTest::qWait(300);
+
+    /* Cancel the active request only, and queue another one before the
+     * plugin has replied to the cancelation */
+    QDBusMessage cancel =
+        QDBusMessage::createMethodCall(SIGNOND_SERVICE, path,
+                                       SIGNOND_AUTH_SESSION_INTERFACE,
+                                       "cancel");
+    QVERIFY(conn.send(cancel));
+    QDBusPendingCall third = conn.asyncCall(process);
+
+    first.waitForFinished();
+    QVERIFY(first.isError());
+    QCOMPARE(first.error().name(),
+             QString(SIGNOND_SESSION_CANCELED_ERR_NAME));
+
+    second.waitForFinished();
+    QVERIFY(!second.isError());
+    third.waitForFinished();
+    QVERIFY(!third.isError());
+}
+
+void SessionQueueTest::snapshotReused()
+{
+    QDBusConnection conn = SIGNOND_BUS;
+
+    quint32 id = storeIdentity();
+    QVERIFY(id != 0);
+    QString path = authSessionPath(id, "ssotest");
+    QVERIFY(!path.isEmpty());
+
+    QVariantMap before = metrics();
+    QVERIFY(before.contains("CredentialsLoads"));
+
+    QDBusMessage process =
+        QDBusMessage::createMethodCall(SIGNOND_SERVICE, path,
+                                       SIGNOND_AUTH_SESSION_INTERFACE,
+                                       "process");
+    process << QVariantMap() << QString("mech1");
+
+    QList<QDBusPendingCall> calls;
+    for (int i = 0; i < PIPELINED_REQUESTS; i++)
+        calls.append(conn.asyncCall(process));
+
+    for (int i = 0; i < PIPELINED_REQUESTS; i++) {
+        QDBusPendingCall call = calls[i];
+        call.waitForFinished();
+        QVERIFY(!call.isError());
+    }
+
+    /* The credentials are read for the first request only: storing them
+     * as validated updates the snapshot, and later results store nothing */
+    QVariantMap after = metrics();
+    QCOMPARE(after.value("CredentialsLoads").toInt() -
+             before.value("CredentialsLoads").toInt(), 1);
+}
+
+void SessionQueueTest::aclCacheHits()
+{
+    QDBusConnection conn = SIGNOND_BUS;
+
+    quint32 id = storeIdentity();
+    QVERIFY(id != 0);
+    QString path = authSessionPath(id, "ssotest");
+    QVERIFY(!path.isEmpty());
+
+    QDBusMessage process =
+        QDBusMessage::createMethodCall(SIGNOND_SERVICE, path,
+                                       SIGNOND_AUTH_SESSION_INTERFACE,
+                                       "process");
+    process << QVariantMap() << QString("mech1");
+
+    /* The first result marks the credentials as validated */
+    QDBusMessage reply = conn.call(process);
+    QCOMPARE(reply.type(), QDBusMessage::ReplyMessage);
+
+    QVariantMap before =
+        qdbus_cast<QVariantMap>(metrics().value("AclCache"));
+    QVERIFY(before.contains("Hits"));
+
+    for (int i = 0; i < PIPELINED_REQUESTS; i++) {
+        reply = conn.call(process);
+        QCOMPARE(reply.type(), QDBusMessage::ReplyMessage);
+    }
+
+    /* Storing the results doesn't expire the access decisions */
+    QVariantMap after =
+        qdbus_cast<QVariantMap>(metrics().value("AclCache"));
+    QCOMPARE(after.value("Misses").toULongLong(),
+             before.value("Misses").toULongLong());
+    QVERIFY(after.value("Hits").toULongLong() >=
+            before.value("Hits").toULongLong() + PIPELINED_REQUESTS);
+}
+
+QTEST_MAIN(SessionQueueTest)
@@ -0,0 +1,45 @@
+/*
+ * This file is part of signon
+ *
+ * Copyright (C) 2012 Canonical Ltd.
+ *
+ * Contact: Alberto Mardegan <alberto.mardegan@canonical.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+#ifndef SESSIONQUEUE_TEST_H
+#define SESSIONQUEUE_TEST_H
+
+#include <QtTest/QtTest>
+#include <QtCore>
+
+class SessionQueueTest: public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void cancelPipelined();
+    void cancelThenQueue();
+    void snapshotReused();
+    void aclCacheHits();
+
+private:
+    QString authSessionPath(quint32 id, const QString &method);
+    quint32 storeIdentity();
+    QVariantMap metrics();
+};
+
+#endif // SESSIONQUEUE_TEST_H
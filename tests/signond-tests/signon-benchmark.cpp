@@ -0,0 +1,619 @@
+/*
+ * This file is part of signon
+ *
+ * Copyright (C) 2013 Canonical Ltd.
+ *
+ * Contact: Alberto Mardegan <alberto.mardegan@canonical.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+/*
+ * End-to-end benchmark of signond, driven through libsignon-qt.
+ * Each workload is run by several concurrent clients, and the latency
+ * percentiles and the throughput of its operations are printed as JSON.
+ * Run it in a private session bus, with "make benchmark" or through
+ * tests/run-with-signond.sh.
+ */
+
+#include "signon-benchmark.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QFile>
+#include <QTextStream>
+#include <QtAlgorithms>
+
+using namespace SignOn;
+
+static qint64 percentile(const QList<qint64> &sorted, int percent)
+{
+    int index = (sorted.count() - 1) * percent / 100;
+    return sorted[index];
+}
+
+static QString toJson(const QVariant &value, int indent = 0)
+{
+    QString spaces(indent, ' ');
+    switch (value.type()) {
+    case QVariant::Map: {
+        QVariantMap map = value.toMap();
+        if (map.isEmpty()) return "{}";
+        QStringList items;
+        QVariantMap::const_iterator i;
+        for (i = map.constBegin(); i != map.constEnd(); i++) {
+            items.append(spaces + "  " + toJson(i.key()) + ": " +
+                         toJson(i.value(), indent + 2));
+        }
+        return "{\n" + items.join(",\n") + "\n" + spaces + "}";
+    }
+    case QVariant::List: {
+        QStringList items;
+        foreach (const QVariant &item, value.toList())
+            items.append(toJson(item, indent));
+        return "[" + items.join(", ") + "]";
+    }
+    case QVariant::Bool:
+        return value.toBool() ? "true" : "false";
+    case QVariant::Int:
+    case QVariant::UInt:
+    case QVariant::LongLong:
+    case QVariant::ULongLong:
+    case QVariant::Double:
+        return value.toString();
+    default: {
+        QString string = value.toString();
+        string.replace("\\", "\\\\");
+        string.replace("\"", "\\\"");
+        return "\"" + string + "\"";
+    }
+    }
+}
+
+void LatencyRecorder::add(const QString &operation, qint64 usecs)
+{
+    m_samples[operation].append(usecs);
+}
+
+void LatencyRecorder::addError(const QString &operation)
+{
+    m_errors[operation]++;
+}
+
+QVariantMap LatencyRecorder::toMap(qint64 wallUsecs) const
+{
+    QStringList operations = m_samples.keys() + m_errors.keys();
+    operations.removeDuplicates();
+
+    QVariantMap map;
+    foreach (const QString &operation, operations) {
+        QList<qint64> samples = m_samples.value(operation);
+        qSort(samples);
+
+        QVariantMap stats;
+        stats.insert("count", samples.count());
+        stats.insert("errors", m_errors.value(operation));
+        if (!samples.isEmpty()) {
+            stats.insert("p50_ms", percentile(samples, 50) / 1000.0);
+            stats.insert("p95_ms", percentile(samples, 95) / 1000.0);
+            stats.insert("p99_ms", percentile(samples, 99) / 1000.0);
+            stats.insert("max_ms", samples.last() / 1000.0);
+        }
+        if (wallUsecs > 0) {
+            stats.insert("ops_per_sec",
+                         samples.count() * 1000000.0 / wallUsecs);
+        }
+        map.insert(operation, stats);
+    }
+    return map;
+}
+
+BenchmarkClient::BenchmarkClient(LatencyRecorder *recorder, int iterations,
+                                 QObject *parent):
+    QObject(parent),
+    m_identity(0),
+    m_recorder(recorder),
+    m_iterations(iterations),
+    m_done(0)
+{
+}
+
+BenchmarkClient::~BenchmarkClient()
+{
+}
+
+void BenchmarkClient::setUp()
+{
+    emit ready();
+}
+
+void BenchmarkClient::run()
+{
+    m_done = 0;
+    QMetaObject::invokeMethod(this, "nextIteration", Qt::QueuedConnection);
+}
+
+void BenchmarkClient::nextIteration()
+{
+    startIteration();
+}
+
+void BenchmarkClient::beginStep(const QString &operation)
+{
+    m_operation = operation;
+    m_timer.start();
+}
+
+void BenchmarkClient::endStep(bool ok)
+{
+    if (ok)
+        m_recorder->add(m_operation, m_timer.nsecsElapsed() / 1000);
+    else
+        m_recorder->addError(m_operation);
+}
+
+void BenchmarkClient::iterationDone()
+{
+    m_done++;
+    if (m_done >= m_iterations) {
+        emit finished();
+        return;
+    }
+
+    /* Don't recurse if the operation completed synchronously */
+    QMetaObject::invokeMethod(this, "nextIteration", Qt::QueuedConnection);
+}
+
+void BenchmarkClient::createIdentity(const QString &method)
+{
+    IdentityInfo info;
+    info.setCaption("signon-benchmark");
+    info.setUserName("user");
+    info.setSecret("secret");
+    info.setMethod(method, QStringList() << "*");
+    info.setAccessControlList(QStringList() << "*");
+
+    m_identity = Identity::newIdentity(info, this);
+    connect(m_identity, SIGNAL(credentialsStored(const quint32)),
+            this, SLOT(onCredentialsStored(const quint32)));
+    connect(m_identity, SIGNAL(error(const SignOn::Error &)),
+            this, SLOT(onSetUpError(const SignOn::Error &)));
+    m_identity->storeCredentials();
+}
+
+void BenchmarkClient::identityReady()
+{
+    emit ready();
+}
+
+void BenchmarkClient::onCredentialsStored(const quint32 id)
+{
+    Q_UNUSED(id);
+    m_identity->disconnect(this);
+    identityReady();
+}
+
+void BenchmarkClient::onSetUpError(const SignOn::Error &err)
+{
+    qWarning() << "Setup failed:" << err.message();
+    m_identity->disconnect(this);
+    identityReady();
+}
+
+IdentityClient::IdentityClient(LatencyRecorder *recorder, int iterations,
+                               QObject *parent):
+    BenchmarkClient(recorder, iterations, parent)
+{
+}
+
+void IdentityClient::startIteration()
+{
+    IdentityInfo info;
+    info.setCaption("signon-benchmark");
+    info.setUserName("user");
+    info.setSecret("secret");
+    info.setMethod("password", QStringList() << "password");
+
+    m_identity = Identity::newIdentity(info, this);
+    connect(m_identity, SIGNAL(credentialsStored(const quint32)),
+            this, SLOT(onStored(const quint32)));
+    connect(m_identity, SIGNAL(info(const SignOn::IdentityInfo &)),
+            this, SLOT(onInfo(const SignOn::IdentityInfo &)));
+    connect(m_identity, SIGNAL(removed()),
+            this, SLOT(onRemoved()));
+    connect(m_identity, SIGNAL(error(const SignOn::Error &)),
+            this, SLOT(onError(const SignOn::Error &)));
+
+    beginStep("store");
+    m_identity->storeCredentials();
+}
+
+void IdentityClient::onStored(const quint32 id)
+{
+    Q_UNUSED(id);
+    endStep(true);
+    beginStep("query");
+    m_identity->queryInfo();
+}
+
+void IdentityClient::onInfo(const SignOn::IdentityInfo &info)
+{
+    Q_UNUSED(info);
+    endStep(true);
+    beginStep("remove");
+    m_identity->remove();
+}
+
+void IdentityClient::onRemoved()
+{
+    endStep(true);
+    m_identity->deleteLater();
+    m_identity = 0;
+    iterationDone();
+}
+
+void IdentityClient::onError(const SignOn::Error &err)
+{
+    qWarning() << "Identity error:" << err.message();
+    endStep(false);
+    m_identity->deleteLater();
+    m_identity = 0;
+    iterationDone();
+}
+
+ProcessClient::ProcessClient(LatencyRecorder *recorder, int iterations,
+                             const QString &method, const QString &mechanism,
+                             const QString &operation,
+                             const QVariantMap &parameters,
+                             QObject *parent):
+    BenchmarkClient(recorder, iterations, parent),
+    m_method(method),
+    m_mechanism(mechanism),
+    m_operationName(operation),
+    m_parameters(parameters)
+{
+}
+
+void ProcessClient::setUp()
+{
+    createIdentity(m_method);
+}
+
+void ProcessClient::identityReady()
+{
+    m_session = m_identity->createSession(m_method);
+    if (!m_session.isNull()) {
+        connect(m_session, SIGNAL(response(const SignOn::SessionData &)),
+                this, SLOT(onResponse(const SignOn::SessionData &)));
+        connect(m_session, SIGNAL(error(const SignOn::Error &)),
+                this, SLOT(onError(const SignOn::Error &)));
+    }
+    emit ready();
+}
+
+void ProcessClient::startIteration()
+{
+    beginStep(m_operationName);
+    if (m_session.isNull()) {
+        endStep(false);
+        iterationDone();
+        return;
+    }
+
+    SessionData data(m_parameters);
+    data.setUserName("user");
+    data.setSecret("secret");
+    m_session->process(data, m_mechanism);
+}
+
+void ProcessClient::onResponse(const SignOn::SessionData &data)
+{
+    Q_UNUSED(data);
+    endStep(true);
+    iterationDone();
+}
+
+void ProcessClient::onError(const SignOn::Error &err)
+{
+    qWarning() << m_method << "error:" << err.message();
+    endStep(false);
+    iterationDone();
+}
+
+QueryClient::QueryClient(LatencyRecorder *recorder, int iterations,
+                         int identityCount, QObject *parent):
+    BenchmarkClient(recorder, iterations, parent),
+    m_identityCount(identityCount),
+    m_service(new AuthService(this))
+{
+    connect(m_service,
+            SIGNAL(identities(const QList<SignOn::IdentityInfo> &)),
+            this,
+            SLOT(onIdentities(const QList<SignOn::IdentityInfo> &)));
+    connect(m_service, SIGNAL(error(const SignOn::Error &)),
+            this, SLOT(onError(const SignOn::Error &)));
+}
+
+void QueryClient::setUp()
+{
+    if (m_identityCount > 0)
+        createIdentity("password");
+    else
+        emit ready();
+}
+
+void QueryClient::identityReady()
+{
+    m_identities.append(m_identity);
+    if (m_identities.count() < m_identityCount)
+        createIdentity("password");
+    else
+        emit ready();
+}
+
+void QueryClient::startIteration()
+{
+    beginStep("queryIdentities");
+    m_service->queryIdentities();
+}
+
+void QueryClient::onIdentities(const QList<SignOn::IdentityInfo> &identities)
+{
+    Q_UNUSED(identities);
+    endStep(true);
+    iterationDone();
+}
+
+void QueryClient::onError(const SignOn::Error &err)
+{
+    qWarning() << "Query error:" << err.message();
+    endStep(false);
+    iterationDone();
+}
+
+Benchmark::Benchmark(const QStringList &workloads, int concurrency,
+                     int iterations, int identityCount, int payloadSize,
+                     int signalCount, const QString &outputFile):
+    QObject(),
+    m_workloads(workloads),
+    m_concurrency(qMax(concurrency, 1)),
+    m_iterations(qMax(iterations, 1)),
+    m_identityCount(identityCount),
+    m_payloadSize(payloadSize),
+    m_signalCount(signalCount),
+    m_outputFile(outputFile),
+    m_current(0),
+    m_pending(0),
+    m_recorder(0)
+{
+}
+
+Benchmark::~Benchmark()
+{
+    delete m_recorder;
+}
+
+QStringList Benchmark::availableWorkloads()
+{
+    return QStringList() << "identity" << "query" << "process-ssotest" <<
+        "process-password" << "blob" << "bench-noop" << "bench-echo" <<
+        "bench-status" << "bench-store";
+}
+
+BenchmarkClient *Benchmark::createClient(const QString &workload)
+{
+    if (workload == "identity")
+        return new IdentityClient(m_recorder, m_iterations, this);
+    if (workload == "query") {
+        int count = (m_identityCount + m_concurrency - 1) / m_concurrency;
+        return new QueryClient(m_recorder, m_iterations, count, this);
+    }
+    if (workload == "process-ssotest")
+        return new ProcessClient(m_recorder, m_iterations,
+                                 "ssotest", "mech1", "process",
+                                 QVariantMap(), this);
+    if (workload == "process-password")
+        return new ProcessClient(m_recorder, m_iterations,
+                                 "password", "password", "process",
+                                 QVariantMap(), this);
+    if (workload == "blob") {
+        /* The example plugin stores its data on every request; the data is
+         * then loaded by the next request */
+        return new ProcessClient(m_recorder, m_iterations,
+                                 "example", "default", "store-load",
+                                 QVariantMap(), this);
+    }
+
+    /* The bench plugin replies right away: these workloads measure the
+     * overhead of the daemon and of the plugin IPC */
+    QVariantMap parameters;
+    if (workload == "bench-noop")
+        return new ProcessClient(m_recorder, m_iterations,
+                                 "bench", "noop", "process", parameters,
+                                 this);
+    if (workload == "bench-echo") {
+        parameters.insert("Payload", QByteArray(m_payloadSize, 'x'));
+        return new ProcessClient(m_recorder, m_iterations,
+                                 "bench", "echo", "process", parameters,
+                                 this);
+    }
+    if (workload == "bench-status") {
+        parameters.insert("StatusCount", m_signalCount);
+        return new ProcessClient(m_recorder, m_iterations,
+                                 "bench", "noop", "process", parameters,
+                                 this);
+    }
+    if (workload == "bench-store") {
+        parameters.insert("StoreSize", m_payloadSize);
+        return new ProcessClient(m_recorder, m_iterations,
+                                 "bench", "noop", "process", parameters,
+                                 this);
+    }
+    return 0;
+}
+
+void Benchmark::start()
+{
+    if (m_current >= m_workloads.count()) {
+        writeResults();
+        QCoreApplication::quit();
+        return;
+    }
+
+    startWorkload();
+}
+
+void Benchmark::startWorkload()
+{
+    const QString &workload = m_workloads[m_current];
+    qDebug() << "Running workload" << workload;
+
+    m_recorder = new LatencyRecorder;
+    for (int i = 0; i < m_concurrency; i++) {
+        BenchmarkClient *client = createClient(workload);
+        if (client == 0) {
+            qWarning() << "Unknown workload" << workload;
+            break;
+        }
+        connect(client, SIGNAL(ready()), this, SLOT(onClientReady()));
+        connect(client, SIGNAL(finished()), this, SLOT(onClientFinished()));
+        m_clients.append(client);
+    }
+
+    if (m_clients.isEmpty()) {
+        delete m_recorder;
+        m_recorder = 0;
+        m_current++;
+        QMetaObject::invokeMethod(this, "start", Qt::QueuedConnection);
+        return;
+    }
+
+    m_pending = m_clients.count();
+    foreach (BenchmarkClient *client, m_clients)
+        client->setUp();
+}
+
+void Benchmark::onClientReady()
+{
+    if (--m_pending > 0) return;
+
+    m_pending = m_clients.count();
+    m_wallTimer.start();
+    foreach (BenchmarkClient *client, m_clients)
+        client->run();
+}
+
+void Benchmark::onClientFinished()
+{
+    if (--m_pending > 0) return;
+
+    qint64 wallUsecs = m_wallTimer.nsecsElapsed() / 1000;
+    QVariantMap workload;
+    workload.insert("wall_ms", wallUsecs / 1000.0);
+    workload.insert("operations", m_recorder->toMap(wallUsecs));
+    m_results.insert(m_workloads[m_current], workload);
+
+    foreach (BenchmarkClient *client, m_clients)
+        client->deleteLater();
+    m_clients.clear();
+    delete m_recorder;
+    m_recorder = 0;
+
+    m_current++;
+    QMetaObject::invokeMethod(this, "start", Qt::QueuedConnection);
+}
+
+void Benchmark::writeResults()
+{
+    QVariantMap parameters;
+    parameters.insert("concurrency", m_concurrency);
+    parameters.insert("iterations", m_iterations);
+    parameters.insert("identities", m_identityCount);
+    parameters.insert("payload_size", m_payloadSize);
+    parameters.insert("signals", m_signalCount);
+
+    QVariantMap results;
+    results.insert("parameters", parameters);
+    results.insert("workloads", m_results);
+
+    QFile file;
+    if (m_outputFile.isEmpty()) {
+        file.open(stdout, QIODevice::WriteOnly);
+    } else {
+        file.setFileName(m_outputFile);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            qWarning() << "Cannot write" << m_outputFile;
+            return;
+        }
+    }
+
+    QTextStream out(&file);
+    out << toJson(results) << "\n";
+}
+
+static void usage()
+{
+    QTextStream err(stderr);
+    err << "Usage: signon-benchmark [--workloads name,...] "
+        "[--concurrency N] [--iterations N] [--identities N] "
+        "[--payload bytes] [--signals N] [--output file]\n"
+        "Workloads: " << Benchmark::availableWorkloads().join(", ") << "\n"
+        "The iterations are run by each of the concurrent clients.\n";
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+
+    QStringList workloads = Benchmark::availableWorkloads();
+    int concurrency = 4;
+    int iterations = 20;
+    int identityCount = 100;
+    int payloadSize = 1024;
+    int signalCount = 10;
+    QString outputFile;
+
+    QStringList args = QCoreApplication::arguments();
+    for (int i = 1; i < args.count(); i++) {
+        if (i + 1 >= args.count()) {
+            usage();
+            return 1;
+        }
+
+        if (args[i] == "--workloads") {
+            workloads = args[++i].split(',', QString::SkipEmptyParts);
+        } else if (args[i] == "--concurrency") {
+            concurrency = args[++i].toInt();
+        } else if (args[i] == "--iterations") {
+            iterations = args[++i].toInt();
+        } else if (args[i] == "--identities") {
+            identityCount = args[++i].toInt();
+        } else if (args[i] == "--payload") {
+            payloadSize = args[++i].toInt();
+        } else if (args[i] == "--signals") {
+            signalCount = args[++i].toInt();
+        } else if (args[i] == "--output") {
+            outputFile = args[++i];
+        } else {
+            usage();
+            return 1;
+        }
+    }
+
+    Benchmark benchmark(workloads, concurrency, iterations, identityCount,
+                        payloadSize, signalCount, outputFile);
+    QMetaObject::invokeMethod(&benchmark, "start", Qt::QueuedConnection);
+    return app.exec();
+}
@@ -0,0 +1,224 @@
+/*
+ * This file is part of signon
+ *
+ * Copyright (C) 2013 Canonical Ltd.
+ *
+ * Contact: Alberto Mardegan <alberto.mardegan@canonical.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+#ifndef SIGNON_BENCHMARK_H
+#define SIGNON_BENCHMARK_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QMap>
+#include <QObject>
+#include <QStringList>
+#include <QVariantMap>
+
+#include "SignOn/AuthService"
+#include "SignOn/AuthSession"
+#include "SignOn/Identity"
+
+/*
+ * Latencies of the operations of a workload, in microseconds.
+ */
+class LatencyRecorder
+{
+public:
+    void add(const QString &operation, qint64 usecs);
+    void addError(const QString &operation);
+
+    /* Count, errors, percentiles in milliseconds and throughput of each
+     * operation, given the wall time of the workload */
+    QVariantMap toMap(qint64 wallUsecs) const;
+
+private:
+    QMap<QString, QList<qint64> > m_samples;
+    QMap<QString, int> m_errors;
+};
+
+/*
+ * A client which repeats the operations of a workload; all the clients of a
+ * workload run concurrently.
+ */
+class BenchmarkClient: public QObject
+{
+    Q_OBJECT
+
+public:
+    BenchmarkClient(LatencyRecorder *recorder, int iterations,
+                    QObject *parent = 0);
+    virtual ~BenchmarkClient();
+
+    /* Prepares the data needed by the workload; ready() is emitted when
+     * done */
+    virtual void setUp();
+    void run();
+
+Q_SIGNALS:
+    void ready();
+    void finished();
+
+protected:
+    /* Starts one iteration of the workload */
+    virtual void startIteration() = 0;
+
+    void beginStep(const QString &operation);
+    void endStep(bool ok);
+    void iterationDone();
+
+    /* Creates an identity for the given method, then calls
+     * identityReady() */
+    void createIdentity(const QString &method);
+    virtual void identityReady();
+
+    SignOn::Identity *m_identity;
+
+protected Q_SLOTS:
+    void onCredentialsStored(const quint32 id);
+    void onSetUpError(const SignOn::Error &err);
+
+private Q_SLOTS:
+    void nextIteration();
+
+private:
+    LatencyRecorder *m_recorder;
+    int m_iterations;
+    int m_done;
+    QString m_operation;
+    QElapsedTimer m_timer;
+};
+
+/* Stores, queries and removes an identity */
+class IdentityClient: public BenchmarkClient
+{
+    Q_OBJECT
+
+public:
+    IdentityClient(LatencyRecorder *recorder, int iterations,
+                   QObject *parent = 0);
+
+protected:
+    void startIteration();
+
+private Q_SLOTS:
+    void onStored(const quint32 id);
+    void onInfo(const SignOn::IdentityInfo &info);
+    void onRemoved();
+    void onError(const SignOn::Error &err);
+};
+
+/* Calls process() on the session of a stored identity */
+class ProcessClient: public BenchmarkClient
+{
+    Q_OBJECT
+
+public:
+    ProcessClient(LatencyRecorder *recorder, int iterations,
+                  const QString &method, const QString &mechanism,
+                  const QString &operation,
+                  const QVariantMap &parameters = QVariantMap(),
+                  QObject *parent = 0);
+
+    void setUp();
+
+protected:
+    void startIteration();
+    void identityReady();
+
+private Q_SLOTS:
+    void onResponse(const SignOn::SessionData &data);
+    void onError(const SignOn::Error &err);
+
+private:
+    QString m_method;
+    QString m_mechanism;
+    QString m_operationName;
+    QVariantMap m_parameters;
+    SignOn::AuthSessionP m_session;
+};
+
+/* Stores some identities, then queries all the identities */
+class QueryClient: public BenchmarkClient
+{
+    Q_OBJECT
+
+public:
+    QueryClient(LatencyRecorder *recorder, int iterations,
+                int identityCount, QObject *parent = 0);
+
+    void setUp();
+
+protected:
+    void startIteration();
+    void identityReady();
+
+private Q_SLOTS:
+    void onIdentities(const QList<SignOn::IdentityInfo> &identities);
+    void onError(const SignOn::Error &err);
+
+private:
+    int m_identityCount;
+    QList<SignOn::Identity *> m_identities;
+    SignOn::AuthService *m_service;
+};
+
+/*
+ * Runs the workloads one after the other and prints the results as JSON.
+ */
+class Benchmark: public QObject
+{
+    Q_OBJECT
+
+public:
+    Benchmark(const QStringList &workloads, int concurrency, int iterations,
+              int identityCount, int payloadSize, int signalCount,
+              const QString &outputFile);
+    ~Benchmark();
+
+    static QStringList availableWorkloads();
+
+public Q_SLOTS:
+    void start();
+
+private Q_SLOTS:
+    void onClientReady();
+    void onClientFinished();
+
+private:
+    BenchmarkClient *createClient(const QString &workload);
+    void startWorkload();
+    void writeResults();
+
+private:
+    QStringList m_workloads;
+    int m_concurrency;
+    int m_iterations;
+    int m_identityCount;
+    int m_payloadSize;
+    int m_signalCount;
+    QString m_outputFile;
+    int m_current;
+    QList<BenchmarkClient *> m_clients;
+    int m_pending;
+    LatencyRecorder *m_recorder;
+    QElapsedTimer m_wallTimer;
+    QVariantMap m_results;
+};
+
+#endif // SIGNON_BENCHMARK_H
@@ -0,0 +1,37 @@
+include(../tests.pri)
+
+TEMPLATE = app
+TARGET = signon-benchmark
+
+QT += core dbus
+QT -= gui
+
+greaterThan(QT_MAJOR_VERSION, 4) {
+    LIBS += -lsignon-qt5
+} else {
+    LIBS += -lsignon-qt
+}
+QMAKE_RPATHDIR = $${QMAKE_LIBDIR}
+
+HEADERS = \
+    signon-benchmark.h
+
+SOURCES = \
+    signon-benchmark.cpp
+
+QMAKE_CXXFLAGS += -fno-exceptions \
+    -fno-rtti
+
+# Run with "make benchmark"; set BENCHMARK_ARGS to select the workloads and
+# their parameters (see "signon-benchmark --help"). The plugins used by the
+# workloads are collected in a single directory.
+BENCHMARK_PLUGINS = \
+    $${TOP_BUILD_DIR}/src/plugins/test/libssotestplugin.so \
+    $${TOP_BUILD_DIR}/src/plugins/test/libbenchplugin.so \
+    $${TOP_BUILD_DIR}/src/plugins/password/libpasswordplugin.so \
+    $${TOP_BUILD_DIR}/src/plugins/example/libexampleplugin.so
+benchmark.depends = $$TARGET
+benchmark.commands = \
+    "mkdir -p plugins && ln -sf $$BENCHMARK_PLUGINS plugins/ && " \
+    "SSO_LOGGING_LEVEL=1 SSO_PLUGINS_DIR=$$OUT_PWD/plugins SSO_EXTENSIONS_DIR=$${TOP_BUILD_DIR}/non-existing-dir $$RUN_WITH_SIGNOND ./$$TARGET \$\$BENCHMARK_ARGS"
+QMAKE_EXTRA_TARGETS += benchmark
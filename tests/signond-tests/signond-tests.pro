@@ -3,9 +3,16 @@ CONFIG += ordered
 SUBDIRS = \
     tst_access_control_manager_helper.pro \
     tst_timeouts.pro \
+    tst_session_queue.pro \
     tst_pluginproxy.pro \
     tst_database.pro \
+    tst_metadata_readers.pro \
+    tst_metrics.pro \
+    tst_logging.pro \
     access-control.pro \
+    startup-benchmark.pro \
+    signon-benchmark.pro \
+    metrics-tool.pro \
 
 # Disabled until fixed
 #SUBDIRS += tst_backup.pro
@@ -0,0 +1,148 @@
+/*
+ * This file is part of signon
+ *
+ * Copyright (C) 2013 Canonical Ltd.
+ *
+ * Contact: Alberto Mardegan <alberto.mardegan@canonical.com>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA
+ * 02110-1301 USA
+ */
+
+/*
+ * Measures the latency of the first reply of a D-Bus activated signond.
+ * Each iteration stops the running daemon, then calls a method on the
+ * service and waits for the reply: run it in a private session bus, with
+ * "make benchmark" or through tests/run-with-signond.sh.
+ */
+
+#include <QCoreApplication>
+#include <QDBusConnection>
+#include <QDBusConnectionInterface>
+#include <QDBusMessage>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QTextStream>
+#include <QtAlgorithms>
+
+#include <signal.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "signoncommon.h"
+
+static bool stopDaemon(QDBusConnectionInterface *bus)
+{
+    if (!bus->isServiceRegistered(SIGNOND_SERVICE)) return true;
+
+    uint pid = bus->servicePid(SIGNOND_SERVICE);
+    if (pid == 0 || ::kill(pid, SIGTERM) != 0) return false;
+
+    /* Wait for the process to be gone, so that the next call will start a
+     * new instance */
+    for (int i = 0; i < 500; i++) {
+        if (::kill(pid, 0) != 0 &&
+            !bus->isServiceRegistered(SIGNOND_SERVICE))
+            return true;
+        ::usleep(10000);
+    }
+    return false;
+}
+
+static qint64 percentile(const QList<qint64> &sorted, int percent)
+{
+    int index = (sorted.count() - 1) * percent / 100;
+    return sorted[index];
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+
+    int iterations = 20;
+    QString request("queryMethods");
+
+    QStringList args = QCoreApplication::arguments();
+    for (int i = 1; i < args.count(); i++) {
+        if (args[i] == "--iterations") {
+            iterations = args[++i].toInt();
+        } else if (args[i] == "--request") {
+            request = args[++i];
+        }
+    }
+
+    if (iterations < 1 ||
+        (request != "queryMethods" &&
+         request != "registerNewIdentity")) {
+        out << "Usage: " << args[0] << " [--iterations N]"
+            " [--request queryMethods|registerNewIdentity]\n";
+        return 1;
+    }
+
+    QDBusConnection connection = QDBusConnection::sessionBus();
+    QDBusConnectionInterface *bus = connection.interface();
+    if (!connection.isConnected() || bus == 0) {
+        out << "No session bus\n";
+        return 1;
+    }
+
+    QList<qint64> samples;
+    for (int i = 0; i < iterations; i++) {
+        if (!stopDaemon(bus)) {
+            out << "Could not stop the running signond\n";
+            return 1;
+        }
+
+        QDBusMessage msg =
+            QDBusMessage::createMethodCall(SIGNOND_SERVICE,
+                                           SIGNOND_DAEMON_OBJECTPATH,
+                                           SIGNOND_DAEMON_INTERFACE,
+                                           request);
+        QElapsedTimer timer;
+        timer.start();
+        QDBusMessage reply = connection.call(msg, QDBus::Block, 60000);
+        qint64 latency = timer.nsecsElapsed() / 1000;
+
+        if (reply.type() != QDBusMessage::ReplyMessage) {
+            out << "Call failed: " << reply.errorName() << " " <<
+                reply.errorMessage() << "\n";
+            return 1;
+        }
+        samples.append(latency);
+        out << "run " << i << ": " << latency << " us\n";
+    }
+    stopDaemon(bus);
+
+    /* The first run also creates the DB files, so it's reported apart */
+    qint64 first = samples.takeFirst();
+    out << "request: " << request << "\n";
+    out << "first start: " << first << " us\n";
+    if (samples.isEmpty()) return 0;
+
+    qSort(samples);
+    qint64 total = 0;
+    foreach (qint64 sample, samples)
+        total += sample;
+
+    out << "cold starts: " << samples.count() << "\n";
+    out << "min: " << samples.first() << " us\n";
+    out << "mean: " << total / samples.count() << " us\n";
+    out << "median: " << percentile(samples, 50) << " us\n";
+    out << "p90: " << percentile(samples, 90) << " us\n";
+    out << "p99: " << percentile(samples, 99) << " us\n";
+    out << "max: " << samples.last() << " us\n";
+
+    return 0;
+}
@@ -0,0 +1,19 @@
+include(../tests.pri)
+
+TEMPLATE = app
+TARGET = startup-benchmark
+
+QT += core dbus
+QT -= gui
+
+INCLUDEPATH += \
+    $${TOP_SRC_DIR}/lib/signond
+
+SOURCES = \
+    startup-benchmark.cpp
+
+# Run with "make benchmark"; set SIGNOND_ARGS=--startup-report to also get
+# the timing of the daemon startup phases
+benchmark.depends = $$TARGET
+benchmark.commands = "SSO_PLUGINS_DIR=$${TOP_BUILD_DIR}/src/plugins/test SSO_EXTENSIONS_DIR=$${TOP_BUILD_DIR}/non-existing-dir $$RUN_WITH_SIGNOND ./$$TARGET"
+QMAKE_EXTRA_TARGETS += benchmark
@@ -26,6 +26,7 @@
 #include <QDebug>
 #include <QSignalSpy>
 #include <QTest>
+#include <unistd.h>
 
 #include <SignOn/AbstractAccessControlManager>
 #include "accesscontrolmanagerhelper.h"
@@ -86,6 +87,9 @@ private Q_SLOTS:
     void testOwnership();
     void testIdentityAccess_data();
     void testIdentityAccess();
+    void testDecisionCache();
+    void testDecisionCacheDisconnect();
+    void testPidCache();
 
 public:
     static AccessControlManagerHelperTest *instance() { return m_instance; }
@@ -155,6 +159,10 @@ QStringList CredentialsDB::ownerList(const quint32 identityId)
     Q_UNUSED(identityId);
     return AccessControlManagerHelperTest::instance()->m_dbOwners;
 }
+
+void CredentialsDB::flushSecretsCache()
+{
+}
 // } mock CredentialsDB
 
 // mock CredentialsAccessManager {
@@ -316,5 +324,148 @@ void AccessControlManagerHelperTest::testIdentityAccess()
     QCOMPARE(isAllowed, expectedIsAllowed);
 }
 
+void AccessControlManagerHelperTest::testDecisionCache()
+{
+    /* Only the decisions about unique bus names are cached */
+    QDBusConnection conn = QDBusConnection::sessionBus();
+    QVERIFY(conn.isConnected());
+    QString peer = conn.baseService();
+    QVERIFY(peer.startsWith(':'));
+
+    m_acmPlugin.m_permissions[peer] = QStringList() << "tom";
+    setDbOwners(QStringList() << "tom");
+    setDbAcl(QStringList());
+
+    QDBusMessage msg =
+        QDBusMessage::createMethodCall(peer, "/", "interface", "hi");
+
+    SignonDaemonNS::AccessControlManagerHelper helper(&m_acmPlugin);
+
+    QVERIFY(helper.isPeerAllowedToUseIdentity(conn, msg, 3));
+    QCOMPARE(helper.cacheHits(), quint64(0));
+    quint64 misses = helper.cacheMisses();
+    QVERIFY(misses > 0);
+
+    /* The DB is not queried again */
+    setDbOwners(QStringList() << "bob");
+    QVERIFY(helper.isPeerAllowedToUseIdentity(conn, msg, 3));
+    QCOMPARE(int(helper.isPeerOwnerOfIdentity(conn, msg, 3)),
+             int(AccessControlManagerHelper::ApplicationIsOwner));
+    QCOMPARE(helper.cacheHits(), quint64(2));
+    QCOMPARE(helper.cacheMisses(), misses);
+
+    /* Changes to other identities don't expire the decisions, and neither
+     * do the updates which leave the ACL untouched */
+    QMetaObject::invokeMethod(&m_db, "accessControlChanged",
+                              Q_ARG(quint32, 4));
+    QMetaObject::invokeMethod(&m_db, "credentialsUpdated",
+                              Q_ARG(quint32, 3));
+    QMetaObject::invokeMethod(&m_db, "dataChanged", Q_ARG(quint32, 3));
+    QVERIFY(helper.isPeerAllowedToUseIdentity(conn, msg, 3));
+    QCOMPARE(helper.cacheHits(), quint64(3));
+
+    /* An authentication on identity 4 doesn't expire them either */
+    QVERIFY(!helper.isPeerAllowedToUseIdentity(conn, msg, 4));
+    misses = helper.cacheMisses();
+    QMetaObject::invokeMethod(&m_db, "accessControlChanged",
+                              Q_ARG(quint32, 3));
+    QVERIFY(!helper.isPeerAllowedToUseIdentity(conn, msg, 3));
+    QVERIFY(helper.cacheMisses() > misses);
+    misses = helper.cacheMisses();
+    QVERIFY(!helper.isPeerAllowedToUseIdentity(conn, msg, 4));
+    QCOMPARE(helper.cacheMisses(), misses);
+
+    /* Clearing the DB expires all of them */
+    setDbAcl(QStringList() << "*");
+    QMetaObject::invokeMethod(&m_db, "accessControlChanged",
+                              Q_ARG(quint32, 0));
+    QVERIFY(helper.isPeerAllowedToUseIdentity(conn, msg, 3));
+    QVERIFY(helper.isPeerAllowedToUseIdentity(conn, msg, 4));
+    QVERIFY(helper.cacheMisses() >= misses + 2);
+
+    /* Well-known names are not cached */
+    quint64 hits = helper.cacheHits();
+    QDBusMessage namedMsg =
+        QDBusMessage::createMethodCall("tom", "/", "interface", "hi");
+    helper.isPeerAllowedToUseIdentity(conn, namedMsg, 3);
+    helper.isPeerAllowedToUseIdentity(conn, namedMsg, 3);
+    QCOMPARE(helper.cacheHits(), hits);
+}
+
+void AccessControlManagerHelperTest::testDecisionCacheDisconnect()
+{
+    QDBusConnection conn = QDBusConnection::sessionBus();
+    QDBusConnection peerConn =
+        QDBusConnection::connectToBus(QDBusConnection::SessionBus,
+                                      QLatin1String("acm-helper-peer"));
+    QVERIFY(peerConn.isConnected());
+    QString peer = peerConn.baseService();
+
+    m_acmPlugin.m_permissions[peer] = QStringList() << "tom";
+    setDbOwners(QStringList() << "tom");
+
+    QDBusMessage msg =
+        QDBusMessage::createMethodCall(peer, "/", "interface", "hi");
+
+    SignonDaemonNS::AccessControlManagerHelper helper(&m_acmPlugin);
+
+    QVERIFY(helper.isPeerAllowedToUseIdentity(conn, msg, 3));
+    QVERIFY(helper.isPeerAllowedToUseIdentity(conn, msg, 3));
+    QCOMPARE(helper.cacheHits(), quint64(1));
+
+    /* The decisions are dropped when the peer leaves the bus */
+    QDBusConnection::disconnectFromBus(QLatin1String("acm-helper-peer"));
+    QTest::qWait(500);
+
+    quint64 misses = helper.cacheMisses();
+    QVERIFY(helper.isPeerAllowedToUseIdentity(conn, msg, 3));
+    QCOMPARE(helper.cacheHits(), quint64(1));
+    QVERIFY(helper.cacheMisses() > misses);
+}
+
+void AccessControlManagerHelperTest::testPidCache()
+{
+    QDBusConnection conn = QDBusConnection::sessionBus();
+    QDBusConnection peerConn =
+        QDBusConnection::connectToBus(QDBusConnection::SessionBus,
+                                      QLatin1String("acm-helper-pid-peer"));
+    QVERIFY(peerConn.isConnected());
+
+    QDBusMessage msg =
+        QDBusMessage::createMethodCall(conn.baseService(),
+                                       "/", "interface", "hi");
+    QDBusMessage peerMsg =
+        QDBusMessage::createMethodCall(peerConn.baseService(),
+                                       "/", "interface", "hi");
+
+    SignonDaemonNS::AccessControlManagerHelper helper(&m_acmPlugin);
+    QSignalSpy resolved(&helper, SIGNAL(peerPidResolved(const QString&)));
+
+    /* The lookup runs in the background */
+    helper.prefetchPidOfPeer(conn, msg);
+    QVERIFY(helper.isPidOfPeerPending(msg));
+    for (int i = 0; i < 50 && resolved.count() == 0; i++)
+        QTest::qWait(100);
+    QCOMPARE(resolved.count(), 1);
+    QCOMPARE(resolved.at(0).at(0).toString(), conn.baseService());
+    QVERIFY(!helper.isPidOfPeerPending(msg));
+    QCOMPARE(AccessControlManagerHelper::pidOfPeer(conn, msg), getpid());
+
+    /* Waiting for a pending lookup still emits the signal */
+    helper.prefetchPidOfPeer(conn, peerMsg);
+    QVERIFY(helper.isPidOfPeerPending(peerMsg));
+    QCOMPARE(AccessControlManagerHelper::pidOfPeer(conn, peerMsg), getpid());
+    QVERIFY(!helper.isPidOfPeerPending(peerMsg));
+    QTest::qWait(10);
+    QCOMPARE(resolved.count(), 2);
+    QCOMPARE(resolved.at(1).at(0).toString(), peerConn.baseService());
+
+    /* The PID is forgotten when the peer leaves the bus */
+    QDBusConnection::disconnectFromBus(QLatin1String("acm-helper-pid-peer"));
+    QTest::qWait(500);
+    QCOMPARE(AccessControlManagerHelper::pidOfPeer(conn, peerMsg), 0);
+    QCOMPARE(AccessControlManagerHelper::pidOfPeer(conn, msg), getpid());
+}
+
 QTEST_MAIN(AccessControlManagerHelperTest)
 #include "tst_access_control_manager_helper.moc"
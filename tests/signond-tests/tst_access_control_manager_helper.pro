@@ -4,10 +4,11 @@ include(signond-tests.pri)
 
 SOURCES = \
     $${SIGNOND_SRC}/accesscontrolmanagerhelper.cpp \
+    $${SIGNOND_SRC}/signonmetrics.cpp \
     tst_access_control_manager_helper.cpp
 
 HEADERS = \
     $${SIGNOND_SRC}/accesscontrolmanagerhelper.h \
     $${SIGNOND_SRC}/credentialsdb.h
 
-check.commands = "./$$TARGET"
+check.commands = "$$RUN_WITH_SIGNOND ./$$TARGET"
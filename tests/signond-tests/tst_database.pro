@@ -10,4 +10,5 @@ HEADERS += \
 SOURCES = \
     databasetest.cpp \
     $$TOP_SRC_DIR/src/signond/credentialsdb.cpp \
-    $$TOP_SRC_DIR/src/signond/default-secrets-storage.cpp
+    $$TOP_SRC_DIR/src/signond/default-secrets-storage.cpp \
+    $$TOP_SRC_DIR/src/signond/signonmetrics.cpp
@@ -0,0 +1,11 @@
+TARGET = tst_logging
+
+include(signond-tests.pri)
+
+HEADERS += \
+    loggingtest.h
+
+SOURCES = \
+    loggingtest.cpp
+
+check.commands = "./$$TARGET"
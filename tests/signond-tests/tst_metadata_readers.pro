@@ -0,0 +1,15 @@
+TARGET = tst_metadata_readers
+
+include(signond-tests.pri)
+
+HEADERS += \
+    metadatareaderstest.h \
+    $$TOP_SRC_DIR/src/signond/credentialsdb.h
+
+SOURCES = \
+    metadatareaderstest.cpp \
+    $$TOP_SRC_DIR/src/signond/credentialsdb.cpp \
+    $$TOP_SRC_DIR/src/signond/credentialsdbworker.cpp \
+    $$TOP_SRC_DIR/src/signond/signonmetrics.cpp
+
+check.commands = "./$$TARGET"
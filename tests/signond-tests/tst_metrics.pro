@@ -0,0 +1,15 @@
+TARGET = tst_metrics
+
+include(signond-tests.pri)
+
+HEADERS += \
+    metricstest.h
+
+SOURCES = \
+    metricstest.cpp \
+    $$TOP_SRC_DIR/src/signond/requesttracer.cpp \
+    $$TOP_SRC_DIR/src/signond/signonmetrics.cpp
+
+LIBS += -lrt
+
+check.commands = "./$$TARGET"
@@ -0,0 +1,9 @@
+TARGET = tst_session_queue
+
+include(signond-tests.pri)
+
+HEADERS += \
+    sessionqueuetest.h
+
+SOURCES = \
+    sessionqueuetest.cpp
@@ -7,5 +7,5 @@ SIGNOND="${BUILDDIR}/src/signond/signond"
 
 echo "Starting signond from $SIGNOND"
 
-$WRAPPER $SIGNOND
+$WRAPPER $SIGNOND $SIGNOND_ARGS
 